@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// The inverse of BitReader: packs values LSB first, in the engine's wire
+// encodings. Only used to build synthetic demos.
+class BitWriter {
+public:
+    void write_bit(bool value) { write_bits(value ? 1 : 0, 1); }
+
+    // Low num_bits (0-32) of value.
+    void write_bits(uint32_t value, int num_bits) {
+        uint64_t bits = num_bits == 32 ? value : value & ((uint32_t(1) << num_bits) - 1);
+        while (num_bits > 0) {
+            int offset = static_cast<int>(bit_count % 8);
+            if (offset == 0) {
+                data.push_back(std::byte{ 0 });
+            }
+            int take = std::min(num_bits, 8 - offset);
+            data.back() |= static_cast<std::byte>((bits & ((1u << take) - 1)) << offset);
+            bits >>= take;
+            num_bits -= take;
+            bit_count += take;
+        }
+    }
+
+    void write_uint8(uint8_t value) { write_bits(value, 8); }
+    void write_uint16(uint16_t value) { write_bits(value, 16); }
+    void write_uint32(uint32_t value) { write_bits(value, 32); }
+    void write_int32(int32_t value) { write_bits(static_cast<uint32_t>(value), 32); }
+    void write_float32(float value) { write_bits(std::bit_cast<uint32_t>(value), 32); }
+
+    // NUL terminated, as read_ascii_string expects.
+    void write_string(std::string_view text) {
+        for (char c : text) {
+            write_uint8(static_cast<uint8_t>(c));
+        }
+        write_uint8(0);
+    }
+
+    void write_bytes(std::span<const std::byte> bytes) {
+        for (auto b : bytes) {
+            write_uint8(std::to_integer<uint8_t>(b));
+        }
+    }
+
+    // 7 bits per byte, low groups first, as read_var_int32 expects.
+    void write_var_int32(uint32_t value) {
+        do {
+            uint32_t group = value & 0x7f;
+            value >>= 7;
+            write_uint8(static_cast<uint8_t>(group | (value ? 0x80 : 0)));
+        } while (value);
+    }
+
+    void write_ubit_var(uint32_t value) {
+        if (value < 16) {
+            write_bits(value, 6);
+        }
+        else if (value < 256) {
+            write_bits((value & 15) | 16, 6);
+            write_bits(value >> 4, 4);
+        }
+        else if (value < 4096) {
+            write_bits((value & 15) | 32, 6);
+            write_bits(value >> 4, 8);
+        }
+        else {
+            write_bits((value & 15) | 48, 6);
+            write_bits(value >> 4, 28);
+        }
+    }
+
+    // Integer part below 16384, fraction in 1/32 steps.
+    void write_bit_coord(float value) {
+        bool sign = value < 0;
+        value = std::fabs(value);
+        auto integer = static_cast<uint32_t>(value);
+        auto fraction = static_cast<uint32_t>(std::lround((value - integer) * 32)) & 31;
+        write_bit(integer != 0);
+        write_bit(fraction != 0);
+        if (integer || fraction) {
+            write_bit(sign);
+            if (integer) {
+                write_bits(integer - 1, 14);
+            }
+            if (fraction) {
+                write_bits(fraction, 5);
+            }
+        }
+    }
+
+    void append(const BitWriter& other) {
+        size_t whole = other.bit_count / 8;
+        if (bit_count % 8 == 0) {
+            data.insert(data.end(), other.data.begin(), other.data.begin() + whole);
+            bit_count += whole * 8;
+        }
+        else {
+            for (size_t i = 0; i < whole; i++) {
+                write_uint8(std::to_integer<uint8_t>(other.data[i]));
+            }
+        }
+        if (int rest = static_cast<int>(other.bit_count % 8)) {
+            write_bits(std::to_integer<uint32_t>(other.data[whole]), rest);
+        }
+    }
+
+    size_t bits() const { return bit_count; }
+    // Written bits, the last byte zero padded.
+    const std::vector<std::byte>& bytes() const { return data; }
+
+private:
+    std::vector<std::byte> data;
+    size_t bit_count = 0;
+};
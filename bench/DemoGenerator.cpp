@@ -0,0 +1,900 @@
+#include "DemoGenerator.h"
+#include "BitWriter.h"
+#include "Demo/DataTables.h"
+#include "Demo/Demo.h"
+#include "Demo/DemoMessage.h"
+#include "Demo/Entities.h"
+#include "Demo/NetMessage.h"
+#include "Demo/structs.h"
+#include "Util/math.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+// Width of a net message id in a packet.
+constexpr int NET_MESSAGE_TYPE_BITS = 6;
+
+// Send prop as written in DATA_TABLES.
+struct SendPropSpec {
+    PropType type;
+    std::string name;
+    uint32_t flags = 0;
+    // DATA_TABLE props: the table; excluded props: the excluded table.
+    std::string table = {};
+    float low = 0;
+    float high = 0;
+    int bits = 0;
+    int elements = 0;
+};
+
+SendPropSpec int_prop(std::string name, int bits, uint32_t flags = 0) {
+    return { PropType::INT, std::move(name), flags, {}, 0, 0, bits };
+}
+
+SendPropSpec float_prop(std::string name, int bits, float low, float high, uint32_t flags = 0) {
+    return { PropType::FLOAT, std::move(name), flags, {}, low, high, bits };
+}
+
+SendPropSpec vector_prop(std::string name, uint32_t flags, int bits = 0, float low = 0, float high = 0) {
+    return { PropType::VECTOR, std::move(name), flags, {}, low, high, bits };
+}
+
+SendPropSpec string_prop(std::string name) {
+    return { PropType::STRING, std::move(name) };
+}
+
+SendPropSpec base_class(std::string table) {
+    return { PropType::DATA_TABLE, "baseclass", 0, std::move(table) };
+}
+
+// The element prop comes right before its ARRAY prop.
+void add_array(std::vector<SendPropSpec>& props, std::string name, SendPropSpec element, int elements) {
+    element.name = "000";
+    element.flags |= SPROP_INSIDEARRAY;
+    props.push_back(std::move(element));
+    props.push_back({ PropType::ARRAY, std::move(name), 0, {}, 0, 0, 0, elements });
+}
+
+void add_fillers(std::vector<SendPropSpec>& props, std::string_view prefix, int count, int max_bits) {
+    for (int i = 0; i < count; i++) {
+        props.push_back(int_prop(std::string(prefix) + std::to_string(i), 1 + i % max_bits));
+    }
+}
+
+void write_send_table(BitWriter& writer, std::string_view name, const std::vector<SendPropSpec>& props) {
+    writer.write_bit(true);
+    writer.write_bit(false);
+    writer.write_string(name);
+    writer.write_bits(static_cast<uint32_t>(props.size()), 10);
+    for (const auto& prop : props) {
+        writer.write_bits(static_cast<uint32_t>(prop.type), 5);
+        writer.write_string(prop.name);
+        writer.write_bits(prop.flags, 16);
+        if (prop.type == PropType::DATA_TABLE || (prop.flags & SPROP_EXCLUDE)) {
+            writer.write_string(prop.table);
+        }
+        else if (prop.type == PropType::ARRAY) {
+            writer.write_bits(prop.elements, 10);
+        }
+        else {
+            writer.write_float32(prop.low);
+            writer.write_float32(prop.high);
+            writer.write_bits(prop.bits, 7);
+        }
+    }
+}
+
+// A prop value to encode; which members are used depends on the prop.
+struct Value {
+    std::vector<int32_t> ints;
+    std::vector<float> floats;
+    std::string text;
+};
+
+Value int_value(int32_t value) { return { { value }, {}, {} }; }
+Value float_value(float value) { return { {}, { value }, {} }; }
+Value vector_value(float x, float y, float z) { return { {}, { x, y, z }, {} }; }
+Value text_value(std::string text) { return { {}, {}, std::move(text) }; }
+
+void write_float(BitWriter& writer, const PropDescriptor& prop, float value) {
+    switch (prop.decode) {
+    case PropDecode::FLOAT_COORD:
+        writer.write_bit_coord(value);
+        break;
+    case PropDecode::FLOAT_NOSCALE:
+        writer.write_float32(value);
+        break;
+    default: {
+        uint32_t steps = (uint32_t(1) << prop.num_bits) - 1;
+        float fraction = std::clamp((value - prop.low_value) / (prop.high_value - prop.low_value), 0.0f, 1.0f);
+        writer.write_bits(static_cast<uint32_t>(std::lround(fraction * steps)), prop.num_bits);
+        break;
+    }
+    }
+}
+
+void write_value(BitWriter& writer, const PropDescriptor& prop, const Value& value) {
+    switch (prop.type) {
+    case PropType::INT:
+        writer.write_bits(static_cast<uint32_t>(value.ints[0]), prop.num_bits);
+        break;
+    case PropType::FLOAT:
+        write_float(writer, prop, value.floats[0]);
+        break;
+    case PropType::VECTOR:
+        for (int i = 0; i < 3; i++) {
+            write_float(writer, prop, value.floats[i]);
+        }
+        break;
+    case PropType::STRING:
+        writer.write_bits(static_cast<uint32_t>(value.text.size()), DT_MAX_STRING_BITS);
+        for (char c : value.text) {
+            writer.write_uint8(static_cast<uint8_t>(c));
+        }
+        break;
+    case PropType::ARRAY:
+        if (prop.element_type == PropType::INT) {
+            writer.write_bits(static_cast<uint32_t>(value.ints.size()), prop.count_bits);
+            for (auto element : value.ints) {
+                writer.write_bits(static_cast<uint32_t>(element), prop.num_bits);
+            }
+        }
+        else {
+            writer.write_bits(static_cast<uint32_t>(value.floats.size()), prop.count_bits);
+            for (auto element : value.floats) {
+                write_float(writer, prop, element);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void write_field_delta(BitWriter& writer, uint32_t delta) {
+    if (delta == 0) {
+        writer.write_bit(true);
+        return;
+    }
+    writer.write_bit(false);
+    if (delta < 8) {
+        writer.write_bit(true);
+        writer.write_bits(delta, 3);
+        return;
+    }
+    writer.write_bit(false);
+    if (delta < 32) {
+        writer.write_bits(delta, 7);
+    }
+    else if (delta < 128) {
+        writer.write_bits((delta & 31) | 32, 7);
+        writer.write_bits(delta >> 5, 2);
+    }
+    else if (delta < 512) {
+        writer.write_bits((delta & 31) | 64, 7);
+        writer.write_bits(delta >> 5, 4);
+    }
+    else {
+        writer.write_bits((delta & 31) | 96, 7);
+        writer.write_bits(delta >> 5, 7);
+    }
+}
+
+using PropChanges = std::vector<std::pair<int, Value>>;
+
+// The prop list of an entity update, baseline or temp entity.
+void write_props(BitWriter& writer, const FlatClass& layout, PropChanges changes) {
+    std::sort(changes.begin(), changes.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    writer.write_bit(true);
+    int last = -1;
+    for (const auto& change : changes) {
+        write_field_delta(writer, change.first - last - 1);
+        last = change.first;
+    }
+    // Index delta 4095 ends the list.
+    write_field_delta(writer, 4095);
+    for (const auto& [prop, value] : changes) {
+        write_value(writer, layout.props[prop], value);
+    }
+}
+
+// LZSS as the engine's string table decompressor reads it, with a short
+// window: compression ratio does not matter here, only validity.
+std::vector<std::byte> compress_lzss(const std::vector<std::byte>& input) {
+    constexpr size_t WINDOW = 256;
+    constexpr size_t MAX_MATCH = 16;
+    std::vector<std::byte> output = { std::byte{ 'L' }, std::byte{ 'Z' }, std::byte{ 'S' }, std::byte{ 'S' } };
+    for (int i = 0; i < 4; i++) {
+        output.push_back(static_cast<std::byte>((input.size() >> (8 * i)) & 0xff));
+    }
+    size_t command = 0;
+    int command_bit = 8;
+    auto flag = [&](bool reference) {
+        if (command_bit == 8) {
+            command = output.size();
+            output.push_back(std::byte{ 0 });
+            command_bit = 0;
+        }
+        if (reference) {
+            output[command] |= static_cast<std::byte>(1 << command_bit);
+        }
+        command_bit++;
+    };
+    size_t position = 0;
+    while (position < input.size()) {
+        size_t best_length = 0;
+        size_t best_offset = 0;
+        for (size_t offset = 1; offset <= std::min(position, WINDOW); offset++) {
+            size_t length = 0;
+            while (length < MAX_MATCH && position + length < input.size()
+                && input[position - offset + length] == input[position + length]) {
+                length++;
+            }
+            if (length > best_length) {
+                best_length = length;
+                best_offset = offset;
+            }
+        }
+        if (best_length >= 2) {
+            flag(true);
+            size_t distance = best_offset - 1;
+            output.push_back(static_cast<std::byte>(distance >> 4));
+            output.push_back(static_cast<std::byte>(((distance & 15) << 4) | (best_length - 1)));
+            position += best_length;
+        }
+        else {
+            flag(false);
+            output.push_back(input[position++]);
+        }
+    }
+    // A zero length reference ends the stream.
+    flag(true);
+    output.push_back(std::byte{ 0 });
+    output.push_back(std::byte{ 0 });
+    return output;
+}
+
+struct StringTableEntry {
+    int index;
+    std::string text;
+    std::vector<std::byte> data = {};
+};
+
+void write_string_table_entries(BitWriter& writer, int entry_bits, const std::vector<StringTableEntry>& entries) {
+    int last = -1;
+    for (const auto& entry : entries) {
+        writer.write_bit(entry.index == last + 1);
+        if (entry.index != last + 1) {
+            writer.write_bits(entry.index, entry_bits);
+        }
+        last = entry.index;
+        writer.write_bit(true);
+        // No history reference.
+        writer.write_bit(false);
+        writer.write_string(entry.text);
+        writer.write_bit(!entry.data.empty());
+        if (!entry.data.empty()) {
+            writer.write_bits(static_cast<uint32_t>(entry.data.size()), 14);
+            writer.write_bytes(entry.data);
+        }
+    }
+}
+
+void write_create_string_table(BitWriter& writer, std::string_view name, int max_entries,
+    const std::vector<StringTableEntry>& entries, bool compressed) {
+    BitWriter body;
+    write_string_table_entries(body, Q_log2(max_entries), entries);
+    BitWriter data;
+    if (compressed) {
+        auto packed = compress_lzss(body.bytes());
+        data.write_uint32(static_cast<uint32_t>(body.bytes().size()));
+        data.write_uint32(static_cast<uint32_t>(packed.size()));
+        data.write_bytes(packed);
+    }
+    else {
+        data.append(body);
+    }
+    writer.write_bits(static_cast<uint32_t>(NetMessage::Type::svc_create_string_table), NET_MESSAGE_TYPE_BITS);
+    writer.write_string(name);
+    writer.write_bits(max_entries, 16);
+    writer.write_bits(static_cast<uint32_t>(entries.size()), Q_log2(max_entries) + 1);
+    writer.write_var_int32(static_cast<uint32_t>(data.bits()));
+    // No fixed size user data.
+    writer.write_bit(false);
+    writer.write_bit(compressed);
+    writer.append(data);
+}
+
+enum EventKey : uint32_t { KEY_STRING = 1, KEY_FLOAT, KEY_LONG, KEY_SHORT, KEY_BYTE, KEY_BOOL };
+
+// Game event ids as listed in the sign-on.
+enum EventId : uint32_t { PLAYER_DEATH = 0, WEAPON_FIRE = 1, PLAYER_FOOTSTEP = 2, ROUND_END = 7 };
+
+// User message ids of the default CS:S registry.
+enum UserMessageId : uint32_t { SAY_TEXT2 = 4, TEXT_MSG = 5, DAMAGE = 21, UPDATE_RADAR = 28 };
+
+void write_game_event_list(BitWriter& writer) {
+    struct Event {
+        EventId id;
+        const char* name;
+        std::vector<std::pair<EventKey, const char*>> keys;
+    };
+    const Event events[] = {
+        { PLAYER_DEATH, "player_death", { { KEY_SHORT, "userid" }, { KEY_SHORT, "attacker" }, { KEY_STRING, "weapon" }, { KEY_BOOL, "headshot" } } },
+        { WEAPON_FIRE, "weapon_fire", { { KEY_SHORT, "userid" }, { KEY_STRING, "weapon" }, { KEY_BOOL, "silenced" } } },
+        { PLAYER_FOOTSTEP, "player_footstep", { { KEY_SHORT, "userid" } } },
+        { ROUND_END, "round_end", { { KEY_BYTE, "winner" }, { KEY_BYTE, "reason" }, { KEY_STRING, "message" }, { KEY_FLOAT, "time" }, { KEY_LONG, "score" } } },
+    };
+    BitWriter list;
+    for (const auto& event : events) {
+        list.write_bits(event.id, 9);
+        list.write_string(event.name);
+        for (const auto& [type, key] : event.keys) {
+            list.write_bits(type, 3);
+            list.write_string(key);
+        }
+        list.write_bits(0, 3);
+    }
+    writer.write_bits(static_cast<uint32_t>(NetMessage::Type::svc_game_event_list), NET_MESSAGE_TYPE_BITS);
+    writer.write_bits(static_cast<uint32_t>(std::size(events)), 9);
+    writer.write_bits(static_cast<uint32_t>(list.bits()), 20);
+    writer.append(list);
+}
+
+// Frames are appended to one byte vector, little endian like the file.
+class FrameWriter {
+public:
+    std::vector<std::byte> bytes;
+    size_t frames = 0;
+
+    void put(const void* data, size_t size) {
+        auto begin = static_cast<const std::byte*>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+    void put_int32(int32_t value) { put(&value, sizeof(value)); }
+    void put_float32(float value) { put(&value, sizeof(value)); }
+    void put_uint8(uint8_t value) { put(&value, sizeof(value)); }
+    void put_string(std::string_view text, size_t size) {
+        std::string padded(text);
+        padded.resize(size, '\0');
+        put(padded.data(), size);
+    }
+
+    void begin_frame(DemoMessage::Type type, int tick) {
+        put_uint8(static_cast<uint8_t>(type));
+        put_int32(tick);
+        frames++;
+    }
+
+    void packet(DemoMessage::Type type, int tick, const CmdInfo& info, const BitWriter& payload) {
+        begin_frame(type, tick);
+        put(&info, sizeof(info));
+        put_int32(tick);
+        put_int32(tick);
+        put_int32(static_cast<int32_t>(payload.bytes().size()));
+        put(payload.bytes().data(), payload.bytes().size());
+    }
+
+    void blob(DemoMessage::Type type, int tick, std::span<const std::byte> data) {
+        begin_frame(type, tick);
+        put_int32(static_cast<int32_t>(data.size()));
+        put(data.data(), data.size());
+    }
+};
+
+class Generator {
+public:
+    explicit Generator(const GeneratorOptions& options)
+        : options(options), random(options.seed), players(std::clamp(options.players, 1, 32)) {}
+
+    GeneratedDemo run();
+
+private:
+    struct Player {
+        float x, y, z;
+        float velocity_x, velocity_y;
+        float pitch, yaw;
+        int health;
+    };
+
+    const GeneratorOptions& options;
+    std::mt19937 random;
+    std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+    std::vector<Player> players;
+    DataTables tables;
+    FrameWriter out;
+    size_t net_messages = 0;
+
+    // Class ids, in the order of the class list.
+    enum ClassId { PLAYER, WEAPON, RESOURCE, TEAM, FIRE_BULLETS, EXPLOSION, CLASS_COUNT };
+
+    const FlatClass& layout(ClassId id) const { return tables.flat_classes[id]; }
+    int prop(ClassId id, std::string_view name) const {
+        int index = layout(id).find(name);
+        if (index < 0) {
+            throw std::logic_error("Generator layout has no prop " + std::string(name));
+        }
+        return index;
+    }
+    int first_weapon() const { return static_cast<int>(players.size()) + 1; }
+    int resource_index() const { return 2 * static_cast<int>(players.size()) + 1; }
+
+    void header();
+    std::vector<std::byte> data_tables();
+    void sign_on();
+    void full_update();
+    void tick(int tick);
+    void begin_message(BitWriter& writer, NetMessage::Type type) {
+        writer.write_bits(static_cast<uint32_t>(type), NET_MESSAGE_TYPE_BITS);
+        net_messages++;
+    }
+    // Seven or more bits of zero padding at the end of a payload are read
+    // back as a NetNop.
+    void packet(DemoMessage::Type type, int tick, const CmdInfo& info, const BitWriter& payload) {
+        if (payload.bits() % 8 == 1) {
+            net_messages++;
+        }
+        out.packet(type, tick, info, payload);
+    }
+    void packet_entities(BitWriter& writer, int tick, bool delta, int entries, const BitWriter& data);
+    void create_entity(BitWriter& writer, int& last, int index, ClassId id, PropChanges changes);
+    void update_entity(BitWriter& writer, int& last, int index, ClassId id, PropChanges changes);
+    void game_event(BitWriter& writer, const BitWriter& body);
+    void user_message(BitWriter& writer, UserMessageId id, const BitWriter& body);
+    CmdInfo view(int player) const;
+};
+
+void Generator::header() {
+    out.put_string(DEMO_FILE_STAMP, 8);
+    out.put_int32(DEMO_PROTOCOL);
+    out.put_int32(DEMO_NETWORK_PROTOCOL);
+    out.put_string("synthetic", DEMO_MAXPATH);
+    out.put_string("bench", DEMO_MAXPATH);
+    out.put_string("de_dust2", DEMO_MAXPATH);
+    out.put_string("cstrike", DEMO_MAXPATH);
+    out.put_float32(options.ticks / 64.0f);
+    out.put_int32(options.ticks);
+    out.put_int32(options.ticks);
+    out.put_int32(0);
+}
+
+std::vector<std::byte> Generator::data_tables() {
+    BitWriter writer;
+    std::vector<SendPropSpec> entity = {
+        vector_prop("m_vecOrigin", SPROP_COORD | SPROP_CHANGES_OFTEN),
+        vector_prop("m_angRotation", 0, 13, 0, 360),
+        int_prop("m_nModelIndex", 11, SPROP_UNSIGNED),
+        int_prop("m_iTeamNum", 6),
+        int_prop("m_fEffects", 10, SPROP_UNSIGNED),
+        int_prop("m_clrRender", 32, SPROP_UNSIGNED),
+        int_prop("m_flSimulationTime", 8, SPROP_UNSIGNED | SPROP_CHANGES_OFTEN),
+        int_prop("m_hOwnerEntity", 21, SPROP_UNSIGNED),
+    };
+    add_fillers(entity, "m_entityField", 20, 16);
+    write_send_table(writer, "DT_BaseEntity", entity);
+
+    std::vector<SendPropSpec> player = {
+        base_class("DT_BaseEntity"),
+        int_prop("m_iHealth", 10),
+        int_prop("m_lifeState", 3),
+        int_prop("m_fFlags", 10, SPROP_UNSIGNED | SPROP_CHANGES_OFTEN),
+        float_prop("m_vecVelocity[0]", 20, -2048, 2048, SPROP_CHANGES_OFTEN),
+        float_prop("m_vecVelocity[1]", 20, -2048, 2048, SPROP_CHANGES_OFTEN),
+        float_prop("m_vecVelocity[2]", 20, -2048, 2048, SPROP_CHANGES_OFTEN),
+        int_prop("m_iFOV", 8, SPROP_UNSIGNED),
+        int_prop("m_hActiveWeapon", 21, SPROP_UNSIGNED),
+        string_prop("m_szLastPlaceName"),
+        float_prop("m_flLaggedMovementValue", 32, 0, 0, SPROP_NOSCALE),
+        int_prop("m_nTickBase", 32, SPROP_UNSIGNED | SPROP_CHANGES_OFTEN),
+    };
+    add_array(player, "m_hMyWeapons", int_prop("", 21, SPROP_UNSIGNED), 48);
+    add_array(player, "m_iAmmo", int_prop("", 10, SPROP_UNSIGNED), 32);
+    add_fillers(player, "m_playerField", 40, 20);
+    write_send_table(writer, "DT_BasePlayer", player);
+
+    std::vector<SendPropSpec> cs_player = {
+        base_class("DT_BasePlayer"),
+        float_prop("m_angEyeAngles[0]", 10, -90, 90, SPROP_CHANGES_OFTEN),
+        float_prop("m_angEyeAngles[1]", 11, 0, 360, SPROP_CHANGES_OFTEN),
+        int_prop("m_ArmorValue", 8, SPROP_UNSIGNED),
+        int_prop("m_iAccount", 16, SPROP_UNSIGNED),
+        int_prop("m_bHasHelmet", 1, SPROP_UNSIGNED),
+        float_prop("m_flStamina", 14, 0, 1400),
+        int_prop("m_iShotsFired", 8, SPROP_UNSIGNED),
+    };
+    add_fillers(cs_player, "m_csPlayerField", 30, 12);
+    write_send_table(writer, "DT_CSPlayer", cs_player);
+
+    write_send_table(writer, "DT_WeaponAK47", {
+        base_class("DT_BaseEntity"),
+        int_prop("m_iClip1", 8, SPROP_UNSIGNED),
+        int_prop("m_hOwner", 21, SPROP_UNSIGNED),
+        int_prop("m_iState", 2, SPROP_UNSIGNED),
+        float_prop("m_fAccuracyPenalty", 12, 0, 1),
+    });
+
+    std::vector<SendPropSpec> resource = { base_class("DT_BaseEntity") };
+    for (auto name : { "m_iPing", "m_iKills", "m_iDeaths", "m_iTeam", "m_iHealth", "m_bAlive", "m_bConnected" }) {
+        add_array(resource, name, int_prop("", 10, SPROP_UNSIGNED), 65);
+    }
+    write_send_table(writer, "DT_CSPlayerResource", resource);
+
+    write_send_table(writer, "DT_CSTeam", { int_prop("m_iTeamNum", 6), int_prop("m_iScore", 32), string_prop("m_szTeamname") });
+    write_send_table(writer, "DT_TEFireBullets", {
+        vector_prop("m_vecOrigin", SPROP_COORD),
+        float_prop("m_vecAngles[0]", 10, -90, 90),
+        float_prop("m_vecAngles[1]", 11, 0, 360),
+        int_prop("m_iPlayer", 6, SPROP_UNSIGNED),
+        int_prop("m_iWeaponID", 5, SPROP_UNSIGNED),
+        int_prop("m_iMode", 1, SPROP_UNSIGNED),
+        int_prop("m_iSeed", 8, SPROP_UNSIGNED),
+    });
+    write_send_table(writer, "DT_TEExplosion", { vector_prop("m_vecOrigin", SPROP_COORD), int_prop("m_nMagnitude", 16, SPROP_UNSIGNED), string_prop("m_szSound") });
+    writer.write_bit(false);
+
+    const char* classes[CLASS_COUNT][2] = {
+        { "CCSPlayer", "DT_CSPlayer" }, { "CWeaponAK47", "DT_WeaponAK47" }, { "CCSPlayerResource", "DT_CSPlayerResource" },
+        { "CCSTeam", "DT_CSTeam" }, { "CTEFireBullets", "DT_TEFireBullets" }, { "CTEExplosion", "DT_TEExplosion" },
+    };
+    writer.write_bits(CLASS_COUNT, 16);
+    for (int id = 0; id < CLASS_COUNT; id++) {
+        writer.write_bits(id, 16);
+        writer.write_string(classes[id][0]);
+        writer.write_string(classes[id][1]);
+    }
+    // The parser's own flattening gives the prop numbering updates use.
+    tables = DataTables::parse(writer.bytes());
+    return writer.bytes();
+}
+
+CmdInfo Generator::view(int player) const {
+    const auto& p = players[player];
+    CmdInfo info{};
+    info.view_origin = { p.x, p.y, p.z + 64 };
+    info.view_angles = { p.pitch, p.yaw, 0 };
+    info.local_view_angles = info.view_angles;
+    info.view_origin2 = info.view_origin;
+    info.view_angles2 = info.view_angles;
+    info.local_view_angles2 = info.view_angles;
+    return info;
+}
+
+void Generator::sign_on() {
+    BitWriter payload;
+    net_messages++;
+    write_create_string_table(payload, "modelprecache", 1024,
+        { { 0, "" }, { 1, "maps/de_dust2.bsp" }, { 2, "models/player/ct_urban.mdl" }, { 3, "models/player/t_leet.mdl" } }, false);
+
+    auto baseline = [&](ClassId id, PropChanges changes) {
+        BitWriter writer;
+        write_props(writer, layout(id), std::move(changes));
+        return writer.bytes();
+    };
+    PropChanges player_baseline = { { prop(PLAYER, "m_iHealth"), int_value(100) }, { prop(PLAYER, "m_iFOV"), int_value(90) },
+        { prop(PLAYER, "m_szLastPlaceName"), text_value("Spawn") } };
+    for (int i = 0; i < 30; i++) {
+        player_baseline.emplace_back(prop(PLAYER, "m_csPlayerField" + std::to_string(i)), int_value(1));
+    }
+    net_messages++;
+    write_create_string_table(payload, "instancebaseline", 1024, {
+        { PLAYER, std::to_string(PLAYER), baseline(PLAYER, std::move(player_baseline)) },
+        { WEAPON, std::to_string(WEAPON), baseline(WEAPON, { { prop(WEAPON, "m_iState"), int_value(2) } }) },
+    }, true);
+
+    std::vector<StringTableEntry> users;
+    for (size_t i = 0; i < players.size(); i++) {
+        users.push_back({ static_cast<int>(i), std::to_string(i), std::vector<std::byte>(340, static_cast<std::byte>(i)) });
+    }
+    net_messages++;
+    write_create_string_table(payload, "userinfo", 256, users, false);
+    net_messages++;
+    write_game_event_list(payload);
+    packet(DemoMessage::Type::SIGN_ON, 0, CmdInfo{}, payload);
+}
+
+void Generator::packet_entities(BitWriter& writer, int tick, bool delta, int entries, const BitWriter& data) {
+    begin_message(writer, NetMessage::Type::svc_packet_entities);
+    writer.write_bits(MAX_EDICTS - 1, MAX_EDICT_BITS);
+    writer.write_bit(delta);
+    if (delta) {
+        writer.write_int32(tick - 1);
+    }
+    writer.write_bit(false);
+    writer.write_bits(entries, MAX_EDICT_BITS);
+    writer.write_bits(static_cast<uint32_t>(data.bits()), 20);
+    writer.write_bit(false);
+    writer.append(data);
+}
+
+void Generator::create_entity(BitWriter& writer, int& last, int index, ClassId id, PropChanges changes) {
+    writer.write_ubit_var(index - last - 1);
+    last = index;
+    writer.write_bit(false);
+    writer.write_bit(true);
+    writer.write_bits(id, tables.class_bits);
+    writer.write_bits(index, NUM_NETWORKED_EHANDLE_SERIAL_NUMBER_BITS);
+    write_props(writer, layout(id), std::move(changes));
+}
+
+void Generator::update_entity(BitWriter& writer, int& last, int index, ClassId id, PropChanges changes) {
+    writer.write_ubit_var(index - last - 1);
+    last = index;
+    writer.write_bit(false);
+    writer.write_bit(false);
+    write_props(writer, layout(id), std::move(changes));
+}
+
+void Generator::full_update() {
+    BitWriter data;
+    int last = -1;
+    int entries = 0;
+    for (size_t i = 0; i < players.size(); i++) {
+        const auto& p = players[i];
+        PropChanges changes = {
+            { prop(PLAYER, "m_vecOrigin"), vector_value(p.x, p.y, p.z) },
+            { prop(PLAYER, "m_iHealth"), int_value(p.health) },
+            { prop(PLAYER, "m_iTeamNum"), int_value(2 + static_cast<int>(i % 2)) },
+            { prop(PLAYER, "m_szLastPlaceName"), text_value("BombsiteA") },
+            { prop(PLAYER, "m_flLaggedMovementValue"), float_value(1.0f) },
+            { prop(PLAYER, "m_hActiveWeapon"), int_value(first_weapon() + static_cast<int>(i)) },
+        };
+        Value ammo;
+        ammo.ints.assign(32, 90);
+        changes.emplace_back(prop(PLAYER, "m_iAmmo"), std::move(ammo));
+        Value weapons;
+        weapons.ints = { first_weapon() + static_cast<int>(i), 0, 0 };
+        changes.emplace_back(prop(PLAYER, "m_hMyWeapons"), std::move(weapons));
+        for (int k = 0; k < 40; k++) {
+            changes.emplace_back(prop(PLAYER, "m_playerField" + std::to_string(k)), int_value(k & 1));
+        }
+        create_entity(data, last, static_cast<int>(i) + 1, PLAYER, std::move(changes));
+        entries++;
+    }
+    for (size_t i = 0; i < players.size(); i++) {
+        create_entity(data, last, first_weapon() + static_cast<int>(i), WEAPON,
+            { { prop(WEAPON, "m_iClip1"), int_value(30) }, { prop(WEAPON, "m_hOwner"), int_value(static_cast<int>(i) + 1) } });
+        entries++;
+    }
+    Value connected;
+    connected.ints.assign(65, 0);
+    std::fill_n(connected.ints.begin(), players.size() + 1, 1);
+    create_entity(data, last, resource_index(), RESOURCE, { { prop(RESOURCE, "m_bConnected"), std::move(connected) } });
+    entries++;
+    for (int team = 0; team < 2; team++) {
+        create_entity(data, last, resource_index() + 1 + team, TEAM,
+            { { prop(TEAM, "m_iTeamNum"), int_value(2 + team) }, { prop(TEAM, "m_szTeamname"), text_value(team ? "CT" : "TERRORIST") } });
+        entries++;
+    }
+
+    BitWriter payload;
+    packet_entities(payload, 0, false, entries, data);
+    packet(DemoMessage::Type::PACKET, 0, view(0), payload);
+}
+
+void Generator::game_event(BitWriter& writer, const BitWriter& body) {
+    begin_message(writer, NetMessage::Type::svc_game_event);
+    writer.write_bits(static_cast<uint32_t>(body.bits()), 11);
+    writer.append(body);
+}
+
+void Generator::user_message(BitWriter& writer, UserMessageId id, const BitWriter& body) {
+    begin_message(writer, NetMessage::Type::svc_user_message);
+    writer.write_uint8(static_cast<uint8_t>(id));
+    writer.write_bits(static_cast<uint32_t>(body.bits()), 11);
+    writer.append(body);
+}
+
+void Generator::tick(int tick) {
+    BitWriter payload;
+    begin_message(payload, NetMessage::Type::net_tick);
+    payload.write_int32(tick);
+    payload.write_uint16(static_cast<uint16_t>(0.015625f * NetTick::SCALEUP));
+    payload.write_uint16(static_cast<uint16_t>(unit(random) * 100));
+
+    // Players move every tick; weapons, health and ammo change now and then.
+    BitWriter data;
+    int last = -1;
+    int entries = 0;
+    for (size_t i = 0; i < players.size(); i++) {
+        auto& p = players[i];
+        p.velocity_x = std::clamp(p.velocity_x + (unit(random) - 0.5f) * 40, -250.0f, 250.0f);
+        p.velocity_y = std::clamp(p.velocity_y + (unit(random) - 0.5f) * 40, -250.0f, 250.0f);
+        p.x = std::clamp(p.x + p.velocity_x / 64, -8000.0f, 8000.0f);
+        p.y = std::clamp(p.y + p.velocity_y / 64, -8000.0f, 8000.0f);
+        p.pitch = std::clamp(p.pitch + (unit(random) - 0.5f) * 4, -89.0f, 89.0f);
+        p.yaw = std::fmod(p.yaw + (unit(random) - 0.5f) * 10 + 360, 360.0f);
+        PropChanges changes = {
+            { prop(PLAYER, "m_vecOrigin"), vector_value(p.x, p.y, p.z) },
+            { prop(PLAYER, "m_vecVelocity[0]"), float_value(p.velocity_x) },
+            { prop(PLAYER, "m_vecVelocity[1]"), float_value(p.velocity_y) },
+            { prop(PLAYER, "m_angEyeAngles[0]"), float_value(p.pitch) },
+            { prop(PLAYER, "m_angEyeAngles[1]"), float_value(p.yaw) },
+            { prop(PLAYER, "m_flSimulationTime"), int_value(tick & 255) },
+            { prop(PLAYER, "m_nTickBase"), int_value(tick) },
+        };
+        if (unit(random) < 0.05f) {
+            p.health = std::max(1, p.health - 7);
+            changes.emplace_back(prop(PLAYER, "m_iHealth"), int_value(p.health));
+        }
+        if (unit(random) < 0.1f) {
+            Value ammo;
+            ammo.ints.assign(32, 60);
+            changes.emplace_back(prop(PLAYER, "m_iAmmo"), std::move(ammo));
+            changes.emplace_back(prop(PLAYER, "m_iShotsFired"), int_value(3));
+        }
+        update_entity(data, last, static_cast<int>(i) + 1, PLAYER, std::move(changes));
+        entries++;
+    }
+    for (size_t i = 0; i < players.size(); i++) {
+        if (unit(random) < options.weapon_updates) {
+            update_entity(data, last, first_weapon() + static_cast<int>(i), WEAPON,
+                { { prop(WEAPON, "m_iClip1"), int_value(tick % 30) }, { prop(WEAPON, "m_fAccuracyPenalty"), float_value(unit(random)) } });
+            entries++;
+        }
+    }
+    if (tick % 64 == 0) {
+        Value ping;
+        for (int i = 0; i < 65; i++) {
+            ping.ints.push_back(i <= static_cast<int>(players.size()) ? 30 + (tick / 64 + i) % 40 : 0);
+        }
+        update_entity(data, last, resource_index(), RESOURCE, { { prop(RESOURCE, "m_iPing"), std::move(ping) } });
+        entries++;
+    }
+    // No explicit deletes.
+    data.write_bit(false);
+    packet_entities(payload, tick, true, entries, data);
+
+    int userid = 1 + tick % static_cast<int>(players.size());
+    for (int i = 0; i < options.game_events; i++) {
+        BitWriter body;
+        switch ((tick + i) % 3) {
+        case 0:
+            body.write_bits(WEAPON_FIRE, 9);
+            body.write_uint16(static_cast<uint16_t>(userid));
+            body.write_string(tick % 2 ? "ak47" : "m4a1");
+            body.write_bit(tick % 3 == 0);
+            break;
+        case 1:
+            body.write_bits(PLAYER_FOOTSTEP, 9);
+            body.write_uint16(static_cast<uint16_t>(userid));
+            break;
+        default:
+            body.write_bits(PLAYER_DEATH, 9);
+            body.write_uint16(static_cast<uint16_t>(userid));
+            body.write_uint16(static_cast<uint16_t>(1 + (userid % players.size())));
+            body.write_string("awp");
+            body.write_bit(tick % 2 == 0);
+            break;
+        }
+        game_event(payload, body);
+    }
+    if (tick % 1000 == 0) {
+        BitWriter body;
+        body.write_bits(ROUND_END, 9);
+        body.write_uint8(static_cast<uint8_t>(2 + tick / 1000 % 2));
+        body.write_uint8(7);
+        body.write_string("#Terrorists_Win");
+        body.write_float32(tick / 64.0f);
+        body.write_int32(tick / 1000);
+        game_event(payload, body);
+    }
+
+    for (int i = 0; i < options.user_messages; i++) {
+        BitWriter body;
+        switch ((tick + i) % 4) {
+        case 0:
+            body.write_uint8(static_cast<uint8_t>(userid));
+            body.write_uint8(1);
+            body.write_string("Cstrike_Chat_All");
+            body.write_string("Player" + std::to_string(userid));
+            body.write_string("gg " + std::to_string(tick));
+            user_message(payload, SAY_TEXT2, body);
+            break;
+        case 1:
+            body.write_uint8(4);
+            body.write_string("#Round_Draw");
+            user_message(payload, TEXT_MSG, body);
+            break;
+        case 2:
+            body.write_uint8(5);
+            body.write_uint8(27);
+            body.write_int32(2);
+            body.write_float32(1.5f);
+            body.write_float32(-2.0f);
+            body.write_float32(static_cast<float>(tick));
+            user_message(payload, DAMAGE, body);
+            break;
+        default:
+            for (size_t k = 0; k < players.size(); k++) {
+                body.write_uint32(static_cast<uint32_t>(k));
+            }
+            user_message(payload, UPDATE_RADAR, body);
+            break;
+        }
+    }
+
+    if (options.temp_entities > 0) {
+        // One bullet as a new class, the rest as deltas from it.
+        BitWriter events;
+        int count = std::min(options.temp_entities, 255);
+        for (int k = 0; k < count; k++) {
+            if (k == 0) {
+                events.write_bit(false);
+                events.write_bit(true);
+                events.write_bits(FIRE_BULLETS + 1, tables.class_bits);
+                write_props(events, layout(FIRE_BULLETS), {
+                    { prop(FIRE_BULLETS, "m_vecOrigin"), vector_value(players[0].x, players[0].y, 64) },
+                    { prop(FIRE_BULLETS, "m_iPlayer"), int_value(userid) },
+                    { prop(FIRE_BULLETS, "m_iWeaponID"), int_value(7) },
+                    { prop(FIRE_BULLETS, "m_iSeed"), int_value(tick & 255) },
+                });
+            }
+            else {
+                events.write_bit(true);
+                events.write_bits(k * 10 & 255, 8);
+                events.write_bit(false);
+                write_props(events, layout(FIRE_BULLETS), { { prop(FIRE_BULLETS, "m_iSeed"), int_value((tick + k) & 255) } });
+            }
+        }
+        begin_message(payload, NetMessage::Type::svc_temp_entities);
+        payload.write_bits(count, 8);
+        payload.write_var_int32(static_cast<uint32_t>(events.bits()));
+        payload.append(events);
+    }
+
+    packet(DemoMessage::Type::PACKET, tick, view(0), payload);
+
+    if (options.command_interval > 0 && tick % options.command_interval == 0) {
+        std::string command = "say gg " + std::to_string(tick);
+        out.begin_frame(DemoMessage::Type::CONSOLE_CMD, tick);
+        out.put_int32(static_cast<int32_t>(command.size() + 1));
+        out.put(command.c_str(), command.size() + 1);
+
+        std::vector<std::byte> user_cmd(48, static_cast<std::byte>(tick & 255));
+        out.begin_frame(DemoMessage::Type::USER_CMD, tick);
+        out.put_int32(tick);
+        out.put_int32(static_cast<int32_t>(user_cmd.size()));
+        out.put(user_cmd.data(), user_cmd.size());
+    }
+}
+
+GeneratedDemo Generator::run() {
+    for (auto& p : players) {
+        p = { unit(random) * 4000 - 2000, unit(random) * 4000 - 2000, 0, 0, 0, 0, unit(random) * 360, 100 };
+    }
+
+    header();
+    out.blob(DemoMessage::Type::DATA_TABLES, 0, data_tables());
+    sign_on();
+    out.begin_frame(DemoMessage::Type::SYNC_TICK, 0);
+    full_update();
+    for (int t = 1; t < options.ticks; t++) {
+        tick(t);
+    }
+    out.begin_frame(DemoMessage::Type::STOP, options.ticks);
+
+    GeneratedDemo demo;
+    demo.bytes = std::move(out.bytes);
+    demo.frames = out.frames;
+    demo.net_messages = net_messages;
+    return demo;
+}
+
+}
+
+GeneratedDemo generate_demo(const GeneratorOptions& options) {
+    return Generator(options).run();
+}
+
+void write_demo(const std::string& path, const GeneratedDemo& demo) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(demo.bytes.data()), static_cast<std::streamsize>(demo.bytes.size()));
+    if (!file) {
+        throw std::runtime_error("Error writing demo: " + path);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a synthetic demo contains. The same options and seed always produce
+// the same bytes.
+struct GeneratorOptions {
+    uint32_t seed = 7;
+    // Packets after the sign-on, one per tick at 64 tick.
+    int ticks = 64 * 60 * 5;
+    // 1-32. Each player also owns a weapon entity.
+    int players = 20;
+    // Per tick: svc_game_event messages, svc_user_message messages and
+    // events in the tick's svc_temp_entities (none if 0).
+    int game_events = 2;
+    int user_messages = 1;
+    int temp_entities = 2;
+    // Chance that a weapon gets a delta in a tick.
+    float weapon_updates = 0.2f;
+    // Ticks between CONSOLE_CMD and USER_CMD frames; 0 for none.
+    int command_interval = 32;
+};
+
+struct GeneratedDemo {
+    std::vector<std::byte> bytes;
+    size_t frames = 0;
+    size_t net_messages = 0;
+};
+
+// Builds a protocol 3 / network protocol 24 demo: data tables, a sign-on
+// packet with string tables (one LZSS compressed) and the game event list,
+// a full entity update, then one packet per tick with net_tick, a delta
+// svc_packet_entities, game events, user messages and temp entities, mixed
+// with console and user commands.
+GeneratedDemo generate_demo(const GeneratorOptions& options);
+// Throws std::runtime_error if the file cannot be written.
+void write_demo(const std::string& path, const GeneratedDemo& demo);
@@ -0,0 +1,433 @@
+// Benchmarks the parser on a synthetic demo from DemoGenerator: BitReader
+// primitives, decoding of each net message type on its own, and whole demo
+// loads and streams. Every result is one JSON line on stdout:
+//
+//   {"benchmark":"load/columnar","metric":"mb_per_s","value":412.5}
+//
+// Every metric is a throughput, so higher is better. Each case is timed in
+// --repeat samples of at least 20 ms and the fastest sample counts. With --baseline, results are compared to
+// a file of such lines and the exit code is 1 if any metric fell more than
+// --tolerance (a fraction, default 0.25) below it.
+//
+//   demo_bench [--ticks N] [--repeat N] [--baseline FILE] [--tolerance F]
+//              [--write-baseline FILE] [-h|--help]
+#include "DemoGenerator.h"
+#include "Demo/Demo.h"
+#include "Demo/NetMessageStore.h"
+#include "Util/Arena.h"
+#include "Util/BitReader.h"
+#include "Util/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Result {
+    std::string benchmark;
+    std::string metric;
+    double value;
+};
+
+constexpr const char* USAGE =
+    "Usage: demo_bench [--ticks N] [--repeat N] [--baseline FILE] [--tolerance F] [--write-baseline FILE]\n";
+
+struct Options {
+    GeneratorOptions generator;
+    int repeat = 5;
+    std::string baseline;
+    double tolerance = 0.25;
+    std::string write_baseline;
+    bool help = false;
+};
+
+// Results of the benchmarked code end up here so it cannot be optimized out.
+volatile uint64_t sink;
+
+// A sample runs body often enough to take at least this long, so short
+// cases are not dominated by timer resolution.
+constexpr double MIN_SAMPLE_SECONDS = 0.02;
+
+// Seconds per call of body in the fastest of repeat samples, after one
+// warm-up call.
+template <typename Fn>
+double best_time(int repeat, Fn&& body) {
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    body();
+    double warm_up = std::chrono::duration<double>(clock::now() - start).count();
+    int calls = warm_up > 0 ? static_cast<int>(std::clamp(MIN_SAMPLE_SECONDS / warm_up, 1.0, 1e6)) : 1000;
+
+    double best = 0;
+    for (int i = 0; i < repeat; i++) {
+        start = clock::now();
+        for (int call = 0; call < calls; call++) {
+            body();
+        }
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count() / calls;
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+std::string format_result(const Result& result) {
+    char value[32];
+    std::snprintf(value, sizeof(value), "%.6g", result.value);
+    return "{\"benchmark\":\"" + result.benchmark + "\",\"metric\":\"" + result.metric + "\",\"value\":" + value + "}";
+}
+
+// Reads back what format_result writes; other lines are ignored.
+std::map<std::pair<std::string, std::string>, double> read_baseline(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open baseline: " + path);
+    }
+    auto field = [](const std::string& line, std::string_view key) -> std::string {
+        std::string tag = "\"" + std::string(key) + "\":";
+        auto begin = line.find(tag);
+        if (begin == std::string::npos) {
+            return {};
+        }
+        begin += tag.size();
+        if (line[begin] == '"') {
+            auto end = line.find('"', begin + 1);
+            return line.substr(begin + 1, end - begin - 1);
+        }
+        return line.substr(begin, line.find_first_of(",}", begin) - begin);
+    };
+    std::map<std::pair<std::string, std::string>, double> baseline;
+    std::string line;
+    while (std::getline(file, line)) {
+        auto benchmark = field(line, "benchmark");
+        auto metric = field(line, "metric");
+        auto value = field(line, "value");
+        if (!benchmark.empty() && !metric.empty() && !value.empty()) {
+            baseline[{ benchmark, metric }] = std::strtod(value.c_str(), nullptr);
+        }
+    }
+    return baseline;
+}
+
+class Bench {
+public:
+    explicit Bench(const Options& options) : options(options) {}
+
+    std::vector<Result> results;
+
+    void bit_reader();
+    void net_messages(const std::string& path);
+    void end_to_end(const std::string& path, const GeneratedDemo& generated);
+
+private:
+    const Options& options;
+
+    void add(std::string benchmark, std::string metric, double value) {
+        results.push_back({ std::move(benchmark), std::move(metric), value });
+        std::puts(format_result(results.back()).c_str());
+        std::fflush(stdout);
+    }
+    template <typename Reader = BitReader, typename Fn>
+    void bit_case(const char* name, const std::vector<std::byte>& buffer, Fn&& body);
+};
+
+template <typename Reader, typename Fn>
+void Bench::bit_case(const char* name, const std::vector<std::byte>& buffer, Fn&& body) {
+    size_t bits = 0;
+    double elapsed = best_time(options.repeat, [&]() {
+        uint64_t sum = 0;
+        Reader reader(buffer);
+        bits = body(reader, sum);
+        sink = sum;
+    });
+    add(std::string("bitreader/") + name, "mbit_per_s", bits / elapsed / 1e6);
+}
+
+void Bench::bit_reader() {
+    std::mt19937 random(12345);
+    std::vector<std::byte> buffer(1 << 22);
+    for (auto& b : buffer) {
+        // Keep a sprinkling of zero bytes so string reads terminate.
+        auto value = random() % 64;
+        b = static_cast<std::byte>(value == 0 ? 0 : random());
+    }
+    const int mixed_widths[] = { 1, 3, 5, 7, 8, 11, 13, 16, 20, 32 };
+
+    bit_case("read_bit", buffer, [](BitReader& reader, uint64_t& sum) {
+        size_t bits = 0;
+        while (reader.bits_left() >= 1) {
+            sum += reader.read_bit();
+            ++bits;
+        }
+        return bits;
+    });
+    // Whole rounds of mixed-width fields, the same loop for both readers so
+    // the two cases differ only in per-read checking. The unchecked reader is
+    // tested once at the end, as entity updates are decoded.
+    auto read_mixed = [&](auto& reader, uint64_t& sum) {
+        int round_bits = 0;
+        for (int width : mixed_widths) {
+            round_bits += width;
+        }
+        size_t rounds = reader.bits_left() / round_bits;
+        for (size_t round = 0; round < rounds; round++) {
+            for (int width : mixed_widths) {
+                sum += reader.read_bits(width);
+            }
+        }
+        if (reader.failed()) {
+            throw std::runtime_error("Reader overran");
+        }
+        return rounds * round_bits;
+    };
+    bit_case("read_bits_mixed", buffer, read_mixed);
+    bit_case<UncheckedBitReader>("read_bits_mixed_unchecked", buffer, read_mixed);
+    bit_case("read_uint32", buffer, [](BitReader& reader, uint64_t& sum) {
+        size_t bits = 0;
+        while (reader.bits_left() >= 32) {
+            sum += reader.read_uint32();
+            bits += 32;
+        }
+        return bits;
+    });
+    bit_case("read_bytes_aligned", buffer, [](BitReader& reader, uint64_t& sum) {
+        size_t bits = 0;
+        while (reader.bits_left() >= 256 * 8) {
+            sum += std::to_integer<uint64_t>(reader.read_bytes(256).back());
+            bits += 256 * 8;
+        }
+        return bits;
+    });
+    bit_case("read_many_bits_unaligned", buffer, [](BitReader& reader, uint64_t& sum) {
+        size_t bits = 0;
+        while (reader.bits_left() >= 2051) {
+            sum += reader.read_bits(3);
+            sum += std::to_integer<uint64_t>(reader.read_many_bits(2048).back());
+            bits += 2051;
+        }
+        return bits;
+    });
+    bit_case("read_ascii_string", buffer, [](BitReader& reader, uint64_t& sum) {
+        size_t bits = 0;
+        while (reader.bits_left() >= 4096) {
+            int before = reader.tell();
+            sum += reader.read_ascii_string(256).size();
+            bits += reader.tell() - before;
+        }
+        return bits;
+    });
+}
+
+// Times NetMessage::parse alone for every message of one type at a time,
+// using the positions a lazy load records.
+void Bench::net_messages(const std::string& path) {
+    Demo demo;
+    demo.net_storage = Demo::NetStorage::LAZY;
+    demo.load(path);
+
+    struct Location {
+        const Packet* packet;
+        uint32_t bit_offset;
+        uint32_t bit_length;
+    };
+    std::array<std::vector<Location>, NET_MESSAGE_ID_COUNT> by_type;
+    for (const auto& message : demo.messages) {
+        if (message->type != DemoMessage::Type::PACKET && message->type != DemoMessage::Type::SIGN_ON) {
+            continue;
+        }
+        const auto& packet = static_cast<const Packet&>(*message);
+        for (const auto& entry : packet.net_index) {
+            // Padding at the end of a payload.
+            if (entry.type == NetMessage::Type::net_nop) {
+                continue;
+            }
+            by_type[static_cast<size_t>(entry.type)].push_back({ &packet, entry.bit_offset, entry.bit_length });
+        }
+    }
+
+    Arena arena;
+    for (size_t type = 0; type < NET_MESSAGE_ID_COUNT; type++) {
+        const auto& locations = by_type[type];
+        if (locations.empty()) {
+            continue;
+        }
+        uint64_t bits = 0;
+        for (const auto& location : locations) {
+            bits += location.bit_length;
+        }
+        double elapsed = best_time(options.repeat, [&]() {
+            for (const auto& location : locations) {
+                auto reader = location.packet->payload();
+                reader.seek(location.bit_offset);
+                auto message = net_message_factories[type](arena.memory());
+                message->parse(reader);
+            }
+            arena.release();
+        });
+        std::string name = "decode/" + std::string(net_message_name(static_cast<NetMessage::Type>(type)));
+        add(name, "messages_per_s", locations.size() / elapsed);
+        add(name, "mbit_per_s", bits / elapsed / 1e6);
+    }
+}
+
+// Counts what a stream hands out, to check the generated demo parsed in full.
+class CountingVisitor : public DemoVisitor {
+public:
+    size_t frames = 0;
+    size_t net_messages = 0;
+
+    VisitResult on_message(const DemoMessage& /*message*/) override {
+        frames++;
+        return VisitResult::CONTINUE;
+    }
+    VisitResult on_net_message(const Packet& /*packet*/, const NetMessage& /*message*/) override {
+        net_messages++;
+        return VisitResult::CONTINUE;
+    }
+};
+
+void Bench::end_to_end(const std::string& path, const GeneratedDemo& generated) {
+    double megabytes = generated.bytes.size() / 1e6;
+    auto report = [&](const std::string& name, double elapsed) {
+        add(name, "mb_per_s", megabytes / elapsed);
+        add(name, "frames_per_s", generated.frames / elapsed);
+    };
+    auto load = [&](const std::string& name, auto configure) {
+        double elapsed = best_time(options.repeat, [&]() {
+            std::ostringstream log;
+            Demo demo;
+            demo.log = &log;
+            configure(demo);
+            demo.load(path);
+            if (demo.messages.size() != generated.frames || !log.str().empty()) {
+                throw std::runtime_error(name + ": generated demo did not load cleanly: " + log.str());
+            }
+        });
+        report(name, elapsed);
+    };
+
+    load("load/polymorphic", [](Demo& demo) { demo.net_storage = Demo::NetStorage::POLYMORPHIC; });
+    load("load/columnar", [](Demo& demo) { demo.net_storage = Demo::NetStorage::COLUMNAR; });
+    load("load/lazy", [](Demo& demo) { demo.net_storage = Demo::NetStorage::LAZY; });
+    ThreadPool pool;
+    load("load/columnar_parallel", [&](Demo& demo) {
+        demo.net_storage = Demo::NetStorage::COLUMNAR;
+        demo.pool = &pool;
+    });
+    load("load/entities", [](Demo& demo) {
+        demo.net_storage = Demo::NetStorage::COLUMNAR;
+        demo.track_entities = true;
+        demo.track_temp_entities = true;
+    });
+
+    double elapsed = best_time(options.repeat, [&]() {
+        std::ostringstream log;
+        CountingVisitor visitor;
+        Demo demo;
+        demo.log = &log;
+        demo.parse_stream(path, visitor);
+        if (visitor.frames != generated.frames || visitor.net_messages != generated.net_messages || !log.str().empty()) {
+            throw std::runtime_error("stream: generated demo did not parse cleanly: " + log.str());
+        }
+    });
+    report("stream", elapsed);
+}
+
+Options parse_options(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            options.help = true;
+            return options;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + std::string(arg));
+        }
+        std::string value = argv[++i];
+        if (arg == "--ticks") options.generator.ticks = std::stoi(value);
+        else if (arg == "--repeat") options.repeat = std::max(1, std::stoi(value));
+        else if (arg == "--baseline") options.baseline = value;
+        else if (arg == "--tolerance") options.tolerance = std::stod(value);
+        else if (arg == "--write-baseline") options.write_baseline = value;
+        else throw std::invalid_argument("Unknown option " + std::string(arg));
+    }
+    return options;
+}
+
+// Returns how many metrics regressed.
+int compare(const std::vector<Result>& results, const std::string& path, double tolerance) {
+    auto baseline = read_baseline(path);
+    int regressions = 0;
+    for (const auto& result : results) {
+        auto found = baseline.find({ result.benchmark, result.metric });
+        if (found == baseline.end()) {
+            std::fprintf(stderr, "%-36s %-15s no baseline\n", result.benchmark.c_str(), result.metric.c_str());
+            continue;
+        }
+        double change = found->second > 0 ? result.value / found->second - 1 : 0;
+        bool regressed = change < -tolerance;
+        regressions += regressed;
+        std::fprintf(stderr, "%-36s %-15s %12.1f  baseline %12.1f  %+6.1f%%%s\n", result.benchmark.c_str(),
+            result.metric.c_str(), result.value, found->second, change * 100, regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        auto options = parse_options(argc, argv);
+        if (options.help) {
+            std::fputs(USAGE, stdout);
+            return 0;
+        }
+        auto generated = generate_demo(options.generator);
+        auto path = (std::filesystem::temp_directory_path() / "demo_bench.dem").string();
+        write_demo(path, generated);
+        std::fprintf(stderr, "Synthetic demo: %zu bytes, %zu frames, %zu net messages\n",
+            generated.bytes.size(), generated.frames, generated.net_messages);
+
+        Bench bench(options);
+        bench.bit_reader();
+        bench.net_messages(path);
+        bench.end_to_end(path, generated);
+        std::filesystem::remove(path);
+
+        if (!options.write_baseline.empty()) {
+            std::ofstream file(options.write_baseline);
+            for (const auto& result : bench.results) {
+                file << format_result(result) << '\n';
+            }
+            if (!file) {
+                throw std::runtime_error("Error writing baseline: " + options.write_baseline);
+            }
+        }
+        if (!options.baseline.empty()) {
+            int regressions = compare(bench.results, options.baseline, options.tolerance);
+            if (regressions > 0) {
+                std::fprintf(stderr, "%d metric(s) regressed by more than %.0f%%\n", regressions, options.tolerance * 100);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "demo_bench: %s\n%s", e.what(), USAGE);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+// Writes a deterministic synthetic demo, for benchmarks and for trying the
+// parser without a real recording.
+//
+//   demo_gen <out.dem> [--ticks N] [--players N] [--seed N] [--game-events N]
+//            [--user-messages N] [--temp-entities N] [--command-interval N]
+//   demo_gen -h|--help
+#include "DemoGenerator.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+constexpr const char* USAGE = "Usage: demo_gen <out.dem> [--ticks N] [--players N] [--seed N] [--game-events N] "
+    "[--user-messages N] [--temp-entities N] [--command-interval N]\n";
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            std::fputs(USAGE, stdout);
+            return 0;
+        }
+    }
+    // The output path comes first; an option there is a mistake, not a file name.
+    if (argc < 2 || std::string_view(argv[1]).starts_with("-")) {
+        std::fputs(USAGE, stderr);
+        return 1;
+    }
+    try {
+        GeneratorOptions options;
+        for (int i = 2; i < argc; i++) {
+            std::string_view arg = argv[i];
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + std::string(arg));
+            }
+            int value = std::stoi(argv[++i]);
+            if (arg == "--ticks") options.ticks = value;
+            else if (arg == "--players") options.players = value;
+            else if (arg == "--seed") options.seed = static_cast<uint32_t>(value);
+            else if (arg == "--game-events") options.game_events = value;
+            else if (arg == "--user-messages") options.user_messages = value;
+            else if (arg == "--temp-entities") options.temp_entities = value;
+            else if (arg == "--command-interval") options.command_interval = value;
+            else throw std::invalid_argument("Unknown option " + std::string(arg));
+        }
+        auto demo = generate_demo(options);
+        write_demo(argv[1], demo);
+        std::printf("%s: %zu bytes, %zu frames, %zu net messages\n", argv[1], demo.bytes.size(), demo.frames, demo.net_messages);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "demo_gen: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+#include "Batch.h"
+#include "Demo/Demo.h"
+#include "Demo/ParseStats.h"
+#include "Dumper.h"
+#include "Util/ByteBudget.h"
+#include "Util/ThreadPool.h"
+#include "Util/Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Peak memory of a loaded demo (mapping, arena, messages) is about three
+// times its file size.
+constexpr size_t DEMO_MEMORY_FACTOR = 3;
+
+std::string demo_path_to_dump_path(std::string demo_path) {
+    size_t last_period_pos = demo_path.find_last_of('.');
+    if (last_period_pos != std::string::npos && last_period_pos != 0) {
+        demo_path = demo_path.substr(0, last_period_pos);
+    }
+    demo_path += "_dump.txt";
+    return demo_path;
+}
+
+std::string dump_path_to_log_path(const std::string& dump_path) {
+    fs::path path(dump_path);
+    return (path.parent_path() / ("log_" + path.filename().string())).string();
+}
+
+bool wildcard_match(const char* pattern, const char* name) {
+    if (*pattern == '\0') {
+        return *name == '\0';
+    }
+    if (*pattern == '*') {
+        return wildcard_match(pattern + 1, name) || (*name != '\0' && wildcard_match(pattern, name + 1));
+    }
+    if (*name == '\0') {
+        return false;
+    }
+    return (*pattern == '?' || *pattern == *name) && wildcard_match(pattern + 1, name + 1);
+}
+
+bool is_demo_file(const fs::directory_entry& entry) {
+    return entry.is_regular_file() && entry.path().extension() == ".dem";
+}
+
+void expand_input(const std::string& input, std::vector<std::string>& demo_paths) {
+    if (input.empty()) {
+        throw std::runtime_error("Empty demo path");
+    }
+    if (input.size() > 1 && input.front() == '@') {
+        std::ifstream list(input.substr(1));
+        if (!list) {
+            throw std::runtime_error("Error opening list file: " + input.substr(1));
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                expand_input(line, demo_paths);
+            }
+        }
+        return;
+    }
+
+    std::error_code error;
+    if (fs::is_directory(input, error)) {
+        std::vector<std::string> found;
+        for (const auto& entry : fs::recursive_directory_iterator(input, fs::directory_options::skip_permission_denied)) {
+            if (is_demo_file(entry)) {
+                found.push_back(entry.path().string());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        demo_paths.insert(demo_paths.end(), found.begin(), found.end());
+        return;
+    }
+
+    fs::path path(input);
+    auto pattern = path.filename().string();
+    if (pattern.find_first_of("*?") != std::string::npos) {
+        auto directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+        std::vector<std::string> found;
+        for (const auto& entry : fs::directory_iterator(directory, error)) {
+            if (entry.is_regular_file() && wildcard_match(pattern.c_str(), entry.path().filename().string().c_str())) {
+                found.push_back(path.has_parent_path() ? entry.path().string() : entry.path().filename().string());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        demo_paths.insert(demo_paths.end(), found.begin(), found.end());
+        return;
+    }
+
+    demo_paths.push_back(input);
+}
+
+}
+
+DemoJobResult dump_demo(const std::string& demo_path, bool verbose, ThreadPool* pool, ParseStats* stats) {
+    DemoJobResult result;
+    result.demo_path = demo_path;
+    auto start = std::chrono::steady_clock::now();
+
+    auto dump_path = demo_path_to_dump_path(demo_path);
+    std::ofstream log(dump_path_to_log_path(dump_path));
+    // Verbose mode traces every decoded message into the log file.
+    StreamTraceSink trace_sink(log);
+
+    try {
+        Demo demo;
+        demo.log = &log;
+        demo.pool = pool;
+        demo.stats = stats;
+        if (verbose) {
+            demo.trace = &trace_sink;
+        }
+        demo.load(demo_path);
+        result.bytes = demo.file.size();
+        result.messages = demo.messages.size();
+        result.decode_errors = demo.decode_errors.size();
+
+        // A lone demo has the machine to itself, so its dump is written on a
+        // thread of its own while the next block is formatted.
+        Dumper dumper(demo);
+        dumper.open(dump_path, pool != nullptr);
+        dumper.dump_header();
+        dumper.dump_messages();
+        dumper.close();
+
+        log << "Successfully dumped to: " << dump_path << std::endl;
+        result.ok = true;
+    }
+    catch (const std::exception& e) {
+        result.error = e.what();
+        log << "Failed to parse demo file: " << e.what() << std::endl;
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<std::string> expand_demo_inputs(const std::vector<std::string>& inputs) {
+    std::vector<std::string> demo_paths;
+    for (const auto& input : inputs) {
+        expand_input(input, demo_paths);
+    }
+    return demo_paths;
+}
+
+size_t run_batch(const std::vector<std::string>& demo_paths, const BatchOptions& options, std::ostream& out) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<size_t> sizes(demo_paths.size());
+    for (size_t i = 0; i < demo_paths.size(); i++) {
+        std::error_code error;
+        auto size = fs::file_size(demo_paths[i], error);
+        sizes[i] = error ? 0 : static_cast<size_t>(size);
+    }
+    // Largest demos first, so a long one does not end up running alone at the end.
+    std::vector<size_t> order(demo_paths.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    std::vector<DemoJobResult> results(demo_paths.size());
+    std::mutex stats_mutex;
+    {
+        ThreadPool pool(options.threads);
+        ByteBudget budget(options.memory_budget);
+        for (auto i : order) {
+            auto charge = budget.acquire(sizes[i] * DEMO_MEMORY_FACTOR);
+            pool.submit([&, i, charge] {
+                if (options.stats) {
+                    // Counted apart from the other jobs, added up when done.
+                    auto stats = std::make_unique<ParseStats>();
+                    results[i] = dump_demo(demo_paths[i], options.verbose, nullptr, stats.get());
+                    std::lock_guard lock(stats_mutex);
+                    options.stats->merge(*stats);
+                }
+                else {
+                    results[i] = dump_demo(demo_paths[i], options.verbose);
+                }
+                budget.release(charge);
+            });
+        }
+        pool.wait();
+    }
+
+    size_t failed = 0;
+    size_t damaged = 0;
+    size_t bytes = 0;
+    size_t messages = 0;
+    for (const auto& result : results) {
+        failed += result.ok ? 0 : 1;
+        damaged += result.ok && result.decode_errors > 0 ? 1 : 0;
+        bytes += result.bytes;
+        messages += result.messages;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    out << "Processed " << results.size() << " demos: " << results.size() - failed << " ok (" << damaged
+        << " with decode errors), " << failed << " failed.\n"
+        << std::fixed << std::setprecision(2)
+        << "Parsed " << bytes / (1024.0 * 1024.0) << " MiB, " << messages << " messages in " << seconds << " s ("
+        << bytes / (1024.0 * 1024.0) / std::max(seconds, 1e-9) << " MiB/s).\n";
+    for (const auto& result : results) {
+        if (!result.ok) {
+            out << "  FAILED " << result.demo_path << ": " << result.error << '\n';
+        }
+        else if (result.decode_errors > 0) {
+            out << "  DAMAGED " << result.demo_path << ": " << result.decode_errors << " decode errors, see its log\n";
+        }
+    }
+    out.flush();
+    return failed;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Outcome of dumping one demo.
+struct DemoJobResult {
+    std::string demo_path;
+    bool ok = false;
+    std::string error;
+    // Frames and net messages that failed to decode (see Demo::decode_errors);
+    // the demo is still ok if the rest of it could be dumped.
+    size_t decode_errors = 0;
+    size_t bytes = 0;
+    size_t messages = 0;
+    double seconds = 0;
+};
+
+class ParseStats;
+class ThreadPool;
+
+// Parses one demo and writes its dump and log ("<name>_dump.txt" and
+// "log_<name>_dump.txt") next to it. Everything the parse reports goes to
+// that log, never to the process-wide streams. With a pool the demo's packets
+// are decoded on it in parallel (see Demo::pool). With stats, the parse is
+// counted into them (see Demo::stats). Does not throw; failures are returned
+// in the result.
+DemoJobResult dump_demo(const std::string& demo_path, bool verbose, ThreadPool* pool = nullptr, ParseStats* stats = nullptr);
+
+struct BatchOptions {
+    // Worker threads; 0 means one per hardware thread.
+    size_t threads = 0;
+    // Upper bound on the memory of demos being parsed at once.
+    size_t memory_budget = size_t(2) << 30;
+    bool verbose = false;
+    // When set, receives the parse stats of every demo. Each job counts into
+    // its own and adds them in once its demo is done.
+    ParseStats* stats = nullptr;
+};
+
+// Turns command line inputs into demo paths: directories contribute every
+// .dem file below them, "*" and "?" in the file name part are matched against
+// the files of that directory, and "@file" reads more inputs from file, one
+// per line. Anything else is taken as a demo path.
+std::vector<std::string> expand_demo_inputs(const std::vector<std::string>& inputs);
+
+// Dumps every demo on a thread pool and writes a summary to out, listing the
+// demos that failed or had decode errors. One demo failing does not stop the
+// others. Returns the number of failed demos.
+size_t run_batch(const std::vector<std::string>& demo_paths, const BatchOptions& options, std::ostream& out);
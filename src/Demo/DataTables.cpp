@@ -0,0 +1,299 @@
+#include "Demo/DataTables.h"
+#include "Util/Hash.h"
+#include "Util/math.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+constexpr int PROPINFOBITS_NUMPROPS = 10;
+constexpr int PROPINFOBITS_TYPE = 5;
+constexpr int PROPINFOBITS_NUMELEMENTS = 10;
+constexpr int PROPINFOBITS_NUMBITS = 7;
+constexpr int NAME_LIMIT = 256;
+
+// A prop picked for a flattened class, before it is turned into a descriptor.
+struct GatheredProp {
+    const SendProp* prop;
+    // Element template of ARRAY props: the prop declared right before them.
+    const SendProp* element;
+    const SendTable* owner;
+};
+
+PropDecode resolve_decode(PropType type, uint32_t flags) {
+    switch (type) {
+    case PropType::INT:
+        return (flags & SPROP_UNSIGNED) ? PropDecode::UINT : PropDecode::INT;
+    case PropType::STRING:
+        return PropDecode::STRING;
+    default:
+        break;
+    }
+    // Same precedence as the engine's float decoder.
+    if (flags & SPROP_COORD) {
+        return PropDecode::FLOAT_COORD;
+    }
+    if (flags & SPROP_COORD_MP) {
+        return PropDecode::FLOAT_COORD_MP;
+    }
+    if (flags & SPROP_COORD_MP_LOWPRECISION) {
+        return PropDecode::FLOAT_COORD_MP_LOWPRECISION;
+    }
+    if (flags & SPROP_COORD_MP_INTEGRAL) {
+        return PropDecode::FLOAT_COORD_MP_INTEGRAL;
+    }
+    if (flags & SPROP_NOSCALE) {
+        return PropDecode::FLOAT_NOSCALE;
+    }
+    if (flags & SPROP_NORMAL) {
+        return PropDecode::FLOAT_NORMAL;
+    }
+    return PropDecode::FLOAT_SCALED;
+}
+
+PropDescriptor make_descriptor(const GatheredProp& gathered) {
+    const SendProp& prop = *gathered.prop;
+    // Arrays are described by their element, plus the element count.
+    const SendProp& value = gathered.element ? *gathered.element : prop;
+
+    PropDescriptor descriptor{};
+    descriptor.type = prop.type;
+    descriptor.element_type = value.type;
+    descriptor.decode = resolve_decode(value.type, value.flags);
+    descriptor.num_bits = static_cast<uint8_t>(value.num_bits);
+    descriptor.flags = static_cast<uint16_t>(value.flags);
+    descriptor.low_value = value.low_value;
+    descriptor.high_value = value.high_value;
+    if (prop.type == PropType::ARRAY) {
+        descriptor.num_elements = static_cast<uint16_t>(prop.num_elements);
+        descriptor.count_bits = static_cast<uint8_t>(Q_log2(prop.num_elements) + 1);
+    }
+    return descriptor;
+}
+
+class Flattener {
+    const DataTables& data_tables;
+    std::vector<const SendProp*> excludes;
+    // Tables being walked, outermost first. A table that includes one of
+    // them would recurse forever, so it is rejected.
+    std::vector<const SendTable*> path;
+
+    const SendTable& sub_table(const SendProp& prop) const {
+        const SendTable* table = data_tables.find_table(prop.table_name);
+        if (!table) {
+            throw std::runtime_error("Unknown send table: " + prop.table_name);
+        }
+        if (std::find(path.begin(), path.end(), table) != path.end()) {
+            throw std::runtime_error("Send table includes itself: " + prop.table_name);
+        }
+        return *table;
+    }
+
+    void gather_excludes(const SendTable& table) {
+        path.push_back(&table);
+        for (const auto& prop : table.props) {
+            if (prop.flags & SPROP_EXCLUDE) {
+                excludes.push_back(&prop);
+            }
+            else if (prop.type == PropType::DATA_TABLE) {
+                gather_excludes(sub_table(prop));
+            }
+        }
+        path.pop_back();
+    }
+
+    bool is_excluded(const SendTable& table, const SendProp& prop) const {
+        return std::any_of(excludes.begin(), excludes.end(), [&](const SendProp* exclude) {
+            return exclude->table_name == table.name && exclude->name == prop.name;
+        });
+    }
+
+    // Props of collapsible tables stay in line with the table including them;
+    // any other included table, such as the base class, goes to out first.
+    void iterate_props(const SendTable& table, std::vector<GatheredProp>& own, std::vector<GatheredProp>& out) {
+        path.push_back(&table);
+        for (size_t i = 0; i < table.props.size(); i++) {
+            const auto& prop = table.props[i];
+            if ((prop.flags & (SPROP_INSIDEARRAY | SPROP_EXCLUDE)) || is_excluded(table, prop)) {
+                continue;
+            }
+            if (prop.type == PropType::DATA_TABLE) {
+                if (prop.flags & SPROP_COLLAPSIBLE) {
+                    iterate_props(sub_table(prop), own, out);
+                }
+                else {
+                    gather_props(sub_table(prop), out);
+                }
+            }
+            else if (prop.type == PropType::ARRAY) {
+                if (i == 0) {
+                    throw std::runtime_error("Array prop without element in send table: " + table.name);
+                }
+                own.push_back({ &prop, &table.props[i - 1], &table });
+            }
+            else {
+                own.push_back({ &prop, nullptr, &table });
+            }
+        }
+        path.pop_back();
+    }
+
+    void gather_props(const SendTable& table, std::vector<GatheredProp>& out) {
+        std::vector<GatheredProp> own;
+        iterate_props(table, own, out);
+        out.insert(out.end(), own.begin(), own.end());
+    }
+
+public:
+    explicit Flattener(const DataTables& data_tables) : data_tables(data_tables) {}
+
+    std::vector<GatheredProp> flatten(const SendTable& table) {
+        excludes.clear();
+        path.clear();
+        gather_excludes(table);
+
+        std::vector<GatheredProp> props;
+        gather_props(table, props);
+
+        // Props that change often go first so their indices stay small. This
+        // is a swap, not a stable partition, to number props like the server.
+        size_t start = 0;
+        for (size_t i = 0; i < props.size(); i++) {
+            if (props[i].prop->flags & SPROP_CHANGES_OFTEN) {
+                std::swap(props[i], props[start]);
+                start++;
+            }
+        }
+        return props;
+    }
+};
+
+}
+
+SendTable SendTable::read(BitReader& reader) {
+    SendTable table;
+    reader.read_ascii_string(table.name, NAME_LIMIT);
+    int num_props = reader.read_bits(PROPINFOBITS_NUMPROPS);
+    table.props.reserve(num_props);
+    for (int i = 0; i < num_props; i++) {
+        SendProp& prop = table.props.emplace_back();
+        prop.type = static_cast<PropType>(reader.read_bits(PROPINFOBITS_TYPE));
+        reader.read_ascii_string(prop.name, NAME_LIMIT);
+        prop.flags = reader.read_bits(SPROP_NUMFLAGBITS_NETWORKED);
+
+        if (prop.type == PropType::DATA_TABLE || (prop.flags & SPROP_EXCLUDE)) {
+            reader.read_ascii_string(prop.table_name, NAME_LIMIT);
+        }
+        else if (prop.type == PropType::ARRAY) {
+            prop.num_elements = reader.read_bits(PROPINFOBITS_NUMELEMENTS);
+        }
+        else {
+            prop.low_value = reader.read_float32();
+            prop.high_value = reader.read_float32();
+            prop.num_bits = reader.read_bits(PROPINFOBITS_NUMBITS);
+        }
+    }
+    return table;
+}
+
+int FlatClass::find(std::string_view prop_name) const {
+    auto it = std::find(prop_names.begin(), prop_names.end(), prop_name);
+    return it == prop_names.end() ? -1 : static_cast<int>(it - prop_names.begin());
+}
+
+DataTables DataTables::parse(std::span<const std::byte> data) {
+    DataTables result;
+    BitReader reader(data);
+
+    while (reader.read_bit()) {
+        bool needs_decoder = reader.read_bit();
+        SendTable& table = result.tables.emplace_back(SendTable::read(reader));
+        table.needs_decoder = needs_decoder;
+    }
+    for (size_t i = 0; i < result.tables.size(); i++) {
+        result.table_index.emplace(result.tables[i].name, i);
+    }
+
+    int num_classes = reader.read_uint16();
+    result.classes.reserve(num_classes);
+    for (int i = 0; i < num_classes; i++) {
+        ServerClass& server_class = result.classes.emplace_back();
+        server_class.id = reader.read_uint16();
+        reader.read_ascii_string(server_class.name, NAME_LIMIT);
+        reader.read_ascii_string(server_class.table_name, NAME_LIMIT);
+    }
+    result.class_bits = Q_log2(num_classes) + 1;
+
+    result.flatten();
+    return result;
+}
+
+std::shared_ptr<const DataTables> DataTables::load(std::span<const std::byte> data) {
+    struct CacheEntry {
+        std::vector<std::byte> data;
+        std::shared_ptr<const DataTables> tables;
+    };
+    // A handful of server builds at most; the entries are small next to a demo.
+    constexpr size_t CACHE_LIMIT = 16;
+    static std::mutex mutex;
+    static std::multimap<uint64_t, CacheEntry> cache;
+
+    auto hash = hash64(data);
+    {
+        std::lock_guard lock(mutex);
+        auto [first, last] = cache.equal_range(hash);
+        for (auto it = first; it != last; ++it) {
+            if (std::equal(it->second.data.begin(), it->second.data.end(), data.begin(), data.end())) {
+                return it->second.tables;
+            }
+        }
+    }
+
+    auto tables = std::make_shared<const DataTables>(parse(data));
+
+    std::lock_guard lock(mutex);
+    if (cache.size() >= CACHE_LIMIT) {
+        cache.clear();
+    }
+    cache.emplace(hash, CacheEntry{ { data.begin(), data.end() }, tables });
+    return tables;
+}
+
+const SendTable* DataTables::find_table(std::string_view name) const {
+    auto it = table_index.find(std::string(name));
+    return it == table_index.end() ? nullptr : &tables[it->second];
+}
+
+void DataTables::flatten() {
+    int max_id = -1;
+    for (const auto& server_class : classes) {
+        max_id = std::max(max_id, server_class.id);
+    }
+    flat_classes.assign(max_id + 1, FlatClass{});
+
+    Flattener flattener(*this);
+    for (const auto& server_class : classes) {
+        const SendTable* table = find_table(server_class.table_name);
+        if (!table) {
+            throw std::runtime_error("Unknown send table for class " + server_class.name + ": " + server_class.table_name);
+        }
+
+        FlatClass& flat = flat_classes[server_class.id];
+        flat.id = server_class.id;
+        flat.name = server_class.name;
+        flat.table_name = server_class.table_name;
+
+        auto gathered = flattener.flatten(*table);
+        flat.props.reserve(gathered.size());
+        flat.prop_names.reserve(gathered.size());
+        flat.prop_tables.reserve(gathered.size());
+        for (const auto& prop : gathered) {
+            flat.props.push_back(make_descriptor(prop));
+            flat.prop_names.push_back(prop.prop->name);
+            flat.prop_tables.push_back(prop.owner->name);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "Util/BitReader.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Send prop types as numbered on the wire.
+enum class PropType : uint8_t {
+    INT,
+    FLOAT,
+    VECTOR,
+    VECTOR_XY,
+    STRING,
+    ARRAY,
+    DATA_TABLE
+};
+
+// Send prop flags. Only the low 16 bits are networked.
+constexpr uint32_t SPROP_UNSIGNED = 1 << 0;
+constexpr uint32_t SPROP_COORD = 1 << 1;
+constexpr uint32_t SPROP_NOSCALE = 1 << 2;
+constexpr uint32_t SPROP_ROUNDDOWN = 1 << 3;
+constexpr uint32_t SPROP_ROUNDUP = 1 << 4;
+constexpr uint32_t SPROP_NORMAL = 1 << 5;
+constexpr uint32_t SPROP_EXCLUDE = 1 << 6;
+constexpr uint32_t SPROP_XYZE = 1 << 7;
+constexpr uint32_t SPROP_INSIDEARRAY = 1 << 8;
+constexpr uint32_t SPROP_PROXY_ALWAYS_YES = 1 << 9;
+constexpr uint32_t SPROP_CHANGES_OFTEN = 1 << 10;
+constexpr uint32_t SPROP_IS_A_VECTOR_ELEM = 1 << 11;
+constexpr uint32_t SPROP_COLLAPSIBLE = 1 << 12;
+constexpr uint32_t SPROP_COORD_MP = 1 << 13;
+constexpr uint32_t SPROP_COORD_MP_LOWPRECISION = 1 << 14;
+constexpr uint32_t SPROP_COORD_MP_INTEGRAL = 1 << 15;
+constexpr int SPROP_NUMFLAGBITS_NETWORKED = 16;
+
+struct SendProp {
+    PropType type{};
+    uint32_t flags{};
+    std::string name;
+    // DATA_TABLE props: the table they include. Excluded props: the table the
+    // excluded prop belongs to.
+    std::string table_name;
+    float low_value{};
+    float high_value{};
+    int num_bits{};
+    int num_elements{};
+};
+
+struct SendTable {
+    std::string name;
+    bool needs_decoder{};
+    std::vector<SendProp> props;
+
+    // Reads one table in the layout the server writes it in, which is shared
+    // by the DATA_TABLES frame and SvcSendTable::data.
+    static SendTable read(BitReader& reader);
+};
+
+struct ServerClass {
+    int id{};
+    std::string name;
+    std::string table_name;
+};
+
+// How the value of a flattened prop is read, resolved once from its type and
+// flags so entity decoding does not have to test flags per value.
+enum class PropDecode : uint8_t {
+    INT,
+    UINT,
+    FLOAT_SCALED,
+    FLOAT_COORD,
+    FLOAT_COORD_MP,
+    FLOAT_COORD_MP_LOWPRECISION,
+    FLOAT_COORD_MP_INTEGRAL,
+    FLOAT_NOSCALE,
+    FLOAT_NORMAL,
+    STRING
+};
+
+// One prop of a flattened class. For VECTOR and VECTOR_XY, decode applies to
+// every component; for ARRAY, it applies to every element and element_type,
+// num_bits, flags and the value range describe the element.
+struct PropDescriptor {
+    PropType type;
+    PropType element_type;
+    PropDecode decode;
+    uint8_t num_bits;
+    uint16_t flags;
+    uint16_t num_elements;
+    // Width of an array's element count.
+    uint8_t count_bits;
+    float low_value;
+    float high_value;
+};
+
+// A server class with its send table tree flattened into the order props are
+// numbered in entity updates: exclusions removed, base classes and included
+// tables resolved, SPROP_CHANGES_OFTEN props moved to the front.
+struct FlatClass {
+    int id{};
+    std::string name;
+    std::string table_name;
+    // Decode order. Names are kept apart so the descriptors stay dense.
+    std::vector<PropDescriptor> props;
+    std::vector<std::string> prop_names;
+    // Table each prop was declared in, to tell apart props that share a name.
+    std::vector<std::string> prop_tables;
+
+    // Index of the first prop with this name, or -1.
+    int find(std::string_view prop_name) const;
+};
+
+// Decoded contents of a DATA_TABLES frame.
+class DataTables {
+public:
+    std::vector<SendTable> tables;
+    std::vector<ServerClass> classes;
+    // Indexed by class id.
+    std::vector<FlatClass> flat_classes;
+    // Width of a class id in entity updates.
+    int class_bits = 0;
+
+    // Decodes the body of a DATA_TABLES frame and flattens every class.
+    static DataTables parse(std::span<const std::byte> data);
+    // Like parse(), but demos recorded on the same server build carry the same
+    // tables, so results are cached by content and shared across the process.
+    static std::shared_ptr<const DataTables> load(std::span<const std::byte> data);
+
+    const SendTable* find_table(std::string_view name) const;
+
+private:
+    std::unordered_map<std::string, size_t> table_index;
+
+    void flatten();
+};
@@ -0,0 +1,38 @@
+#include "Demo/DecodeError.h"
+
+std::string_view decode_error_name(DecodeErrc code) {
+    switch (code) {
+    case DecodeErrc::TRUNCATED_FRAME: return "TRUNCATED_FRAME";
+    case DecodeErrc::UNKNOWN_FRAME_TYPE: return "UNKNOWN_FRAME_TYPE";
+    case DecodeErrc::BAD_FRAME_SIZE: return "BAD_FRAME_SIZE";
+    case DecodeErrc::UNKNOWN_NET_MESSAGE: return "UNKNOWN_NET_MESSAGE";
+    case DecodeErrc::NET_MESSAGE_PAST_END: return "NET_MESSAGE_PAST_END";
+    case DecodeErrc::BAD_BIT_COUNT: return "BAD_BIT_COUNT";
+    case DecodeErrc::BAD_VAR_INT: return "BAD_VAR_INT";
+    }
+    return "UNKNOWN";
+}
+
+DecodeErrc decode_error_code(ReadError error) {
+    switch (error) {
+    case ReadError::BAD_BIT_COUNT: return DecodeErrc::BAD_BIT_COUNT;
+    case ReadError::BAD_VAR_INT: return DecodeErrc::BAD_VAR_INT;
+    default: return DecodeErrc::NET_MESSAGE_PAST_END;
+    }
+}
+
+std::ostream& operator<<(std::ostream& out, const DecodeError& error) {
+    out << decode_error_name(error.code) << " at tick " << error.tick << " (frame at byte " << error.frame_offset << ")";
+    if (error.is_net_message()) {
+        out << ": net message ";
+        auto name = net_message_name(error.net_message);
+        if (name.empty()) {
+            out << static_cast<int>(error.net_message);
+        }
+        else {
+            out << name;
+        }
+        out << " at payload bit " << error.bit_offset;
+    }
+    return out;
+}
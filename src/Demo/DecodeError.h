@@ -0,0 +1,45 @@
+#pragma once
+#include "NetMessage.h"
+#include "Util/BitReader.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+// Why a frame or net message could not be decoded. Decoders return these
+// instead of throwing, so a corrupt demo costs a branch per failure rather
+// than an unwind, and the caller decides whether to log, count or throw.
+enum class DecodeErrc : uint8_t {
+    TRUNCATED_FRAME,        // the file ends inside a frame
+    UNKNOWN_FRAME_TYPE,
+    BAD_FRAME_SIZE,         // a negative length field in a frame
+    UNKNOWN_NET_MESSAGE,
+    NET_MESSAGE_PAST_END,   // a net message runs past the end of its packet
+    BAD_BIT_COUNT,          // a net message declares a field wider than 32 bits
+    BAD_VAR_INT,
+};
+
+std::string_view decode_error_name(DecodeErrc code);
+
+// Net message codes for a failed NothrowBitReader.
+DecodeErrc decode_error_code(ReadError error);
+
+struct DecodeError {
+    DecodeErrc code;
+    // Where the frame starts in the file (its command byte) and its tick.
+    // Packet only knows the tick; Demo fills in the offset.
+    size_t frame_offset = 0;
+    int tick = 0;
+    // For net message errors: the message's type id as read, and the bit
+    // offset of that id within the packet payload.
+    NetMessage::Type net_message = NetMessage::Type::net_nop;
+    uint32_t bit_offset = 0;
+
+    // Whether the frame was framed correctly and only its payload is bad, so
+    // decoding can go on with the next frame.
+    bool is_net_message() const { return code >= DecodeErrc::UNKNOWN_NET_MESSAGE; }
+};
+
+// One line, e.g. "UNKNOWN_NET_MESSAGE at tick 1200 (frame at byte 73544):
+// net message 44 at payload bit 1021".
+std::ostream& operator<<(std::ostream& out, const DecodeError& error);
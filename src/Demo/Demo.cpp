@@ -1,18 +1,318 @@
 #include "Demo/Demo.h"
 #include "Demo/DemoMessage.h"
+#include "Demo/DemoVisitor.h"
+#include "Demo/ParseStats.h"
 #include "Util/BinaryReader.h"
-#include <fstream>
-#include <iostream>
+#include "Util/Hash.h"
+#include "Util/ThreadPool.h"
+#include "Util/Trace.h"
+#include <algorithm>
+#include <charconv>
 #include <cstring>
+#include <optional>
+#include <sstream>
 #include <stdexcept> 
 
+namespace {
+
+// Logs a decode error and keeps it; frame_offset is where its frame starts.
+void report(std::vector<DecodeError>& errors, DecodeError error, size_t frame_offset) {
+    error.frame_offset = frame_offset;
+    trace::log() << "Decode error: " << error << std::endl;
+    errors.push_back(error);
+}
+
+}
+
 void Demo::load(const std::string& file_path) {
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Error opening file: " + file_path);
+    trace::Scope trace_scope(trace, log);
+    stats::Scope stats_scope(stats);
+
+    BinaryReader reader = open(file_path);
+    if (pool && !trace::stream()) {
+        parse_messages_parallel(reader);
+    }
+    else {
+        parse_messages(reader);
+    }
+
+    if (auto* out = trace::stream()) {
+        *out << "Parsed " << messages.size() << " messages.\n";
+    }
+}
+
+void Demo::parse_stream(const std::string& file_path, DemoVisitor& visitor) {
+    trace::Scope trace_scope(trace, log);
+    stats::Scope stats_scope(stats);
+
+    BinaryReader reader = open(file_path);
+    if (visitor.on_header(header) == VisitResult::STOP) {
+        return;
+    }
+
+    // Each frame is built in a scratch arena that is reset once the frame has
+    // been visited, so the same memory is reused for the whole demo.
+    Arena frame_arena;
+    while (!reader.eof()) {
+        if (stream_frame(reader, visitor, frame_arena) == VisitResult::STOP) {
+            break;
+        }
+    }
+}
+
+VisitResult Demo::stream_frame(BinaryReader& reader, DemoVisitor& visitor, Arena& frame_arena) {
+    frame_arena.release();
+    auto offset = reader.tell();
+    auto read = read_message(reader, frame_arena);
+    if (!read) {
+        report(decode_errors, read.error(), offset);
+        return VisitResult::STOP;
+    }
+    ArenaPtr<DemoMessage> message = std::move(*read);
+    auto type = message->type;
+    stats::Timer timer(stats::frame(type));
+
+    if (type == DemoMessage::Type::PACKET || type == DemoMessage::Type::SIGN_ON) {
+        auto& packet = static_cast<Packet&>(*message);
+        packet.read_frame(reader);
+        timer.stop((reader.tell() - offset) * 8);
+
+        auto result = visitor.on_message(packet);
+        if (result == VisitResult::STOP) {
+            return result;
+        }
+        if (result == VisitResult::CONTINUE) {
+            auto msg_reader = packet.payload();
+            while (true) {
+                auto net_message = packet.read_net_message(msg_reader);
+                if (!net_message) {
+                    report(decode_errors, net_message.error(), offset);
+                    break;
+                }
+                if (!*net_message) {
+                    break;
+                }
+                apply_net_message(packet, **net_message);
+                result = visitor.on_net_message(packet, **net_message);
+                if (result == VisitResult::STOP) {
+                    return result;
+                }
+                if (result == VisitResult::SKIP_PACKET) {
+                    apply_skipped(packet, msg_reader, offset);
+                    break;
+                }
+            }
+        }
+        else {
+            auto msg_reader = packet.payload();
+            apply_skipped(packet, msg_reader, offset);
+        }
+        if (auto* out = trace::stream()) {
+            *out << "=========\n";
+        }
+    }
+    else {
+        message->parse(reader);
+        timer.stop((reader.tell() - offset) * 8);
+        apply_frame(*message);
+        if (visitor.on_message(*message) == VisitResult::STOP) {
+            return VisitResult::STOP;
+        }
+    }
+
+    return type == DemoMessage::Type::STOP ? VisitResult::STOP : VisitResult::CONTINUE;
+}
+
+void Demo::open_index(const std::string& file_path) {
+    trace::Scope trace_scope(trace, log);
+
+    BinaryReader reader = open(file_path);
+
+    auto sidecar = FrameIndex::sidecar_path(file_path);
+    if (auto loaded = FrameIndex::load(sidecar, file.bytes())) {
+        index = std::move(*loaded);
+        return;
+    }
+
+    index = build_index(reader);
+    try {
+        index.save(sidecar);
     }
+    catch (const std::exception& e) {
+        // The index in memory is still good; it just has to be rebuilt next time.
+        trace::log() << e.what() << std::endl;
+    }
+}
+
+FrameIndex Demo::build_index(BinaryReader& reader) {
+    FrameIndex built;
+    built.file_size = file.size();
+    built.file_hash = hash64(file.bytes());
+
+    Arena frame_arena;
+    bool in_signon = true;
+    while (!reader.eof()) {
+        frame_arena.release();
+        auto offset = reader.tell();
+        auto read = read_message(reader, frame_arena);
+        if (!read) {
+            report(decode_errors, read.error(), offset);
+            break;
+        }
+        ArenaPtr<DemoMessage> message = std::move(*read);
+        auto type = message->type;
+        auto position = static_cast<uint32_t>(built.frames.size());
+        built.frames.push_back({ message->tick, type, offset });
+
+        if (type == DemoMessage::Type::PACKET || type == DemoMessage::Type::SIGN_ON) {
+            auto& packet = static_cast<Packet&>(*message);
+            packet.read_frame(reader);
+            auto msg_reader = packet.payload();
+            if (auto indexed = packet.index_net_messages(msg_reader); !indexed) {
+                report(decode_errors, indexed.error(), offset);
+            }
+            for (const auto& entry : packet.net_index) {
+                if (entry.type != NetMessage::Type::svc_packet_entities) {
+                    continue;
+                }
+                // Peek at is_delta, right after the 11-bit max_entries.
+                auto entities = packet.payload();
+                entities.seek(entry.bit_offset + 11);
+                if (!entities.read_bit()) {
+                    built.full_updates.push_back(position);
+                    break;
+                }
+            }
+        }
+        else {
+            message->parse(reader);
+        }
+
+        if (type == DemoMessage::Type::PACKET) {
+            in_signon = false;
+        }
+        if (in_signon) {
+            built.signon_end = position + 1;
+        }
+        if (type == DemoMessage::Type::DATA_TABLES && built.data_tables == FrameIndex::NO_FRAME) {
+            built.data_tables = position;
+        }
+        if (type == DemoMessage::Type::STRING_TABLES) {
+            built.string_tables.push_back(position);
+        }
+        if (type == DemoMessage::Type::STOP) {
+            break;
+        }
+    }
+    return built;
+}
+
+void Demo::seek(int tick, DemoVisitor& visitor) {
+    if (index.frames.empty()) {
+        throw std::runtime_error("seek: the demo has no frame index, call open_index() first.");
+    }
+    trace::Scope trace_scope(trace, log);
+    stats::Scope stats_scope(stats);
+    decode_errors.clear();
+
+    BinaryReader reader(file.bytes());
+    if (visitor.on_header(header) == VisitResult::STOP) {
+        return;
+    }
+
+    uint32_t target = index.find(tick);
+    std::vector<uint32_t> context;
+    for (uint32_t i = 0; i < index.signon_end && i < target; i++) {
+        context.push_back(i);
+    }
+    for (const auto* positions : { &index.string_tables, &index.full_updates }) {
+        auto frame = FrameIndex::last_before(*positions, target);
+        if (frame != FrameIndex::NO_FRAME && frame >= index.signon_end) {
+            context.push_back(frame);
+        }
+    }
+    std::sort(context.begin(), context.end());
+    context.erase(std::unique(context.begin(), context.end()), context.end());
+
+    // Snapshots only hold the state as of their own frame. The string table
+    // and entity updates of every packet after them, up to the target, are
+    // applied as well, without being handed to the visitor.
+    uint32_t last_snapshot = FrameIndex::last_before(index.string_tables, target);
+    uint32_t last_full_update = FrameIndex::last_before(index.full_updates, target);
+    bool catch_up_tables = track_string_tables || track_entities;
+
+    // The replayed context rebuilds the tracked state from scratch.
+    string_tables.clear();
+    entities.reset(data_tables);
+    temp_entities.reset(data_tables);
+
+    Arena frame_arena;
+    size_t next_context = 0;
+    for (uint32_t frame = 0; frame < target; frame++) {
+        if (next_context < context.size() && context[next_context] == frame) {
+            next_context++;
+            reader.seek(index.frames[frame].offset);
+            if (stream_frame(reader, visitor, frame_arena) == VisitResult::STOP) {
+                return;
+            }
+            continue;
+        }
+        if (frame < index.signon_end) {
+            continue;
+        }
+        bool tables = catch_up_tables && (last_snapshot == FrameIndex::NO_FRAME || frame > last_snapshot);
+        bool updates = track_entities && last_full_update != FrameIndex::NO_FRAME && frame > last_full_update;
+        if (tables || updates) {
+            catch_up(reader, frame, tables, updates, frame_arena);
+        }
+    }
+
+    if (target == index.frames.size()) {
+        return;
+    }
+    reader.seek(index.frames[target].offset);
+    while (!reader.eof()) {
+        if (stream_frame(reader, visitor, frame_arena) == VisitResult::STOP) {
+            break;
+        }
+    }
+}
+
+void Demo::catch_up(BinaryReader& reader, uint32_t frame, bool tables, bool updates, Arena& frame_arena) {
+    auto type = index.frames[frame].type;
+    if (type != DemoMessage::Type::PACKET && type != DemoMessage::Type::SIGN_ON) {
+        return;
+    }
+    frame_arena.release();
+    auto offset = index.frames[frame].offset;
+    reader.seek(offset);
+    auto read = read_message(reader, frame_arena);
+    if (!read) {
+        report(decode_errors, read.error(), offset);
+        return;
+    }
+    ArenaPtr<DemoMessage> message = std::move(*read);
+    auto& packet = static_cast<Packet&>(*message);
+    packet.read_frame(reader);
+    auto msg_reader = packet.payload();
+    if (auto indexed = packet.index_net_messages(msg_reader); !indexed) {
+        report(decode_errors, indexed.error(), offset);
+    }
+    for (size_t i = 0; i < packet.net_index.size(); i++) {
+        auto net_type = packet.net_index[i].type;
+        bool wanted = net_type == NetMessage::Type::svc_packet_entities ? updates
+            : net_type == NetMessage::Type::svc_create_string_table || net_type == NetMessage::Type::svc_update_string_table ? tables
+            : false;
+        if (wanted) {
+            apply_net_message(packet, packet.net_message(i));
+        }
+    }
+}
 
-    BinaryReader reader(file);
+BinaryReader Demo::open(const std::string& file_path) {
+    file = MappedFile(file_path);
+    BinaryReader reader(file.bytes());
+    decode_errors.clear();
 
     parse_header(reader);
 
@@ -22,10 +322,7 @@ void Demo::load(const std::string& file_path) {
     if (!supported_network_protocol()) {
         throw std::runtime_error("Unsupported network protocol: " + std::to_string(header.network_protocol));
     }
-
-    parse_messages(reader);
-
-    std::cout << "Parsed " << messages.size() << " messages.\n";
+    return reader;
 }
 
 bool Demo::supported_network_protocol()
@@ -57,33 +354,389 @@ void Demo::parse_header(BinaryReader& reader) {
 
 void Demo::parse_messages(BinaryReader& reader) {
     while (!reader.eof()) {
-        auto type = static_cast<DemoMessage::Type>(reader.read_byte());
-        auto tick = reader.read_int32();
-
-        std::unique_ptr<DemoMessage> message = create_message(type, tick);
-        message->parse(reader);
+        auto offset = reader.tell();
+        auto read = read_message(reader, arena);
+        if (!read) {
+            report(decode_errors, read.error(), offset);
+            break;
+        }
+        ArenaPtr<DemoMessage> message = std::move(*read);
+        auto type = message->type;
+        stats::Timer timer(stats::frame(type));
+        bool is_packet = type == DemoMessage::Type::PACKET || type == DemoMessage::Type::SIGN_ON;
+        if (is_packet) {
+            auto& packet = static_cast<Packet&>(*message);
+            packet.read_frame(reader);
+            timer.stop((reader.tell() - offset) * 8);
+            if (auto decoded = decode_packet(packet, net_store); !decoded) {
+                report(decode_errors, decoded.error(), offset);
+            }
+            if (auto* out = trace::stream()) {
+                *out << "=========\n";
+            }
+        }
+        else {
+            message->parse(reader);
+            timer.stop((reader.tell() - offset) * 8);
+        }
+        apply_frame(*message);
         messages.push_back(std::move(message));
+
+        if (messages.back()->type == DemoMessage::Type::STOP) {
+            break;
+        }
+    }
+}
+
+namespace {
+
+// Packet payload bytes per parallel decode task. Small enough for a long demo
+// to split into many more chunks than there are cores, large enough for the
+// per-task overhead not to matter.
+constexpr size_t PARALLEL_CHUNK_BYTES = 1 << 20;
+
+// Consecutive frames built and decoded by one task, with everything the task
+// produces kept apart from the other tasks until the merge.
+struct DecodeChunk {
+    explicit DecodeChunk(Arena& arena) : arena(arena), store(arena.memory()) {}
+
+    Arena& arena;
+    // File offsets of the chunk's frames; they go to messages[first_message...].
+    std::vector<size_t> frame_offsets;
+    size_t first_message = 0;
+    std::vector<Packet*> packets;
+    NetMessageStore store;
+    std::ostringstream log;
+    std::vector<DecodeError> errors;
+    // Only allocated when the demo collects stats.
+    std::unique_ptr<ParseStats> stats;
+};
+
+}
+
+void Demo::parse_messages_parallel(BinaryReader& reader) {
+    // Phase 1: frame the demo. Only the type, tick and length of each frame
+    // are read; every run of about PARALLEL_CHUNK_BYTES becomes a chunk with
+    // its own arena, so the tasks below never allocate from the same one.
+    std::vector<std::unique_ptr<DecodeChunk>> chunks;
+    std::optional<DecodeError> framing_error;
+    size_t chunk_bytes = PARALLEL_CHUNK_BYTES;
+    size_t frame_count = 0;
+    while (!reader.eof()) {
+        if (chunk_bytes >= PARALLEL_CHUNK_BYTES) {
+            auto& chunk_arena = *chunk_arenas.emplace_back(std::make_unique<Arena>());
+            chunks.push_back(std::make_unique<DecodeChunk>(chunk_arena));
+            chunks.back()->first_message = frame_count;
+            chunk_bytes = 0;
+        }
+
+        auto offset = reader.tell();
+        auto header = read_frame_header(reader);
+        if (!header) {
+            // Reported after the errors of the frames before it.
+            framing_error = header.error();
+            break;
+        }
+        reader.seek(header->body_size, std::ios::cur);
+        chunks.back()->frame_offsets.push_back(offset);
+        chunk_bytes += reader.tell() - offset;
+        frame_count++;
+
+        if (header->type == DemoMessage::Type::STOP) {
+            break;
+        }
+    }
+    messages.resize(frame_count);
+
+    // Phase 2: build the frames and decode packet payloads. Net messages of a
+    // packet only depend on the packet itself, so chunks are independent.
+    for (auto& chunk_ptr : chunks) {
+        if (stats) {
+            chunk_ptr->stats = std::make_unique<ParseStats>();
+        }
+        pool->submit([this, &chunk = *chunk_ptr] {
+            trace::Scope trace_scope(nullptr, &chunk.log);
+            stats::Scope stats_scope(chunk.stats.get());
+            BinaryReader chunk_reader(file.bytes());
+            for (size_t i = 0; i < chunk.frame_offsets.size(); i++) {
+                auto offset = chunk.frame_offsets[i];
+                chunk_reader.seek(offset);
+                // Phase 1 has already checked the header of every frame here.
+                ArenaPtr<DemoMessage> message = std::move(*read_message(chunk_reader, chunk.arena));
+                auto type = message->type;
+                stats::Timer timer(stats::frame(type));
+                if (type == DemoMessage::Type::PACKET || type == DemoMessage::Type::SIGN_ON) {
+                    auto& packet = static_cast<Packet&>(*message);
+                    packet.read_frame(chunk_reader);
+                    timer.stop((chunk_reader.tell() - offset) * 8);
+                    if (auto decoded = decode_packet(packet, chunk.store); !decoded) {
+                        report(chunk.errors, decoded.error(), offset);
+                    }
+                    chunk.packets.push_back(&packet);
+                }
+                else {
+                    message->parse(chunk_reader);
+                    timer.stop((chunk_reader.tell() - offset) * 8);
+                }
+                messages[chunk.first_message + i] = std::move(message);
+            }
+        });
+    }
+    pool->wait();
+
+    // Phase 3: merge in file order. Anything that carries state from one
+    // packet to the next belongs here.
+    for (auto& chunk : chunks) {
+        auto errors = chunk->log.str();
+        if (!errors.empty()) {
+            trace::log() << errors << std::flush;
+        }
+        decode_errors.insert(decode_errors.end(), chunk->errors.begin(), chunk->errors.end());
+        if (chunk->stats) {
+            stats->merge(*chunk->stats);
+        }
+    }
+    if (framing_error) {
+        report(decode_errors, *framing_error, framing_error->frame_offset);
+    }
+    if (net_storage == NetStorage::COLUMNAR) {
+        std::vector<NetMessageStore*> stores;
+        for (auto& chunk : chunks) {
+            stores.push_back(&chunk->store);
+        }
+        auto offsets = net_store.append(stores);
+        for (size_t i = 0; i < chunks.size(); i++) {
+            for (auto* packet : chunks[i]->packets) {
+                for (auto& ref : packet->net_refs) {
+                    ref.index += offsets[i][static_cast<size_t>(ref.type)];
+                }
+            }
+        }
+    }
+    for (const auto& message : messages) {
+        apply_frame(*message);
+    }
+}
+
+Expected<void, DecodeError> Demo::decode_packet(Packet& packet, NetMessageStore& store) {
+    auto msg_reader = packet.payload();
+    switch (net_storage) {
+    case NetStorage::POLYMORPHIC:
+        while (true) {
+            auto net_message = packet.read_net_message(msg_reader);
+            if (!net_message) {
+                return unexpected(net_message.error());
+            }
+            if (!*net_message) {
+                break;
+            }
+            packet.net_messages.push_back(std::move(*net_message));
+        }
+        break;
+    case NetStorage::COLUMNAR:
+        return packet.read_net_messages(msg_reader, store);
+    case NetStorage::LAZY:
+        return packet.index_net_messages(msg_reader);
+    }
+    return {};
+}
+
+void Demo::apply_frame(DemoMessage& message) {
+    if (message.type == DemoMessage::Type::DATA_TABLES) {
+        // A broken table only costs entity decoding, not the rest of the demo.
+        try {
+            data_tables = DataTables::load(static_cast<const DataTable&>(message).data);
+        }
+        catch (const std::exception& e) {
+            data_tables.reset();
+            trace::log() << "Failed to decode data tables: " << e.what() << std::endl;
+        }
+        if (track_entities) {
+            entities.reset(data_tables);
+        }
+        if (track_temp_entities) {
+            temp_entities.reset(data_tables);
+        }
+    }
+
+    if (message.type == DemoMessage::Type::STRING_TABLES && (track_string_tables || track_entities)) {
+        try {
+            for (auto* table : string_tables.read_snapshot(static_cast<const StringTable&>(message).data)) {
+                apply_baselines(*table);
+            }
+        }
+        catch (const std::exception& e) {
+            trace::log() << "Failed to decode string tables: " << e.what() << std::endl;
+        }
+    }
+
+    if (message.type != DemoMessage::Type::PACKET && message.type != DemoMessage::Type::SIGN_ON) {
+        return;
+    }
+    auto& packet = static_cast<Packet&>(message);
+    switch (net_storage) {
+    case NetStorage::POLYMORPHIC:
+        for (const auto& net_message : packet.net_messages) {
+            apply_net_message(packet, *net_message);
+        }
+        break;
+    case NetStorage::COLUMNAR:
+        for (auto ref : packet.net_refs) {
+            if (is_tracked(ref.type)) {
+                apply_net_message(packet, net_store.get(ref));
+            }
+        }
+        break;
+    case NetStorage::LAZY:
+        for (size_t i = 0; i < packet.net_index.size(); i++) {
+            if (is_tracked(packet.net_index[i].type)) {
+                apply_net_message(packet, packet.net_message(i));
+            }
+        }
+        break;
+    }
+}
+
+bool Demo::is_tracked(NetMessage::Type type) const {
+    switch (type) {
+    case NetMessage::Type::svc_create_string_table:
+    case NetMessage::Type::svc_update_string_table:
+        return track_string_tables || track_entities;
+    case NetMessage::Type::svc_packet_entities:
+        return track_entities;
+    case NetMessage::Type::svc_temp_entities:
+        return track_temp_entities;
+    case NetMessage::Type::svc_game_event_list:
+    case NetMessage::Type::svc_game_event:
+        return game_events.has_subscriptions();
+    case NetMessage::Type::svc_user_message:
+        return user_messages.has_subscriptions();
+    default:
+        return false;
+    }
+}
+
+bool Demo::tracks_net_messages() const {
+    return track_entities || track_string_tables || track_temp_entities || game_events.has_subscriptions()
+        || user_messages.has_subscriptions();
+}
+
+void Demo::apply_net_message(const Packet& packet, const NetMessage& message) {
+    if (!is_tracked(message.type)) {
+        return;
+    }
+    try {
+        switch (message.type) {
+        case NetMessage::Type::svc_create_string_table:
+            apply_baselines(string_tables.create(static_cast<const SvcCreateStringTable&>(message)));
+            break;
+        case NetMessage::Type::svc_update_string_table:
+            apply_baselines(string_tables.update(static_cast<const SvcUpdateStringTable&>(message)));
+            break;
+        case NetMessage::Type::svc_packet_entities:
+            if (entities.tables()) {
+                entities.apply(static_cast<const SvcPacketEntities&>(message));
+            }
+            break;
+        case NetMessage::Type::svc_temp_entities:
+            if (data_tables) {
+                temp_entities.apply(static_cast<const SvcTempEntities&>(message), packet.tick);
+            }
+            break;
+        case NetMessage::Type::svc_game_event_list:
+            game_events.parse_list(static_cast<const SvcGameEventList&>(message));
+            break;
+        case NetMessage::Type::svc_game_event:
+            game_events.dispatch(static_cast<const SvcGameEvent&>(message), packet.tick);
+            break;
+        case NetMessage::Type::svc_user_message:
+            user_messages.dispatch(static_cast<const SvcUserMessage&>(message), packet.tick);
+            break;
+        default:
+            break;
+        }
+    }
+    catch (const std::exception& e) {
+        auto what = message.type == NetMessage::Type::svc_packet_entities ? "entity update"
+            : message.type == NetMessage::Type::svc_temp_entities ? "temp entities"
+            : message.type == NetMessage::Type::svc_user_message ? "user message"
+            : message.type == NetMessage::Type::svc_game_event || message.type == NetMessage::Type::svc_game_event_list ? "game event"
+            : "string table";
+        trace::log() << "Failed to apply " << what << ": " << e.what() << std::endl;
+    }
+}
+
+void Demo::apply_baselines(const NetworkStringTable& table) {
+    if (!track_entities || &table != string_tables.instancebaseline()) {
+        return;
+    }
+    // Entries are named after the server class id they hold the baseline of.
+    for (int index : table.changed) {
+        const auto& entry = table.entries[index];
+        int class_id = -1;
+        auto result = std::from_chars(entry.string.data(), entry.string.data() + entry.string.size(), class_id);
+        if (result.ec == std::errc()) {
+            entities.baselines.set(class_id, entry.user_data);
+        }
+    }
+}
+
+void Demo::apply_skipped(Packet& packet, NothrowBitReader& reader, size_t frame_offset) {
+    if (!tracks_net_messages()) {
+        return;
+    }
+    if (auto indexed = packet.index_net_messages(reader); !indexed) {
+        report(decode_errors, indexed.error(), frame_offset);
+    }
+    for (size_t i = 0; i < packet.net_index.size(); i++) {
+        if (is_tracked(packet.net_index[i].type)) {
+            apply_net_message(packet, packet.net_message(i));
+        }
+    }
+}
+
+Expected<Demo::FrameHeader, DecodeError> Demo::read_frame_header(BinaryReader& reader) {
+    DecodeError error{ DecodeErrc::TRUNCATED_FRAME };
+    error.frame_offset = reader.tell();
+    if (reader.remaining().size() < 1 + sizeof(int32_t)) {
+        return unexpected(error);
+    }
+    auto type = static_cast<DemoMessage::Type>(reader.read_byte());
+    error.tick = reader.read_int32();
+    auto body_size = DemoMessage::body_size(type, reader.remaining());
+    if (!body_size) {
+        error.code = body_size.error();
+        return unexpected(error);
+    }
+    return FrameHeader{ type, error.tick, *body_size };
+}
+
+Expected<ArenaPtr<DemoMessage>, DecodeError> Demo::read_message(BinaryReader& reader, Arena& storage) {
+    auto header = read_frame_header(reader);
+    if (!header) {
+        return unexpected(header.error());
     }
+    return create_message(header->type, header->tick, storage);
 }
 
-std::unique_ptr<DemoMessage> Demo::create_message(DemoMessage::Type type, int tick) {
+ArenaPtr<DemoMessage> Demo::create_message(DemoMessage::Type type, int tick, Arena& storage) {
     switch (type) {
     case DemoMessage::Type::SIGN_ON:
-        return std::make_unique<SignOn>(tick);
+        return storage.make<SignOn>(tick);
     case DemoMessage::Type::PACKET:
-        return std::make_unique<Packet>(tick);
+        return storage.make<Packet>(tick);
     case DemoMessage::Type::SYNC_TICK:
-        return std::make_unique<SyncTick>(tick);
+        return storage.make<SyncTick>(tick);
     case DemoMessage::Type::CONSOLE_CMD:
-        return std::make_unique<ConsoleCmd>(tick);
+        return storage.make<ConsoleCmd>(tick);
     case DemoMessage::Type::USER_CMD:
-        return std::make_unique<UserCmd>(tick);
+        return storage.make<UserCmd>(tick);
     case DemoMessage::Type::DATA_TABLES:
-        return std::make_unique<DataTable>(tick);
+        return storage.make<DataTable>(tick);
     case DemoMessage::Type::STRING_TABLES:
-        return std::make_unique<StringTable>(tick);
+        return storage.make<StringTable>(tick);
     case DemoMessage::Type::STOP:
-        return std::make_unique<Stop>(tick);
+        return storage.make<Stop>(tick);
     default:
         throw std::runtime_error("create_message: Unhandled message type encountered: " + std::to_string(static_cast<int>(type)));
     }
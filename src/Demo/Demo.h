@@ -1,10 +1,24 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <iosfwd>
 #include <memory>
+#include "DataTables.h"
 #include "DemoMessage.h"
+#include "DemoVisitor.h"
+#include "Entities.h"
+#include "FrameIndex.h"
+#include "GameEvents.h"
+#include "StringTables.h"
+#include "TempEntities.h"
+#include "UserMessages.h"
+#include "Util/MappedFile.h"
+#include "Util/Arena.h"
 
 class BinaryReader;
+class ParseStats;
+class TraceSink;
+class ThreadPool;
 
 constexpr auto DEMO_FILE_STAMP = "HL2DEMO";
 constexpr auto DEMO_PROTOCOL = 3;
@@ -28,14 +42,127 @@ struct DemoHeader {
 class Demo {
 public:
 	DemoHeader header;
-	std::vector<std::unique_ptr<DemoMessage>> messages;
+	// Backing bytes of the loaded demo. Message payloads are views into it.
+	MappedFile file;
+	// Owns every message below along with their strings and containers; all of
+	// it is freed in one go with the Demo.
+	Arena arena;
+	// Used instead of arena for the chunks that load() decodes in parallel.
+	std::vector<std::unique_ptr<Arena>> chunk_arenas;
+	std::vector<ArenaPtr<DemoMessage>> messages;
+
+	enum class NetStorage {
+		POLYMORPHIC,  // one heap object per message in Packet::net_messages
+		COLUMNAR,     // contiguous per-type vectors in net_store, Packet::net_refs
+		LAZY          // only Packet::net_index; decoded on access with Packet::net_message()
+	};
+	// How load() keeps decoded net messages. Set before calling load().
+	NetStorage net_storage = NetStorage::POLYMORPHIC;
+	NetMessageStore net_store{ arena.memory() };
+	// Receives a line per decoded message while loading; nullptr disables tracing.
+	TraceSink* trace = nullptr;
+	// Receives recoverable decode errors; nullptr means std::cerr.
+	std::ostream* log = nullptr;
+	// Frames and net messages that failed to decode during the last load(),
+	// parse_stream(), open_index() or seek(), in file order; each is also
+	// written to log. A bad net message costs the rest of its packet and
+	// decoding resumes with the next frame. A bad frame header ends the demo
+	// there, as nothing after it can be framed; everything before it is kept.
+	std::vector<DecodeError> decode_errors;
+	// Counts frames and net messages per type, with their sizes and decode
+	// times, while loading, streaming or seeking; nullptr counts nothing.
+	// Parallel chunks count separately and are added in once they finish.
+	ParseStats* stats = nullptr;
+	// When set, load() decodes the demo in two phases: a sequential pass that
+	// only frames it, then packet payloads are decoded in chunks on the pool,
+	// and finally the per-chunk results are merged in file order. Tracing needs
+	// the sequential order, so a traced load ignores the pool. Must not be the
+	// pool that load() itself runs on.
+	ThreadPool* pool = nullptr;
+	// Filled by open_index().
+	FrameIndex index;
+	// Send tables and flattened server classes, decoded from the DATA_TABLES
+	// frame as soon as it is read.
+	std::shared_ptr<const DataTables> data_tables;
+	// When set, string_tables is kept up to date from the string table net
+	// messages and STRING_TABLES frames while loading, streaming or seeking.
+	// Implied by track_entities, which needs the instance baselines.
+	bool track_string_tables = false;
+	StringTables string_tables;
+	// When set, entities is kept up to date from svc_packet_entities while
+	// loading, streaming or seeking; a visitor sees the state as of the net
+	// message it is handed, and updates in packets it skips or a seek() jumps
+	// over are still applied. Set before loading.
+	bool track_entities = false;
+	Entities entities;
+	// When set, every svc_temp_entities event is appended to temp_entities
+	// while loading, streaming or seeking. Set before loading.
+	bool track_temp_entities = false;
+	TempEntities temp_entities;
+	// Handlers subscribed here are called for their events, in file order,
+	// while loading, streaming or seeking; events nobody subscribed to are not
+	// decoded. Subscribe before loading.
+	GameEvents game_events;
+	// Same for user messages; only subscribed types are decoded.
+	UserMessages user_messages;
 
     void load(const std::string& file_path);
+	// Parses the demo without keeping anything in messages: every frame and net
+	// message is handed to the visitor as it is decoded and then released, so
+	// memory use does not grow with the length of the demo.
+	void parse_stream(const std::string& file_path, DemoVisitor& visitor);
+
+	// Maps the demo and loads its frame index from the sidecar next to it
+	// (FrameIndex::sidecar_path). If the sidecar is missing or stale, the index
+	// is rebuilt with a skimming pass over the demo and the sidecar rewritten.
+	void open_index(const std::string& file_path);
+	// Streams the opened demo to visitor like parse_stream(), starting at the
+	// first frame at or after tick. The frames needed for context are replayed
+	// first, in file order: the sign-on, the latest string table snapshot and
+	// the latest full entity update before tick. The string table and entity
+	// updates of the packets between those and tick are applied to the tracked
+	// state without being visited, so it matches a stream that reached tick.
+	// Requires open_index(); can be called any number of times.
+	void seek(int tick, DemoVisitor& visitor);
 
 private:
 	bool supported_network_protocol();
 	bool supported_demo_protocol();
+	BinaryReader open(const std::string& file_path);
 	void parse_header(BinaryReader& reader);
-	std::unique_ptr<DemoMessage> create_message(DemoMessage::Type type, int tick);
+	struct FrameHeader {
+		DemoMessage::Type type;
+		int tick;
+		size_t body_size;
+	};
+	// Reads the command byte and tick of the next frame and checks that its
+	// body is complete, leaving reader at the body.
+	Expected<FrameHeader, DecodeError> read_frame_header(BinaryReader& reader);
+	// Reads the frame header and creates the frame, ready to parse the body.
+	Expected<ArenaPtr<DemoMessage>, DecodeError> read_message(BinaryReader& reader, Arena& storage);
+	ArenaPtr<DemoMessage> create_message(DemoMessage::Type type, int tick, Arena& storage);
 	void parse_messages(BinaryReader& reader);
+	void parse_messages_parallel(BinaryReader& reader);
+	// Decodes the payload of a framed packet according to net_storage.
+	Expected<void, DecodeError> decode_packet(Packet& packet, NetMessageStore& store);
+	// Updates the demo-wide state that later frames depend on. Called for
+	// every frame, in file order.
+	void apply_frame(DemoMessage& message);
+	void apply_net_message(const Packet& packet, const NetMessage& message);
+	// Whether apply_net_message() has anything to do for a message type.
+	bool is_tracked(NetMessage::Type type) const;
+	// Whether is_tracked() holds for any type.
+	bool tracks_net_messages() const;
+	void apply_baselines(const NetworkStringTable& table);
+	// Applies the tracked messages among the rest of a packet that a visitor
+	// asked to skip. frame_offset is where the packet starts, for errors.
+	void apply_skipped(Packet& packet, NothrowBitReader& reader, size_t frame_offset);
+	// Applies the string table messages (tables) and entity updates (updates)
+	// of the packet at frame, for seek() to bring the tracked state from a
+	// snapshot up to its target. Nothing is handed to a visitor.
+	void catch_up(BinaryReader& reader, uint32_t frame, bool tables, bool updates, Arena& frame_arena);
+	// Reads one frame and hands it to visitor. Returns STOP once the visitor
+	// asks to stop or the demo's STOP frame was read.
+	VisitResult stream_frame(BinaryReader& reader, DemoVisitor& visitor, Arena& frame_arena);
+	FrameIndex build_index(BinaryReader& reader);
 };
\ No newline at end of file
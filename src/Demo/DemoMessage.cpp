@@ -1,107 +1,186 @@
 #include "DemoMessage.h"
+#include "ParseStats.h"
 #include "Util//BinaryReader.h"
 #include "Util/BitReader.h"
+#include "Util/Trace.h"
 #include <stdexcept>
 #include <memory>
 #include <iostream>
 #include <iomanip> 
 #include <fstream>
+#include <sstream>
 
-std::unique_ptr<NetMessage> create_net_message(NetMessage::Type msg_type) {
-    switch (msg_type) {
-    case NetMessage::Type::net_nop:
-        return std::make_unique<NetNop>();
-    case NetMessage::Type::net_disconnect:
-        return std::make_unique<NetDisconnect>();
-    case NetMessage::Type::net_tick:
-        return std::make_unique<NetTick>();
-    case NetMessage::Type::net_string_cmd:
-        return std::make_unique<NetStringCmd>();
-    case NetMessage::Type::net_set_con_var:
-        return std::make_unique<NetSetConVar>();
-    case NetMessage::Type::net_signon_state:
-        return std::make_unique<NetSignonState>();
-    case NetMessage::Type::svc_print:
-        return std::make_unique<SvcPrint>();
-    case NetMessage::Type::svc_server_info:
-        return std::make_unique<SvcServerInfo>();
-    case NetMessage::Type::svc_send_table:
-        return std::make_unique<SvcSendTable>();
-    case NetMessage::Type::svc_class_info:
-        return std::make_unique<SvcClassInfo>();
-    case NetMessage::Type::svc_set_pause:
-        return std::make_unique<SvcSetPause>();
-    case NetMessage::Type::svc_create_string_table:
-        return std::make_unique<SvcCreateStringTable>();
-    case NetMessage::Type::svc_update_string_table:
-        return std::make_unique<SvcUpdateStringTable>();
-    case NetMessage::Type::svc_voice_init:
-        return std::make_unique<SvcVoiceInit>();
-    case NetMessage::Type::svc_voice_data:
-        return std::make_unique<SvcVoiceData>();
-    case NetMessage::Type::svc_sounds:
-        return std::make_unique<SvcSounds>();
-    case NetMessage::Type::svc_set_view:
-        return std::make_unique<SvcSetView>();
-    case NetMessage::Type::svc_fix_angle:
-        return std::make_unique<SvcFixAngle>();
-    case NetMessage::Type::svc_crosshair_angle:
-        return std::make_unique<SvcCrosshairAngle>();
-    case NetMessage::Type::svc_bsp_decal:
-        return std::make_unique<SvcBSPDecal>();
-    case NetMessage::Type::svc_user_message:
-        return std::make_unique<SvcUserMessage>();
-    case NetMessage::Type::svc_entity_message:
-        return std::make_unique<SvcEntityMessage>();
-    case NetMessage::Type::svc_game_event:
-        return std::make_unique<SvcGameEvent>();
-    case NetMessage::Type::svc_packet_entities:
-        return std::make_unique<SvcPacketEntities>();
-    case NetMessage::Type::svc_temp_entities:
-        return std::make_unique<SvcTempEntities>();
-    case NetMessage::Type::svc_prefetch:
-        return std::make_unique<SvcPrefetch>();
-    case NetMessage::Type::svc_menu:
-        return std::make_unique<SvcMenu>();
-    case NetMessage::Type::svc_game_event_list:
-        return std::make_unique<SvcGameEventList>();
-    case NetMessage::Type::svc_get_cvar_value:
-        return std::make_unique<SvcGetCvarValue>();
-    case NetMessage::Type::svc_cmd_key_values:
-        return std::make_unique<SvcCmdKeyValues>();
-    case NetMessage::Type::svc_set_pause_timed:
-        return std::make_unique<SvcSetPauseTimed>();
+namespace {
+
+// Type ids of net messages are 6 bits on the wire.
+constexpr int NET_MESSAGE_TYPE_BITS = 6;
+
+DecodeError net_message_error(DecodeErrc code, int tick, NetMessage::Type type, int bit_offset) {
+    DecodeError error{ code };
+    error.tick = tick;
+    error.net_message = type;
+    error.bit_offset = static_cast<uint32_t>(bit_offset);
+    return error;
+}
+
+}
+
+std::string_view frame_name(DemoMessage::Type type) {
+    switch (type) {
+    case DemoMessage::Type::SIGN_ON: return "SIGN_ON";
+    case DemoMessage::Type::PACKET: return "PACKET";
+    case DemoMessage::Type::SYNC_TICK: return "SYNC_TICK";
+    case DemoMessage::Type::CONSOLE_CMD: return "CONSOLE_CMD";
+    case DemoMessage::Type::USER_CMD: return "USER_CMD";
+    case DemoMessage::Type::DATA_TABLES: return "DATA_TABLES";
+    case DemoMessage::Type::STOP: return "STOP";
+    case DemoMessage::Type::STRING_TABLES: return "STRING_TABLES";
+    }
+    return "UNKNOWN";
+}
+
+Expected<size_t, DecodeErrc> DemoMessage::body_size(Type type, std::span<const std::byte> rest)
+{
+    // Every body with a payload is some fixed fields, then the payload length.
+    size_t fixed = 0;
+    switch (type) {
+    case Type::SIGN_ON:
+    case Type::PACKET:
+        fixed = sizeof(CmdInfo) + 2 * sizeof(int32_t);
+        break;
+    case Type::USER_CMD:
+        fixed = sizeof(int32_t);
+        break;
+    case Type::CONSOLE_CMD:
+    case Type::DATA_TABLES:
+    case Type::STRING_TABLES:
+        break;
+    case Type::SYNC_TICK:
+    case Type::STOP:
+        return size_t(0);
     default:
-        throw std::runtime_error("Unhandled or unknown NetMessage type: " + std::to_string(static_cast<int>(msg_type)));
+        return unexpected(DecodeErrc::UNKNOWN_FRAME_TYPE);
     }
+
+    if (rest.size() < fixed + sizeof(int32_t)) {
+        return unexpected(DecodeErrc::TRUNCATED_FRAME);
+    }
+    int32_t length;
+    std::memcpy(&length, rest.data() + fixed, sizeof(length));
+    if (length < 0) {
+        return unexpected(DecodeErrc::BAD_FRAME_SIZE);
+    }
+    size_t size = fixed + sizeof(int32_t) + static_cast<size_t>(length);
+    if (size > rest.size()) {
+        return unexpected(DecodeErrc::TRUNCATED_FRAME);
+    }
+    return size;
 }
 
 void Packet::parse(BinaryReader& reader)
 {
-    std::cout << "Tick: " << tick << std::endl;
-    auto buf = reader.read_bytes(sizeof(CmdInfo));
+    read_frame(reader);
+}
+
+void Packet::read_frame(BinaryReader& reader)
+{
+    if (auto* out = trace::stream()) {
+        *out << "Tick: " << tick << '\n';
+    }
+    auto buf = reader.read_span(sizeof(CmdInfo));
     std::memcpy(&cmd_info, buf.data(), sizeof(CmdInfo));
 
     in_sequence = reader.read_int32();
     out_sequence = reader.read_int32();
     auto size = reader.read_int32();
-    auto data = reader.read_bytes(size);
+    data = reader.read_span(size);
+}
 
-    auto msg_reader = BitReader(data);
+Expected<ArenaPtr<NetMessage>, DecodeError> Packet::read_net_message(NothrowBitReader& reader)
+{
+    if (reader.bits_left() <= NET_MESSAGE_TYPE_BITS) {
+        return ArenaPtr<NetMessage>();
+    }
+    auto start = reader.tell();
+    auto msg_type = static_cast<NetMessage::Type>(reader.read_bits(NET_MESSAGE_TYPE_BITS));
+    auto factory = net_message_factories[static_cast<size_t>(msg_type)];
+    if (!factory) {
+        return unexpected(net_message_error(DecodeErrc::UNKNOWN_NET_MESSAGE, tick, msg_type, start));
+    }
+    stats::Timer timer(stats::net_message(msg_type));
+    auto msg = factory(memory);
+    msg->parse(reader);
+    if (reader.failed()) {
+        return unexpected(net_message_error(decode_error_code(reader.error()), tick, msg_type, start));
+    }
+    timer.stop(reader.tell() - start);
+    return msg;
+}
+
+Expected<void, DecodeError> Packet::read_net_messages(NothrowBitReader& reader, NetMessageStore& store)
+{
+    while (reader.bits_left() > NET_MESSAGE_TYPE_BITS) {
+        auto start = reader.tell();
+        auto msg_type = static_cast<NetMessage::Type>(reader.read_bits(NET_MESSAGE_TYPE_BITS));
+        if (!NetMessageStore::is_known(msg_type)) {
+            return unexpected(net_message_error(DecodeErrc::UNKNOWN_NET_MESSAGE, tick, msg_type, start));
+        }
+        stats::Timer timer(stats::net_message(msg_type));
+        auto ref = store.decode(msg_type, reader);
+        if (reader.failed()) {
+            return unexpected(net_message_error(decode_error_code(reader.error()), tick, msg_type, start));
+        }
+        net_refs.push_back(ref);
+        timer.stop(reader.tell() - start);
+    }
+    return {};
+}
 
-    while (msg_reader.bits_left() > 6) {
-        auto msg_type = static_cast<NetMessage::Type>(msg_reader.read_bits(6));
-        try {
-            auto msg = create_net_message(msg_type);
-            msg->parse(msg_reader);
-            net_messages.push_back(std::move(msg));
+Expected<void, DecodeError> Packet::index_net_messages(NothrowBitReader& reader)
+{
+    Expected<void, DecodeError> result;
+    while (reader.bits_left() > NET_MESSAGE_TYPE_BITS) {
+        auto start = reader.tell();
+        auto msg_type = static_cast<NetMessage::Type>(reader.read_bits(NET_MESSAGE_TYPE_BITS));
+        auto skip = net_message_skippers[static_cast<size_t>(msg_type)];
+        if (!skip) {
+            result = unexpected(net_message_error(DecodeErrc::UNKNOWN_NET_MESSAGE, tick, msg_type, start));
+            break;
         }
-        catch (std::exception e) {
-            std::cerr << e.what() << std::endl;
+        auto offset = reader.tell();
+        skip(reader);
+        if (reader.failed()) {
+            result = unexpected(net_message_error(decode_error_code(reader.error()), tick, msg_type, start));
             break;
         }
+        net_index.push_back({ msg_type, static_cast<uint32_t>(offset), static_cast<uint32_t>(reader.tell() - offset) });
+    }
+    net_messages.clear();
+    net_messages.resize(net_index.size());
+    return result;
+}
+
+NetMessage& Packet::net_message(size_t index)
+{
+    auto& message = net_messages.at(index);
+    if (!message) {
+        const auto& entry = net_index[index];
+        auto msg_reader = payload();
+        msg_reader.seek(entry.bit_offset);
+        stats::Timer timer(stats::net_message(entry.type));
+        auto msg = net_message_factories[static_cast<size_t>(entry.type)](memory);
+        msg->parse(msg_reader);
+        if (msg_reader.failed()) {
+            // Indexing skipped over this message fine, so the payload changed
+            // or skip and parse disagree; either way there is nothing to return.
+            std::ostringstream what;
+            what << net_message_error(decode_error_code(msg_reader.error()), tick, entry.type, entry.bit_offset - NET_MESSAGE_TYPE_BITS);
+            throw std::runtime_error(what.str());
+        }
+        timer.stop(entry.bit_length + NET_MESSAGE_TYPE_BITS);
+        message = std::move(msg);
     }
-    std::cout << "=========" << std::endl;
+    return *message;
 }
 
 void SyncTick::parse(BinaryReader& reader)
@@ -121,19 +200,19 @@ void UserCmd::parse(BinaryReader& reader)
 {
     cmd = reader.read_int32();
     auto size = reader.read_int32();
-    data = reader.read_bytes(size);
+    data = reader.read_span(size);
 }
 
 void DataTable::parse(BinaryReader& reader)
 {
     auto size = reader.read_int32();
-    data = reader.read_bytes(size);
+    data = reader.read_span(size);
 }
 
 void StringTable::parse(BinaryReader& reader)
 {
     auto size = reader.read_int32();
-    data = reader.read_bytes(size);
+    data = reader.read_span(size);
 }
 
 void Stop::parse(BinaryReader& reader)
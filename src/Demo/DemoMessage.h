@@ -1,8 +1,14 @@
 #pragma once
+#include "DecodeError.h"
 #include "NetMessage.h"
+#include "NetMessageStore.h"
 #include "structs.h"
+#include "Util/Expected.h"
 #include <vector>
 #include <memory>
+#include <span>
+#include <memory_resource>
+#include <string_view>
 
 class BinaryReader;
 
@@ -19,61 +25,103 @@ struct DemoMessage {
 		LAST_CMD = STRING_TABLES
 	};
 
-	DemoMessage(Type _type, int _tick) : type(_type), tick(_tick) {};
+	DemoMessage(Type _type, int _tick, std::pmr::memory_resource* _memory) : type(_type), tick(_tick), memory(_memory) {};
 	virtual ~DemoMessage() = default;
 	virtual void parse(BinaryReader& reader) = 0;
+	// Size of the body of a frame of the given type, which follows the type
+	// byte and tick, read from its length field. Fails if the type is unknown
+	// or the body does not fit in the bytes given, so that the frame can then
+	// be parsed without running out of input.
+	static Expected<size_t, DecodeErrc> body_size(Type type, std::span<const std::byte> rest);
 
 	Type type{};
 	int tick{};
+	// Strings, containers and net messages of the frame allocate from here
+	// (usually the demo's arena).
+	std::pmr::memory_resource* memory;
 };
 
+// Name of a frame type as in the dump, e.g. "PACKET".
+std::string_view frame_name(DemoMessage::Type type);
+
 struct Packet : public DemoMessage {
-	Packet(int tick) : DemoMessage(Type::PACKET, tick) {};
+	Packet(int tick, std::pmr::memory_resource* memory) : DemoMessage(Type::PACKET, tick, memory) {};
+	// Same as read_frame(); a frame read through the base class never decodes
+	// its net messages, which is left to the caller so errors are reported in
+	// one place.
 	void parse(BinaryReader& reader) override;
 
+	// Reads the frame fields and the payload view without decoding net messages.
+	void read_frame(BinaryReader& reader);
+	// Decodes the next net message of the payload, or returns nullptr once the
+	// payload is exhausted. Net messages carry no length, so nothing after a
+	// message that fails to decode can be found again; the error ends the
+	// payload and decoding resumes with the next frame. Errors have their tick
+	// set but not their frame offset.
+	Expected<ArenaPtr<NetMessage>, DecodeError> read_net_message(NothrowBitReader& reader);
+	// Decodes the whole payload into a columnar store, recording each message's
+	// position in net_refs instead of filling net_messages. Messages before an
+	// error are kept.
+	Expected<void, DecodeError> read_net_messages(NothrowBitReader& reader, NetMessageStore& store);
+	NothrowBitReader payload() const { return NothrowBitReader(data); }
+
 	CmdInfo cmd_info{};
 	int in_sequence{};
 	int out_sequence{};
 
-	std::vector<std::unique_ptr<NetMessage>> net_messages;
+	// Raw net message payload, a view into the demo file. The blobs of the
+	// decoded net messages point into it as well, so all of them are only
+	// valid while the owning Demo is alive.
+	std::span<const std::byte> data;
+	std::pmr::vector<ArenaPtr<NetMessage>> net_messages{ memory };
+	// Used instead of net_messages when the demo stores net messages by type.
+	std::pmr::vector<NetMessageRef> net_refs{ memory };
+
+	// Lazy decoding: index_net_messages() only records where each message is,
+	// skipping over payloads without decoding them, up to the first error.
+	// net_message(i) decodes the i-th message on first access and caches it in
+	// net_messages; it throws std::runtime_error if that fails.
+	std::pmr::vector<NetMessageIndexEntry> net_index{ memory };
+	Expected<void, DecodeError> index_net_messages(NothrowBitReader& reader);
+	NetMessage& net_message(size_t index);
 };
 
 struct SignOn : public Packet {
-	SignOn(int tick) : Packet(tick) { type = Type::SIGN_ON; };
+	SignOn(int tick, std::pmr::memory_resource* memory) : Packet(tick, memory) { type = Type::SIGN_ON; };
 };
 
 struct SyncTick : public DemoMessage {
-	SyncTick(int tick) : DemoMessage(Type::SYNC_TICK, tick) {}
+	SyncTick(int tick, std::pmr::memory_resource* memory) : DemoMessage(Type::SYNC_TICK, tick, memory) {}
 	void parse(BinaryReader& reader) override;
 };
 
 struct ConsoleCmd : public DemoMessage {
-	ConsoleCmd(int tick) : DemoMessage(Type::CONSOLE_CMD, tick) {}
+	ConsoleCmd(int tick, std::pmr::memory_resource* memory) : DemoMessage(Type::CONSOLE_CMD, tick, memory) {}
 	void parse(BinaryReader& reader) override;
-	std::string command;
+	std::pmr::string command{ memory };
 };
 
 struct UserCmd : public DemoMessage {
-	UserCmd(int tick) : DemoMessage(Type::USER_CMD, tick) {};
+	UserCmd(int tick, std::pmr::memory_resource* memory) : DemoMessage(Type::USER_CMD, tick, memory) {};
 	void parse(BinaryReader& reader) override;
 
 	int cmd{};
-	std::vector<std::byte> data;
+	std::span<const std::byte> data;
 };
 
 struct DataTable : public DemoMessage {
-	DataTable(int tick) : DemoMessage(Type::DATA_TABLES, tick) {}
+	DataTable(int tick, std::pmr::memory_resource* memory) : DemoMessage(Type::DATA_TABLES, tick, memory) {}
 	void parse(BinaryReader& reader) override;
-	std::vector<std::byte> data;
+	std::span<const std::byte> data;
 };
 
 struct StringTable : public DemoMessage {
-	StringTable(int tick) : DemoMessage(Type::STRING_TABLES, tick) {}
+	StringTable(int tick, std::pmr::memory_resource* memory) : DemoMessage(Type::STRING_TABLES, tick, memory) {}
 	void parse(BinaryReader& reader) override;
-	std::vector<std::byte> data;
+	std::span<const std::byte> data;
 };
 
 struct Stop : public DemoMessage {
-	Stop(int tick) : DemoMessage(Type::STOP, tick) {}
+	Stop(int tick, std::pmr::memory_resource* memory) : DemoMessage(Type::STOP, tick, memory) {}
 	void parse(BinaryReader& reader) override;
 };
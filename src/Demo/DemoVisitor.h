@@ -0,0 +1,30 @@
+#pragma once
+
+struct DemoHeader;
+struct DemoMessage;
+struct Packet;
+struct NetMessage;
+
+// What Demo::parse_stream should do after a callback returns.
+enum class VisitResult {
+	CONTINUE,     // keep going
+	SKIP_PACKET,  // don't decode the remaining net messages of the current packet
+	STOP          // stop parsing the demo
+};
+
+// Receives frames and net messages from Demo::parse_stream as they are decoded.
+// Objects passed to the callbacks are destroyed once the callback returns, so
+// copy out anything that has to be kept.
+class DemoVisitor {
+public:
+	virtual ~DemoVisitor() = default;
+
+	virtual VisitResult on_header(const DemoHeader& /*header*/) { return VisitResult::CONTINUE; }
+
+	// Called for every frame. Packets (and sign-on packets) arrive with their
+	// frame fields read but before any net message is decoded; returning
+	// SKIP_PACKET skips decoding them.
+	virtual VisitResult on_message(const DemoMessage& /*message*/) { return VisitResult::CONTINUE; }
+
+	virtual VisitResult on_net_message(const Packet& /*packet*/, const NetMessage& /*message*/) { return VisitResult::CONTINUE; }
+};
@@ -0,0 +1,529 @@
+#include "Demo/Entities.h"
+#include "Demo/NetMessage.h"
+#include "Util/Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+PropColumns::Kind kind_of(PropType type) {
+    switch (type) {
+    case PropType::INT:
+        return PropColumns::Kind::INT;
+    case PropType::STRING:
+        return PropColumns::Kind::STRING;
+    default:
+        return PropColumns::Kind::FLOAT;
+    }
+}
+
+uint8_t components_of(PropType type) {
+    switch (type) {
+    case PropType::VECTOR:
+        return 3;
+    case PropType::VECTOR_XY:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+int32_t read_int(UncheckedBitReader& reader, const PropDescriptor& prop) {
+    if (prop.decode == PropDecode::UINT) {
+        return static_cast<int32_t>(reader.read_bits(prop.num_bits));
+    }
+    return reader.read_signed_bits(prop.num_bits);
+}
+
+float read_float(UncheckedBitReader& reader, const PropDescriptor& prop) {
+    switch (prop.decode) {
+    case PropDecode::FLOAT_COORD:
+        return reader.read_bit_coord();
+    case PropDecode::FLOAT_COORD_MP:
+        return reader.read_bit_coord_mp(false, false);
+    case PropDecode::FLOAT_COORD_MP_LOWPRECISION:
+        return reader.read_bit_coord_mp(false, true);
+    case PropDecode::FLOAT_COORD_MP_INTEGRAL:
+        return reader.read_bit_coord_mp(true, false);
+    case PropDecode::FLOAT_NOSCALE:
+        return reader.read_float32();
+    case PropDecode::FLOAT_NORMAL:
+        return reader.read_bit_normal();
+    default: {
+        uint32_t interp = reader.read_bits(prop.num_bits);
+        float fraction = static_cast<float>(interp) / static_cast<float>((uint64_t{ 1 } << prop.num_bits) - 1);
+        return prop.low_value + (prop.high_value - prop.low_value) * fraction;
+    }
+    }
+}
+
+void read_string(UncheckedBitReader& reader, std::string& value) {
+    auto length = reader.read_bits(DT_MAX_STRING_BITS);
+    value.resize(length);
+    for (auto& c : value) {
+        c = static_cast<char>(reader.read_bits(8));
+    }
+}
+
+// Prop numbers of an entity update are deltas from the previous one. The
+// "new way" adds a one-bit form for consecutive props and a 3-bit form for
+// small gaps; 0xFFF ends the list.
+int read_field_index(UncheckedBitReader& reader, int last_index, bool new_way) {
+    if (new_way && reader.read_bit()) {
+        return last_index + 1;
+    }
+
+    uint32_t ret = 0;
+    if (new_way && reader.read_bit()) {
+        ret = reader.read_bits(3);
+    }
+    else {
+        ret = reader.read_bits(7);
+        switch (ret & (32 | 64)) {
+        case 32:
+            ret = (ret & ~96u) | (reader.read_bits(2) << 5);
+            break;
+        case 64:
+            ret = (ret & ~96u) | (reader.read_bits(4) << 5);
+            break;
+        case 96:
+            ret = (ret & ~96u) | (reader.read_bits(7) << 5);
+            break;
+        }
+    }
+
+    if (ret == 0xFFF) {
+        return -1;
+    }
+    return last_index + 1 + static_cast<int>(ret);
+}
+
+}
+
+EntityClass::EntityClass(const FlatClass& layout) : layout(&layout) {
+    uint32_t int_count = 0;
+    uint32_t float_count = 0;
+    uint32_t string_count = 0;
+    auto allocate = [&](PropColumns::Kind kind, uint32_t count) {
+        auto& counter = kind == PropColumns::Kind::INT ? int_count
+            : kind == PropColumns::Kind::FLOAT ? float_count : string_count;
+        auto first = counter;
+        counter += count;
+        return first;
+    };
+
+    columns.reserve(layout.props.size());
+    for (size_t i = 0; i < layout.props.size(); i++) {
+        const auto& prop = layout.props[i];
+        // Updates are decoded with an unchecked reader, which trusts bit
+        // counts, so widths are validated here once instead of on every read.
+        bool bad_width = prop.decode == PropDecode::INT ? prop.num_bits < 1 || prop.num_bits > 32
+            : (prop.decode == PropDecode::UINT || prop.decode == PropDecode::FLOAT_SCALED) && prop.num_bits > 32;
+        if (bad_width || prop.count_bits > 32) {
+            throw std::runtime_error("Bad bit count for prop " + layout.prop_names[i] + " of " + layout.name);
+        }
+        PropColumns prop_columns{};
+        if (prop.type == PropType::ARRAY) {
+            prop_columns.kind = kind_of(prop.element_type);
+            prop_columns.components = components_of(prop.element_type);
+            prop_columns.count = allocate(PropColumns::Kind::INT, 1);
+            prop_columns.first = allocate(prop_columns.kind, prop.num_elements * prop_columns.components);
+        }
+        else {
+            prop_columns.kind = kind_of(prop.type);
+            prop_columns.components = components_of(prop.type);
+            prop_columns.first = allocate(prop_columns.kind, prop_columns.components);
+        }
+        columns.push_back(prop_columns);
+    }
+
+    ints.resize(int_count);
+    floats.resize(float_count);
+    strings.resize(string_count);
+}
+
+std::span<const int32_t> EntityClass::int_column(int prop, int index) const {
+    const auto& prop_columns = columns.at(prop);
+    if (prop_columns.kind != PropColumns::Kind::INT) {
+        throw std::out_of_range("Prop is not an int: " + layout->prop_names[prop]);
+    }
+    return ints.at(prop_columns.first + index);
+}
+
+std::span<const float> EntityClass::float_column(int prop, int index) const {
+    const auto& prop_columns = columns.at(prop);
+    if (prop_columns.kind != PropColumns::Kind::FLOAT) {
+        throw std::out_of_range("Prop is not a float: " + layout->prop_names[prop]);
+    }
+    return floats.at(prop_columns.first + index);
+}
+
+std::span<const std::string> EntityClass::string_column(int prop, int index) const {
+    const auto& prop_columns = columns.at(prop);
+    if (prop_columns.kind != PropColumns::Kind::STRING) {
+        throw std::out_of_range("Prop is not a string: " + layout->prop_names[prop]);
+    }
+    return strings.at(prop_columns.first + index);
+}
+
+std::span<const int32_t> EntityClass::count_column(int prop) const {
+    if (layout->props.at(prop).type != PropType::ARRAY) {
+        throw std::out_of_range("Prop is not an array: " + layout->prop_names[prop]);
+    }
+    return ints[columns[prop].count];
+}
+
+uint32_t EntityClass::acquire(int entity) {
+    uint32_t row;
+    if (!free_rows.empty()) {
+        row = free_rows.back();
+        free_rows.pop_back();
+        clear_row(row);
+    }
+    else {
+        row = static_cast<uint32_t>(row_entity.size());
+        row_entity.push_back(-1);
+        for (auto& column : ints) {
+            column.push_back(0);
+        }
+        for (auto& column : floats) {
+            column.push_back(0.0f);
+        }
+        for (auto& column : strings) {
+            column.emplace_back();
+        }
+    }
+    row_entity[row] = entity;
+    return row;
+}
+
+void EntityClass::release(uint32_t row) {
+    row_entity[row] = -1;
+    free_rows.push_back(row);
+}
+
+void EntityClass::pop_row() {
+    row_entity.pop_back();
+    for (auto& column : ints) {
+        column.pop_back();
+    }
+    for (auto& column : floats) {
+        column.pop_back();
+    }
+    for (auto& column : strings) {
+        column.pop_back();
+    }
+}
+
+void EntityClass::clear_row(uint32_t row) {
+    for (auto& column : ints) {
+        column[row] = 0;
+    }
+    for (auto& column : floats) {
+        column[row] = 0.0f;
+    }
+    for (auto& column : strings) {
+        column[row].clear();
+    }
+}
+
+void EntityClass::copy_row(const EntityClass& source, uint32_t source_row, uint32_t row) {
+    for (size_t i = 0; i < ints.size(); i++) {
+        ints[i][row] = source.ints[i][source_row];
+    }
+    for (size_t i = 0; i < floats.size(); i++) {
+        floats[i][row] = source.floats[i][source_row];
+    }
+    for (size_t i = 0; i < strings.size(); i++) {
+        strings[i][row] = source.strings[i][source_row];
+    }
+}
+
+void EntityClass::read(UncheckedBitReader& reader, int prop, uint32_t row) {
+    const auto& descriptor = layout->props[prop];
+    const auto& prop_columns = columns[prop];
+    if (descriptor.type != PropType::ARRAY) {
+        read_value(reader, descriptor, descriptor.type, prop_columns.first, row);
+        return;
+    }
+
+    auto count = static_cast<int>(reader.read_bits(descriptor.count_bits));
+    if (count > descriptor.num_elements) {
+        throw std::runtime_error("Array prop has too many elements: " + layout->prop_names[prop]);
+    }
+    ints[prop_columns.count][row] = count;
+    for (int element = 0; element < count; element++) {
+        read_value(reader, descriptor, descriptor.element_type, prop_columns.first + element * prop_columns.components, row);
+    }
+}
+
+void EntityClass::read_value(UncheckedBitReader& reader, const PropDescriptor& prop, PropType type, uint32_t column, uint32_t row) {
+    switch (type) {
+    case PropType::INT:
+        ints[column][row] = read_int(reader, prop);
+        break;
+    case PropType::FLOAT:
+        floats[column][row] = read_float(reader, prop);
+        break;
+    case PropType::VECTOR: {
+        float x = read_float(reader, prop);
+        float y = read_float(reader, prop);
+        float z;
+        if (prop.decode == PropDecode::FLOAT_NORMAL) {
+            // Only the sign of z is sent for unit vectors.
+            bool negative = reader.read_bool();
+            float length_sqr = x * x + y * y;
+            z = length_sqr < 1.0f ? std::sqrt(1.0f - length_sqr) : 0.0f;
+            if (negative) z = -z;
+        }
+        else {
+            z = read_float(reader, prop);
+        }
+        floats[column][row] = x;
+        floats[column + 1][row] = y;
+        floats[column + 2][row] = z;
+        break;
+    }
+    case PropType::VECTOR_XY:
+        floats[column][row] = read_float(reader, prop);
+        floats[column + 1][row] = read_float(reader, prop);
+        break;
+    case PropType::STRING:
+        read_string(reader, strings[column][row]);
+        break;
+    default:
+        throw std::runtime_error("Unsupported prop type: " + std::to_string(static_cast<int>(type)));
+    }
+}
+
+size_t EntityClass::read_props(UncheckedBitReader& reader, uint32_t row, std::vector<int>& changed) {
+    bool new_way = reader.read_bool();
+    changed.clear();
+    int prop = -1;
+    while ((prop = read_field_index(reader, prop, new_way)) != -1) {
+        if (static_cast<size_t>(prop) >= columns.size()) {
+            throw std::runtime_error("Prop index out of range for " + layout->name + ": " + std::to_string(prop));
+        }
+        changed.push_back(prop);
+    }
+
+    for (int changed_prop : changed) {
+        read(reader, changed_prop, row);
+    }
+    return changed.size();
+}
+
+void BaselineCache::set(int class_id, std::span<const std::byte> data) {
+    if (class_id < 0) {
+        return;
+    }
+    if (static_cast<size_t>(class_id) >= entries.size()) {
+        entries.resize(class_id + 1);
+    }
+    auto& entry = entries[class_id];
+    if (std::equal(data.begin(), data.end(), entry.data.begin(), entry.data.end())) {
+        return;
+    }
+    entry.data.assign(data.begin(), data.end());
+    entry.decoded.reset();
+}
+
+void BaselineCache::invalidate() {
+    for (auto& entry : entries) {
+        entry.decoded.reset();
+    }
+}
+
+void BaselineCache::clear() {
+    entries.clear();
+    decodes = 0;
+}
+
+const EntityClass* BaselineCache::get(const FlatClass& layout) {
+    if (layout.id < 0 || static_cast<size_t>(layout.id) >= entries.size()) {
+        return nullptr;
+    }
+    auto& entry = entries[layout.id];
+    if (entry.decoded) {
+        return entry.decoded.get();
+    }
+    if (entry.data.empty()) {
+        return nullptr;
+    }
+
+    entry.decoded = std::make_unique<EntityClass>(layout);
+    auto row = entry.decoded->acquire(-1);
+    decodes++;
+    UncheckedBitReader reader(entry.data);
+    try {
+        entry.decoded->read_props(reader, row, changed_props);
+        if (reader.failed()) {
+            throw std::runtime_error("Baseline runs past its length");
+        }
+    }
+    catch (const std::exception& e) {
+        // Keep the zeroed row so a broken baseline is reported only once.
+        entry.decoded->clear_row(row);
+        trace::log() << "Bad instance baseline for " << layout.name << ": " << e.what() << std::endl;
+    }
+    return entry.decoded.get();
+}
+
+void Entities::reset(std::shared_ptr<const DataTables> tables) {
+    data_tables = std::move(tables);
+    classes.clear();
+    if (data_tables) {
+        classes.resize(data_tables->flat_classes.size());
+    }
+    slots.fill({});
+    props_decoded = 0;
+    baselines.invalidate();
+}
+
+void Entities::apply(const SvcPacketEntities& message) {
+    if (!data_tables) {
+        throw std::runtime_error("Entity update without data tables");
+    }
+
+    // A full update lists every entity the client should have.
+    if (!message.is_delta) {
+        for (int index = 0; index < MAX_EDICTS; index++) {
+            if (slots[index].exists()) {
+                remove(index);
+            }
+        }
+    }
+
+    // The payload length was checked against the packet when the message was
+    // parsed, so props are decoded without per-read bounds checks and an
+    // overrun is caught once per entity instead.
+    UncheckedBitReader reader(message.data);
+    int index = -1;
+    for (int i = 0; i < message.updated_entries; i++) {
+        auto increment = reader.read_ubit_var();
+        if (increment >= static_cast<uint32_t>(MAX_EDICTS - 1 - index)) {
+            throw std::runtime_error("Entity index out of range after " + std::to_string(index));
+        }
+        index += 1 + static_cast<int>(increment);
+
+        if (!reader.read_bit()) {
+            if (reader.read_bit()) {
+                enter_pvs(reader, index);
+            }
+            else {
+                if (!slots[index].exists()) {
+                    throw std::runtime_error("Delta for missing entity " + std::to_string(index));
+                }
+                read_props(reader, index);
+            }
+            if (reader.failed()) {
+                throw std::runtime_error("Entity update runs past its length at " + std::to_string(index));
+            }
+        }
+        else {
+            bool deleted = reader.read_bit();
+            if (slots[index].exists()) {
+                if (deleted) {
+                    remove(index);
+                }
+                else {
+                    slots[index].in_pvs = false;
+                }
+            }
+        }
+    }
+
+    // Deltas end with the entities deleted since the frame they are based on.
+    if (message.is_delta) {
+        while (reader.bits_left() > 0 && reader.read_bit()) {
+            int deleted = static_cast<int>(reader.read_bits(MAX_EDICT_BITS));
+            if (slots[deleted].exists()) {
+                remove(deleted);
+            }
+        }
+    }
+}
+
+const EntityClass* Entities::find_class(int class_id) const {
+    if (class_id < 0 || static_cast<size_t>(class_id) >= classes.size()) {
+        return nullptr;
+    }
+    return classes[class_id].get();
+}
+
+const EntityClass* Entities::find_class(std::string_view name) const {
+    for (const auto& state : classes) {
+        if (state && state->layout->name == name) {
+            return state.get();
+        }
+    }
+    return nullptr;
+}
+
+int32_t Entities::get_int(int index, int prop, int element) const {
+    return entity_class(index).int_column(prop, element)[slots[index].row];
+}
+
+float Entities::get_float(int index, int prop, int component) const {
+    return entity_class(index).float_column(prop, component)[slots[index].row];
+}
+
+const std::string& Entities::get_string(int index, int prop, int element) const {
+    return entity_class(index).string_column(prop, element)[slots[index].row];
+}
+
+EntityClass& Entities::class_state(int class_id) {
+    auto& state = classes[class_id];
+    if (!state) {
+        state = std::make_unique<EntityClass>(data_tables->flat_classes[class_id]);
+    }
+    return *state;
+}
+
+const EntityClass& Entities::entity_class(int index) const {
+    const auto& slot = slots.at(index);
+    if (!slot.exists()) {
+        throw std::out_of_range("No entity at index " + std::to_string(index));
+    }
+    return *classes[slot.class_id];
+}
+
+void Entities::enter_pvs(UncheckedBitReader& reader, int index) {
+    auto class_id = static_cast<int>(reader.read_bits(data_tables->class_bits));
+    auto serial = static_cast<int>(reader.read_bits(NUM_NETWORKED_EHANDLE_SERIAL_NUMBER_BITS));
+    if (static_cast<size_t>(class_id) >= classes.size()) {
+        throw std::runtime_error("Unknown entity class " + std::to_string(class_id));
+    }
+
+    auto& slot = slots[index];
+    if (slot.exists() && (slot.class_id != class_id || slot.serial != serial)) {
+        remove(index);
+    }
+    auto& state = class_state(class_id);
+    if (!slot.exists()) {
+        slot.class_id = class_id;
+        slot.serial = serial;
+        slot.row = state.acquire(index);
+    }
+    // Re-entering the PVS starts over from the baseline as well.
+    if (const auto* baseline = baselines.get(*state.layout)) {
+        state.copy_row(*baseline, 0, slot.row);
+    }
+    else {
+        state.clear_row(slot.row);
+    }
+    slot.in_pvs = true;
+    read_props(reader, index);
+}
+
+void Entities::read_props(UncheckedBitReader& reader, int index) {
+    const auto& slot = slots[index];
+    props_decoded += classes[slot.class_id]->read_props(reader, slot.row, changed_props);
+}
+
+void Entities::remove(int index) {
+    auto& slot = slots[index];
+    classes[slot.class_id]->release(slot.row);
+    slot = {};
+}
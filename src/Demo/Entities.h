@@ -0,0 +1,164 @@
+#pragma once
+#include "DataTables.h"
+#include "Util/BitReader.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct SvcPacketEntities;
+
+constexpr int MAX_EDICT_BITS = 11;
+constexpr int MAX_EDICTS = 1 << MAX_EDICT_BITS;
+constexpr int NUM_NETWORKED_EHANDLE_SERIAL_NUMBER_BITS = 10;
+constexpr int DT_MAX_STRING_BITS = 9;
+
+// Where the values of one flattened prop are kept in an EntityClass.
+struct PropColumns {
+    enum class Kind : uint8_t { INT, FLOAT, STRING };
+
+    // Kind of every value; for arrays, of every element.
+    Kind kind;
+    // Columns per value: 3 for vectors, 2 for VECTOR_XY, 1 otherwise.
+    uint8_t components;
+    // First column of the prop among the columns of its kind. Component c of
+    // array element e is at first + e * components + c.
+    uint32_t first;
+    // ARRAY props: the int column holding the element count.
+    uint32_t count;
+};
+
+// Every entity of one server class, stored column-wise: each prop value (each
+// vector component, each array element) has its own contiguous column and
+// each entity is a row across all of them. Reading one prop for every player
+// is then a linear scan of one column.
+class EntityClass {
+public:
+    explicit EntityClass(const FlatClass& layout);
+
+    const FlatClass* layout;
+    // Indexed like layout->props.
+    std::vector<PropColumns> columns;
+    std::vector<std::vector<int32_t>> ints;
+    std::vector<std::vector<float>> floats;
+    std::vector<std::vector<std::string>> strings;
+    // Entity index that owns each row, -1 for free rows. Free rows keep stale
+    // values in every column.
+    std::vector<int32_t> row_entity;
+
+    size_t rows() const { return row_entity.size(); }
+
+    // Column of a prop value; index selects the component and array element
+    // as in PropColumns::first. Throws std::out_of_range on a kind mismatch.
+    std::span<const int32_t> int_column(int prop, int index = 0) const;
+    std::span<const float> float_column(int prop, int index = 0) const;
+    std::span<const std::string> string_column(int prop, int index = 0) const;
+    // Element counts of an ARRAY prop.
+    std::span<const int32_t> count_column(int prop) const;
+
+    // Takes a free row, or adds one, for entity and resets it to zero values.
+    uint32_t acquire(int entity);
+    void release(uint32_t row);
+    // Removes the last row, which must not be on the free list.
+    void pop_row();
+    void clear_row(uint32_t row);
+    // Copies every value of a row of source, which must have the same layout.
+    void copy_row(const EntityClass& source, uint32_t source_row, uint32_t row);
+    // Decodes one prop value from an entity update into row.
+    void read(UncheckedBitReader& reader, int prop, uint32_t row);
+    // Decodes the prop list of an entity update or baseline into row and
+    // returns how many props it held. changed is scratch space.
+    size_t read_props(UncheckedBitReader& reader, uint32_t row, std::vector<int>& changed);
+
+private:
+    std::vector<uint32_t> free_rows;
+
+    void read_value(UncheckedBitReader& reader, const PropDescriptor& prop, PropType type, uint32_t column, uint32_t row);
+};
+
+// Instance baselines, the state an entity of a class starts from. The
+// encoded baseline of a class is decoded once, on the first creation after
+// it was set, and every creation copies the decoded row instead of decoding
+// the blob again.
+class BaselineCache {
+public:
+    // Stores the encoded baseline of a class. Drops the decoded one only if
+    // the bytes differ from what is already stored.
+    void set(int class_id, std::span<const std::byte> data);
+    // Drops decoded baselines but keeps the blobs, for when the class layouts
+    // change.
+    void invalidate();
+    void clear();
+
+    // Decoded baseline of a class as row 0 of the returned EntityClass, or
+    // nullptr if none was set. A blob that does not decode is logged once and
+    // yields zero values.
+    const EntityClass* get(const FlatClass& layout);
+
+    // Baselines decoded since the last clear().
+    uint64_t decodes = 0;
+
+private:
+    struct Entry {
+        std::vector<std::byte> data;
+        std::unique_ptr<EntityClass> decoded;
+    };
+    // Indexed by class id.
+    std::vector<Entry> entries;
+    std::vector<int> changed_props;
+};
+
+// An entity index as seen by the client.
+struct EntitySlot {
+    // -1 while the index is unused.
+    int class_id = -1;
+    int serial = 0;
+    uint32_t row = 0;
+    bool in_pvs = false;
+
+    bool exists() const { return class_id >= 0; }
+};
+
+// Entity state rebuilt from svc_packet_entities updates. Only the props an
+// update lists are decoded and written; everything else keeps its value.
+class Entities {
+public:
+    // Binds to a new set of tables and drops every entity.
+    void reset(std::shared_ptr<const DataTables> tables);
+    // Applies creates, deltas, leave-PVS and deletes of one update. Throws
+    // std::runtime_error if the update is malformed or refers to entities or
+    // classes that do not exist; entities before the error stay applied.
+    void apply(const SvcPacketEntities& message);
+
+    const DataTables* tables() const { return data_tables.get(); }
+    const EntitySlot& operator[](int index) const { return slots.at(index); }
+    // nullptr until an entity of the class has been created.
+    const EntityClass* find_class(int class_id) const;
+    const EntityClass* find_class(std::string_view name) const;
+
+    // Prop values of one entity. The entity must exist.
+    int32_t get_int(int index, int prop, int element = 0) const;
+    float get_float(int index, int prop, int component = 0) const;
+    const std::string& get_string(int index, int prop, int element = 0) const;
+
+    // Prop values decoded since the last reset().
+    uint64_t props_decoded = 0;
+    // Kept across reset(), which only drops the decoded baselines.
+    BaselineCache baselines;
+
+private:
+    std::shared_ptr<const DataTables> data_tables;
+    // Indexed by class id, created on first use.
+    std::vector<std::unique_ptr<EntityClass>> classes;
+    std::array<EntitySlot, MAX_EDICTS> slots{};
+    std::vector<int> changed_props;
+
+    EntityClass& class_state(int class_id);
+    const EntityClass& entity_class(int index) const;
+    void enter_pvs(UncheckedBitReader& reader, int index);
+    void read_props(UncheckedBitReader& reader, int index);
+    void remove(int index);
+};
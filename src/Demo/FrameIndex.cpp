@@ -0,0 +1,115 @@
+#include "Demo/FrameIndex.h"
+#include "Util/BinaryReader.h"
+#include "Util/Hash.h"
+#include "Util/MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+// Sidecar layout, little-endian:
+//   magic[8] version:u32 file_size:u64 file_hash:u64 signon_end:u32 data_tables:u32
+//   frame_count:u32 { tick:i32 type:u8 offset:u64 }*
+//   string_table_count:u32 { frame:u32 }*  full_update_count:u32 { frame:u32 }*
+constexpr char INDEX_MAGIC[8] = { 'D', 'E', 'M', 'O', 'I', 'D', 'X', '\0' };
+constexpr uint32_t INDEX_VERSION = 1;
+
+template <typename T>
+void write_value(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void write_positions(std::ofstream& out, const std::vector<uint32_t>& positions) {
+    write_value(out, static_cast<uint32_t>(positions.size()));
+    out.write(reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(uint32_t));
+}
+
+std::vector<uint32_t> read_positions(BinaryReader& reader, size_t frame_count) {
+    std::vector<uint32_t> positions(reader.read_uint32());
+    for (auto& position : positions) {
+        position = reader.read_uint32();
+        if (position >= frame_count) {
+            throw std::runtime_error("Frame index position out of range.");
+        }
+    }
+    return positions;
+}
+
+}
+
+std::optional<FrameIndex> FrameIndex::load(const std::string& path, std::span<const std::byte> demo_bytes) {
+    FrameIndex index;
+    try {
+        MappedFile file(path);
+        BinaryReader reader(file.bytes());
+
+        auto magic = reader.read_span(sizeof(INDEX_MAGIC));
+        if (std::memcmp(magic.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || reader.read_uint32() != INDEX_VERSION) {
+            return std::nullopt;
+        }
+        index.file_size = reader.read_uint64();
+        index.file_hash = reader.read_uint64();
+        // Size first: it rules out most stale sidecars without reading the demo.
+        if (index.file_size != demo_bytes.size() || index.file_hash != hash64(demo_bytes)) {
+            return std::nullopt;
+        }
+        index.signon_end = reader.read_uint32();
+        index.data_tables = reader.read_uint32();
+
+        index.frames.resize(reader.read_uint32());
+        for (auto& frame : index.frames) {
+            frame.tick = reader.read_int32();
+            frame.type = static_cast<DemoMessage::Type>(reader.read_byte());
+            frame.offset = reader.read_uint64();
+            if (frame.offset >= demo_bytes.size()) {
+                return std::nullopt;
+            }
+        }
+        index.string_tables = read_positions(reader, index.frames.size());
+        index.full_updates = read_positions(reader, index.frames.size());
+    }
+    catch (const std::exception&) {
+        return std::nullopt;
+    }
+    return index;
+}
+
+void FrameIndex::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Error opening frame index for writing: " + path);
+    }
+
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    write_value(out, INDEX_VERSION);
+    write_value(out, file_size);
+    write_value(out, file_hash);
+    write_value(out, signon_end);
+    write_value(out, data_tables);
+
+    write_value(out, static_cast<uint32_t>(frames.size()));
+    for (const auto& frame : frames) {
+        write_value(out, frame.tick);
+        write_value(out, static_cast<uint8_t>(frame.type));
+        write_value(out, frame.offset);
+    }
+    write_positions(out, string_tables);
+    write_positions(out, full_updates);
+
+    if (!out) {
+        throw std::runtime_error("Error writing frame index: " + path);
+    }
+}
+
+uint32_t FrameIndex::find(int tick) const {
+    auto it = std::lower_bound(frames.begin(), frames.end(), tick,
+        [](const FrameIndexEntry& frame, int tick) { return frame.tick < tick; });
+    return static_cast<uint32_t>(it - frames.begin());
+}
+
+uint32_t FrameIndex::last_before(const std::vector<uint32_t>& positions, uint32_t frame) {
+    auto it = std::lower_bound(positions.begin(), positions.end(), frame);
+    return it == positions.begin() ? NO_FRAME : *std::prev(it);
+}
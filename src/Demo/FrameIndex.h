@@ -0,0 +1,48 @@
+#pragma once
+#include "DemoMessage.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Where one frame starts: the offset of its command byte in the demo file.
+struct FrameIndexEntry {
+    int32_t tick;
+    DemoMessage::Type type;
+    uint64_t offset;
+};
+
+// Every frame of a demo in file order, plus the frames needed to rebuild state
+// when playback starts in the middle: the sign-on frames, the data tables, the
+// string table snapshots and the packets carrying a full (non-delta)
+// svc_packet_entities update. Positions below are indices into frames.
+//
+// The index is persisted next to the demo as a sidecar file and is only
+// trusted again if the demo's size and hash still match.
+class FrameIndex {
+public:
+    static constexpr uint32_t NO_FRAME = UINT32_MAX;
+
+    uint64_t file_size = 0;
+    uint64_t file_hash = 0;
+    std::vector<FrameIndexEntry> frames;
+    // Number of leading frames that make up the sign-on, up to the first packet.
+    uint32_t signon_end = 0;
+    uint32_t data_tables = NO_FRAME;
+    std::vector<uint32_t> string_tables;
+    std::vector<uint32_t> full_updates;
+
+    static std::string sidecar_path(const std::string& demo_path) { return demo_path + ".idx"; }
+
+    // Reads a sidecar written by save(). Returns nullopt if it is missing,
+    // malformed or was built from a different demo than demo_bytes.
+    static std::optional<FrameIndex> load(const std::string& path, std::span<const std::byte> demo_bytes);
+    void save(const std::string& path) const;
+
+    // First frame with a tick at or after tick, or frames.size() if there is none.
+    uint32_t find(int tick) const;
+    // Last of the given positions that lies before frame, or NO_FRAME.
+    static uint32_t last_before(const std::vector<uint32_t>& positions, uint32_t frame);
+};
@@ -0,0 +1,148 @@
+#include "Demo/GameEvents.h"
+#include "Demo/NetMessage.h"
+#include <stdexcept>
+
+namespace {
+
+constexpr int KEY_TYPE_BITS = 3;
+constexpr int NAME_LIMIT = 256;
+
+}
+
+int GameEventDescriptor::find(std::string_view key) const {
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == key) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::string_view GameEvent::get_string(int key) const {
+    const auto& value = values[key];
+    return std::string_view(text).substr(value.text_begin, value.text_end - value.text_begin);
+}
+
+int GameEvent::key_index(std::string_view key) const {
+    int index = descriptor ? descriptor->find(key) : -1;
+    if (index < 0) {
+        throw std::out_of_range("Game event has no key " + std::string(key));
+    }
+    return index;
+}
+
+void GameEvent::decode(const GameEventDescriptor& event_descriptor, BitReader& reader) {
+    descriptor = &event_descriptor;
+    values.resize(event_descriptor.types.size());
+    text.clear();
+
+    for (size_t i = 0; i < event_descriptor.types.size(); i++) {
+        auto& value = values[i];
+        value.integer = 0;
+        value.real = 0.0f;
+        value.text_begin = value.text_end = static_cast<uint32_t>(text.size());
+        switch (event_descriptor.types[i]) {
+        case GameEventKeyType::STRING:
+            while (char c = static_cast<char>(reader.read_bits(8))) {
+                text.push_back(c);
+            }
+            value.text_end = static_cast<uint32_t>(text.size());
+            break;
+        case GameEventKeyType::FLOAT:
+            value.real = reader.read_float32();
+            break;
+        case GameEventKeyType::LONG:
+            value.integer = reader.read_signed_bits(32);
+            break;
+        case GameEventKeyType::SHORT:
+            value.integer = reader.read_signed_bits(16);
+            break;
+        case GameEventKeyType::BYTE:
+            value.integer = static_cast<int32_t>(reader.read_bits(8));
+            break;
+        case GameEventKeyType::BOOL:
+            value.integer = reader.read_bit();
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void GameEvents::parse_list(const SvcGameEventList& message) {
+    descriptors.assign(MAX_EVENT_NUMBER, {});
+    by_name.clear();
+
+    BitReader reader = message.data;
+    std::string name;
+    for (int i = 0; i < message.events; i++) {
+        auto id = static_cast<int>(reader.read_bits(MAX_EVENT_BITS));
+        reader.read_ascii_string(name, NAME_LIMIT);
+        auto& descriptor = descriptors[id];
+        descriptor.id = id;
+        descriptor.name = names.intern(name);
+        descriptor.types.clear();
+        descriptor.keys.clear();
+
+        for (auto type = reader.read_bits(KEY_TYPE_BITS); type != 0; type = reader.read_bits(KEY_TYPE_BITS)) {
+            if (type > static_cast<uint32_t>(GameEventKeyType::BOOL)) {
+                throw std::runtime_error("Unknown key type " + std::to_string(type) + " in game event " + name);
+            }
+            reader.read_ascii_string(name, NAME_LIMIT);
+            descriptor.types.push_back(static_cast<GameEventKeyType>(type));
+            descriptor.keys.push_back(names.intern(name));
+        }
+        by_name[descriptor.name] = id;
+    }
+
+    handlers.assign(MAX_EVENT_NUMBER, {});
+    for (size_t i = 0; i < subscriptions.size(); i++) {
+        bind(i);
+    }
+}
+
+void GameEvents::subscribe(std::string_view name, Handler handler) {
+    subscriptions.push_back({ std::string(name), std::move(handler) });
+    bind(subscriptions.size() - 1);
+}
+
+bool GameEvents::dispatch(const SvcGameEvent& message, int tick) {
+    if (handlers.empty()) {
+        return false;
+    }
+    BitReader reader = message.data;
+    auto id = reader.read_bits(MAX_EVENT_BITS);
+    const auto& bound = handlers[id];
+    if (bound.empty()) {
+        return false;
+    }
+    if (descriptors[id].id < 0) {
+        throw std::runtime_error("Unknown game event id " + std::to_string(id));
+    }
+
+    record.tick = tick;
+    record.decode(descriptors[id], reader);
+    for (auto subscription : bound) {
+        subscriptions[subscription].handler(record);
+    }
+    dispatched++;
+    return true;
+}
+
+const GameEventDescriptor* GameEvents::find(int id) const {
+    if (id < 0 || static_cast<size_t>(id) >= descriptors.size() || descriptors[id].id < 0) {
+        return nullptr;
+    }
+    return &descriptors[id];
+}
+
+const GameEventDescriptor* GameEvents::find(std::string_view name) const {
+    auto found = by_name.find(name);
+    return found != by_name.end() ? &descriptors[found->second] : nullptr;
+}
+
+void GameEvents::bind(size_t subscription) {
+    if (const auto* descriptor = find(subscriptions[subscription].name)) {
+        handlers[descriptor->id].push_back(subscription);
+    }
+}
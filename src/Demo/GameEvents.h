@@ -0,0 +1,123 @@
+#pragma once
+#include "Util/BitReader.h"
+#include "Util/StringPool.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct SvcGameEventList;
+struct SvcGameEvent;
+
+constexpr int MAX_EVENT_BITS = 9;
+constexpr int MAX_EVENT_NUMBER = 1 << MAX_EVENT_BITS;
+
+// Key types as numbered on the wire. LOCAL keys are never networked and end
+// a descriptor's key list.
+enum class GameEventKeyType : uint8_t {
+    LOCAL,
+    STRING,
+    FLOAT,
+    LONG,
+    SHORT,
+    BYTE,
+    BOOL
+};
+
+struct GameEventDescriptor {
+    int id = -1;
+    std::string_view name;
+    // Wire order. Types are kept apart from names so the decode loop only
+    // walks one byte per key.
+    std::vector<GameEventKeyType> types;
+    std::vector<std::string_view> keys;
+
+    // Index of a key, or -1.
+    int find(std::string_view key) const;
+};
+
+// One decoded event. Records are meant to be reused: decoding into a record
+// that has held an event before allocates nothing once its buffers are large
+// enough.
+class GameEvent {
+public:
+    const GameEventDescriptor* descriptor = nullptr;
+    int tick = 0;
+
+    // Values by key index. Integer keys of every width are widened to int;
+    // get_int() of a BOOL key is 0 or 1.
+    int get_int(int key) const { return values[key].integer; }
+    float get_float(int key) const { return values[key].real; }
+    bool get_bool(int key) const { return values[key].integer != 0; }
+    std::string_view get_string(int key) const;
+
+    // Values by key name, for occasional lookups. Throws std::out_of_range if
+    // the event has no such key.
+    int get_int(std::string_view key) const { return get_int(key_index(key)); }
+    float get_float(std::string_view key) const { return get_float(key_index(key)); }
+    bool get_bool(std::string_view key) const { return get_bool(key_index(key)); }
+    std::string_view get_string(std::string_view key) const { return get_string(key_index(key)); }
+
+    // Reads the keys of descriptor from reader, which must be positioned
+    // right after the event id.
+    void decode(const GameEventDescriptor& event_descriptor, BitReader& reader);
+
+private:
+    struct Value {
+        int32_t integer;
+        float real;
+        // STRING keys: range in text.
+        uint32_t text_begin;
+        uint32_t text_end;
+    };
+    std::vector<Value> values;
+    // Every string value of the event, back to back.
+    std::string text;
+
+    int key_index(std::string_view key) const;
+};
+
+// Game event descriptors from svc_game_event_list, and dispatch of
+// svc_game_event to handlers subscribed by event name. Events nobody
+// subscribed to are skipped after reading their id.
+class GameEvents {
+public:
+    using Handler = std::function<void(const GameEvent&)>;
+
+    // Replaces the descriptors. Throws std::runtime_error on malformed data.
+    void parse_list(const SvcGameEventList& message);
+    // Handlers can be added before the list arrives; they are bound to event
+    // ids when it does.
+    void subscribe(std::string_view name, Handler handler);
+    bool has_subscriptions() const { return !subscriptions.empty(); }
+
+    // Decodes the event and calls its handlers if it has any. Returns whether
+    // it was decoded. Throws std::runtime_error for unknown event ids or
+    // malformed data.
+    bool dispatch(const SvcGameEvent& message, int tick);
+
+    const GameEventDescriptor* find(int id) const;
+    const GameEventDescriptor* find(std::string_view name) const;
+
+    // Events decoded and handed to handlers so far.
+    uint64_t dispatched = 0;
+
+private:
+    struct Subscription {
+        std::string name;
+        Handler handler;
+    };
+
+    StringPool names;
+    // Indexed by event id; id -1 marks unused ids.
+    std::vector<GameEventDescriptor> descriptors;
+    std::unordered_map<std::string_view, int> by_name;
+    std::vector<Subscription> subscriptions;
+    // Per event id, indices into subscriptions.
+    std::vector<std::vector<size_t>> handlers;
+    GameEvent record;
+
+    void bind(size_t subscription);
+};
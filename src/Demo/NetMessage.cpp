@@ -1,34 +1,102 @@
 #include "NetMessage.h"
 #include "Util/BitReader.h"
 #include "Util/math.h"
+#include "Util/Trace.h"
 #include <iostream>
 #include <iomanip>
 
-void NetNop::parse(BitReader& reader) {
-	std::cout << "NetNop" << std::endl;
+std::string_view net_message_name(NetMessage::Type type) {
+	switch (type) {
+	case NetMessage::Type::net_nop: return "NetNop";
+	case NetMessage::Type::net_disconnect: return "NetDisconnect";
+	case NetMessage::Type::net_file: return "NetFile";
+	case NetMessage::Type::net_tick: return "NetTick";
+	case NetMessage::Type::net_string_cmd: return "NetStringCmd";
+	case NetMessage::Type::net_set_con_var: return "NetSetConVar";
+	case NetMessage::Type::net_signon_state: return "NetSignonState";
+	case NetMessage::Type::svc_print: return "SvcPrint";
+	case NetMessage::Type::svc_server_info: return "SvcServerInfo";
+	case NetMessage::Type::svc_send_table: return "SvcSendTable";
+	case NetMessage::Type::svc_class_info: return "SvcClassInfo";
+	case NetMessage::Type::svc_set_pause: return "SvcSetPause";
+	case NetMessage::Type::svc_create_string_table: return "SvcCreateStringTable";
+	case NetMessage::Type::svc_update_string_table: return "SvcUpdateStringTable";
+	case NetMessage::Type::svc_voice_init: return "SvcVoiceInit";
+	case NetMessage::Type::svc_voice_data: return "SvcVoiceData";
+	case NetMessage::Type::svc_sounds: return "SvcSounds";
+	case NetMessage::Type::svc_set_view: return "SvcSetView";
+	case NetMessage::Type::svc_fix_angle: return "SvcFixAngle";
+	case NetMessage::Type::svc_crosshair_angle: return "SvcCrosshairAngle";
+	case NetMessage::Type::svc_bsp_decal: return "SvcBSPDecal";
+	case NetMessage::Type::svc_user_message: return "SvcUserMessage";
+	case NetMessage::Type::svc_entity_message: return "SvcEntityMessage";
+	case NetMessage::Type::svc_game_event: return "SvcGameEvent";
+	case NetMessage::Type::svc_packet_entities: return "SvcPacketEntities";
+	case NetMessage::Type::svc_temp_entities: return "SvcTempEntities";
+	case NetMessage::Type::svc_prefetch: return "SvcPrefetch";
+	case NetMessage::Type::svc_menu: return "SvcMenu";
+	case NetMessage::Type::svc_game_event_list: return "SvcGameEventList";
+	case NetMessage::Type::svc_get_cvar_value: return "SvcGetCvarValue";
+	case NetMessage::Type::svc_cmd_key_values: return "SvcCmdKeyValues";
+	case NetMessage::Type::svc_set_pause_timed: return "SvcSetPauseTimed";
+	}
+	return {};
+}
+
+void NetNop::parse(NothrowBitReader& reader) {
+	if (auto* out = trace::stream()) {
+		*out << "NetNop" << '\n';
+	}
+}
+
+void NetNop::skip(NothrowBitReader& reader)
+{
 }
 
-void NetDisconnect::parse(BitReader& reader) {
-	text = reader.read_ascii_string(1024);
+void NetDisconnect::parse(NothrowBitReader& reader) {
+	reader.read_ascii_string(text, 1024);
 
-	std::cout << "NetDisconnect: " << text << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "NetDisconnect: " << text << '\n';
+	}
 }
 
-void NetFile::parse(BitReader& reader)
+void NetDisconnect::skip(NothrowBitReader& reader)
+{
+	reader.skip_ascii_string(1024);
+}
+
+void NetFile::parse(NothrowBitReader& reader)
 {
 	transfer_id = reader.read_int32();
-	file_name = reader.read_ascii_string();
+	reader.read_ascii_string(file_name);
 	file_requested = reader.read_bit();
 
-	std::cout << "NetFile: transfer_id=" << transfer_id << ", file_name=" << file_name << ", file_requested=" << file_requested << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "NetFile: transfer_id=" << transfer_id << ", file_name=" << file_name << ", file_requested=" << file_requested << '\n';
+	}
+}
+
+void NetFile::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(32);
+	reader.skip_ascii_string();
+	reader.skip_bits(1);
 }
 
-void NetTick::parse(BitReader& reader)
+void NetTick::parse(NothrowBitReader& reader)
 {
 	tick = reader.read_int32();
 	host_frame_time = reader.read_uint16() / SCALEUP;
 	host_frame_time_std_deviation = reader.read_uint16() / SCALEUP;
-	std::cout << "NetTick: tick=" << tick << ", host_frame_time=" << host_frame_time << ", host_frame_time_std_deviation=" << host_frame_time_std_deviation << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "NetTick: tick=" << tick << ", host_frame_time=" << host_frame_time << ", host_frame_time_std_deviation=" << host_frame_time_std_deviation << '\n';
+	}
+}
+
+void NetTick::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(32 + 16 + 16);
 }
 
 void NetTick::print()
@@ -40,38 +108,72 @@ void NetTick::print()
 		<< std::setw(30) << "Host Frame Time Std Deviation: " << host_frame_time_std_deviation << std::endl;
 }
 
-void NetStringCmd::parse(BitReader& reader)
+void NetStringCmd::parse(NothrowBitReader& reader)
 {
-	command = reader.read_ascii_string(1024);
-	std::cout << "NetStringCmd: " << command << std::endl;
+	reader.read_ascii_string(command, 1024);
+	if (auto* out = trace::stream()) {
+		*out << "NetStringCmd: " << command << '\n';
+	}
 }
 
-void NetSetConVar::parse(BitReader& reader) {
+void NetStringCmd::skip(NothrowBitReader& reader)
+{
+	reader.skip_ascii_string(1024);
+}
+
+void NetSetConVar::parse(NothrowBitReader& reader) {
     int length = reader.read_bits(8);
-    std::cout << "NetSetConVar: NumConVars=" << length << std::endl;
+    if (auto* out = trace::stream()) {
+        *out << "NetSetConVar: NumConVars=" << length << '\n';
+    }
     for (auto i = 0; i < length; i++) {
-        ConVar convar{};
-        convar.name = reader.read_ascii_string();
-        convar.value = reader.read_ascii_string();
-        convars.push_back(convar);
-        std::cout << "  ConVar " << i << ": " << convar.name << "=" << convar.value << std::endl;
+        ConVar convar{ std::pmr::string(memory), std::pmr::string(memory) };
+        reader.read_ascii_string(convar.name);
+        reader.read_ascii_string(convar.value);
+        if (auto* out = trace::stream()) {
+            *out << "  ConVar " << i << ": " << convar.name << "=" << convar.value << '\n';
+        }
+        convars.push_back(std::move(convar));
     }
 }
 
-void NetSignonState::parse(BitReader& reader)
+void NetSetConVar::skip(NothrowBitReader& reader)
+{
+	int length = reader.read_bits(8);
+	for (auto i = 0; i < length; i++) {
+		reader.skip_ascii_string();
+		reader.skip_ascii_string();
+	}
+}
+
+void NetSignonState::parse(NothrowBitReader& reader)
 {
 	signon_state = reader.read_uint8();
 	spawn_count = reader.read_uint32();
-	std::cout << "NetSignonState: signon_state=" << signon_state << ", spawn_count=" << spawn_count << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "NetSignonState: signon_state=" << signon_state << ", spawn_count=" << spawn_count << '\n';
+	}
 }
 
-void SvcPrint::parse(BitReader& reader)
+void NetSignonState::skip(NothrowBitReader& reader)
 {
-	text = reader.read_ascii_string();
-	std::cout << "SvcPrint: " << text << std::endl;
+	reader.skip_bits(8 + 32);
 }
 
-void SvcServerInfo::parse(BitReader& reader)
+void SvcPrint::parse(NothrowBitReader& reader)
+{
+	reader.read_ascii_string(text);
+	if (auto* out = trace::stream()) {
+		*out << "SvcPrint: " << text << '\n';
+	}
+}
+
+void SvcPrint::skip(NothrowBitReader& reader)
+{
+	reader.skip_ascii_string();
+}
+
+void SvcServerInfo::parse(NothrowBitReader& reader)
 {
 	protocol = reader.read_short(); // 16 seems to be correct, but this is 8 bits on https://dem.nekz.me/classes/netsvc/netsetconvar
 	server_count = reader.read_uint32();
@@ -80,79 +182,129 @@ void SvcServerInfo::parse(BitReader& reader)
 	client_crc = reader.read_int32();
 	max_classes = reader.read_uint16();
 
-	std::cout << "SvcServerInfo: protocol=" << protocol
-		<< ", server_count=" << server_count
-		<< ", is_hltv=" << is_hltv
-		<< ", is_dedicated=" << is_dedicated
-		<< ", client_crc=" << client_crc
-		<< ", max_classes=" << max_classes << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcServerInfo: protocol=" << protocol
+			<< ", server_count=" << server_count
+			<< ", is_hltv=" << is_hltv
+			<< ", is_dedicated=" << is_dedicated
+			<< ", client_crc=" << client_crc
+			<< ", max_classes=" << max_classes << '\n';
+	}
 
 	if (protocol > 17) {
 		reader.read_bytes(16);
 	}
 	else {
 		map_crc = reader.read_int32();
-		std::cout << "  Map CRC for protocol <= 17: " << map_crc << std::endl;
+		if (auto* out = trace::stream()) {
+			*out << "  Map CRC for protocol <= 17: " << map_crc << '\n';
+		}
 	}
 
 	player_slot = static_cast<int>(reader.read_byte());
 	max_classes = static_cast<int>(reader.read_byte());
 	tick_interval = reader.read_float32();
 	os = static_cast<char>(reader.read_byte());
-	game_dir = reader.read_ascii_string(260);
-	map_name = reader.read_ascii_string(260);
-	sky_name = reader.read_ascii_string(260);
-	host_name = reader.read_ascii_string(260);
+	reader.read_ascii_string(game_dir, 260);
+	reader.read_ascii_string(map_name, 260);
+	reader.read_ascii_string(sky_name, 260);
+	reader.read_ascii_string(host_name, 260);
 	is_replay = reader.read_bit();
 
-	std::cout << "  player_slot=" << player_slot
-		<< ", tick_interval=" << tick_interval
-		<< ", os=" << os
-		<< ", game_dir=" << game_dir
-		<< ", map_name=" << map_name
-		<< ", sky_name=" << sky_name
-		<< ", host_name=" << host_name
-		<< ", is_replay=" << is_replay << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "  player_slot=" << player_slot
+			<< ", tick_interval=" << tick_interval
+			<< ", os=" << os
+			<< ", game_dir=" << game_dir
+			<< ", map_name=" << map_name
+			<< ", sky_name=" << sky_name
+			<< ", host_name=" << host_name
+			<< ", is_replay=" << is_replay << '\n';
+	}
+}
+
+void SvcServerInfo::skip(NothrowBitReader& reader)
+{
+	int protocol = reader.read_short();
+	reader.skip_bits(32 + 1 + 1 + 32 + 16);
+	reader.skip_bits(protocol > 17 ? 16 * 8 : 32);
+	reader.skip_bits(8 + 8 + 32 + 8);
+	for (int i = 0; i < 4; i++) {
+		reader.skip_ascii_string(260);
+	}
+	reader.skip_bits(1);
 }
 
-void SvcSendTable::parse(BitReader& reader)
+void SvcSendTable::parse(NothrowBitReader& reader)
 {
 	needs_decoder = reader.read_bit();
 	length = reader.read_short();
-	data = reader.read_many_bits(length);
-	std::cout << "SvcSendTable: needs_decoder=" << needs_decoder
-		<< ", length=" << length << " bits" << std::endl;
+	data = BitReader(reader.read_view(length));
+	if (auto* out = trace::stream()) {
+		*out << "SvcSendTable: needs_decoder=" << needs_decoder
+			<< ", length=" << length << " bits" << '\n';
+	}
 }
 
-void SvcClassInfo::parse(BitReader& reader) {
+void SvcSendTable::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(1);
+	reader.skip_bits(reader.read_short());
+}
+
+void SvcClassInfo::parse(NothrowBitReader& reader) {
 	num_server_classes = reader.read_int16();
 	create_on_client = reader.read_bit();
 	
-	std::cout << "SvcClassInfo: num_server_classes=" << num_server_classes << ", create_on_client=" << create_on_client << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcClassInfo: num_server_classes=" << num_server_classes << ", create_on_client=" << create_on_client << '\n';
+	}
 
 	if (!create_on_client) {
 		int server_class_bits = Q_log2(num_server_classes) + 1;
 		for (int i = 0; i < num_server_classes; i++) {
-			class_t server_class;
+			class_t server_class{ 0, std::pmr::string(memory), std::pmr::string(memory) };
 			server_class.classID = reader.read_bits(server_class_bits);
-			server_class.class_name = reader.read_ascii_string(256);
-			server_class.data_table_name = reader.read_ascii_string(256);
-			server_classes.push_back(server_class);
-			std::cout << "  ClassID: " << server_class.classID
-				<< ", ClassName: " << server_class.class_name
-				<< ", DataTableName: " << server_class.data_table_name << std::endl;
+			reader.read_ascii_string(server_class.class_name, 256);
+			reader.read_ascii_string(server_class.data_table_name, 256);
+			if (auto* out = trace::stream()) {
+				*out << "  ClassID: " << server_class.classID
+					<< ", ClassName: " << server_class.class_name
+					<< ", DataTableName: " << server_class.data_table_name << '\n';
+			}
+			server_classes.push_back(std::move(server_class));
 		}
 	}
 }
 
-void SvcSetPause::parse(BitReader& reader) {
+void SvcClassInfo::skip(NothrowBitReader& reader)
+{
+	int num_server_classes = reader.read_int16();
+	if (!reader.read_bit()) {
+		int server_class_bits = Q_log2(num_server_classes) + 1;
+		for (int i = 0; i < num_server_classes; i++) {
+			reader.skip_bits(server_class_bits);
+			reader.skip_ascii_string(256);
+			reader.skip_ascii_string(256);
+		}
+	}
+}
+
+void SvcSetPause::parse(NothrowBitReader& reader) {
 	paused = reader.read_bit();
-	std::cout << "SvcSetPause: paused=" << paused << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcSetPause: paused=" << paused << '\n';
+	}
 }
 
-void SvcCreateStringTable::parse(BitReader& reader)
+void SvcSetPause::skip(NothrowBitReader& reader)
 {
-	table_name = reader.read_ascii_string();
+	reader.skip_bits(1);
+}
+
+void SvcCreateStringTable::parse(NothrowBitReader& reader)
+{
+	reader.read_ascii_string(table_name);
 	max_entries = reader.read_uint16();
 	int encode_bits = Q_log2(max_entries);
 	num_entries = reader.read_bits(encode_bits + 1);
@@ -167,19 +319,34 @@ void SvcCreateStringTable::parse(BitReader& reader)
 		user_data_size_bits = 0;
 	}
 	data_compressed = reader.read_bool();
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
+
+	if (auto* out = trace::stream()) {
+		*out << "SvcCreateStringTable: table_name=" << table_name
+			<< ", max_entries=" << max_entries
+			<< ", num_entries=" << num_entries
+			<< ", length=" << length
+			<< ", user_data_fixed_size=" << user_data_fixed_size
+			<< ", user_data_size=" << user_data_size
+			<< ", user_data_size_bits=" << user_data_size_bits
+			<< ", data_compressed=" << data_compressed << '\n';
+	}
+}
 
-	std::cout << "SvcCreateStringTable: table_name=" << table_name
-		<< ", max_entries=" << max_entries
-		<< ", num_entries=" << num_entries
-		<< ", length=" << length
-		<< ", user_data_fixed_size=" << user_data_fixed_size
-		<< ", user_data_size=" << user_data_size
-		<< ", user_data_size_bits=" << user_data_size_bits
-		<< ", data_compressed=" << data_compressed << std::endl;
+void SvcCreateStringTable::skip(NothrowBitReader& reader)
+{
+	reader.skip_ascii_string();
+	int max_entries = reader.read_uint16();
+	reader.skip_bits(Q_log2(max_entries) + 1);
+	int length = reader.read_var_int32();
+	if (reader.read_bool()) {
+		reader.skip_bits(12 + 4);
+	}
+	reader.skip_bits(1);
+	reader.skip_bits(length);
 }
 
-void SvcUpdateStringTable::parse(BitReader& reader)
+void SvcUpdateStringTable::parse(NothrowBitReader& reader)
 {
 	constexpr auto MAX_TABLES = 32;
 	table_id = reader.read_bits(Q_log2(MAX_TABLES));
@@ -191,39 +358,69 @@ void SvcUpdateStringTable::parse(BitReader& reader)
 	}
 
 	length = reader.read_bits(20);
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
+
+	if (auto* out = trace::stream()) {
+		*out << "SvcUpdateStringTable: table_id=" << table_id
+			<< ", num_changed_entries=" << num_changed_entries
+			<< ", length=" << length << " bits" << '\n';
+	}
+}
 
-	std::cout << "SvcUpdateStringTable: table_id=" << table_id
-		<< ", num_changed_entries=" << num_changed_entries
-		<< ", length=" << length << " bits" << std::endl;
+void SvcUpdateStringTable::skip(NothrowBitReader& reader)
+{
+	constexpr auto MAX_TABLES = 32;
+	reader.skip_bits(Q_log2(MAX_TABLES));
+	if (reader.read_bit()) {
+		reader.skip_bits(16);
+	}
+	reader.skip_bits(reader.read_bits(20));
 }
 
-void SvcVoiceInit::parse(BitReader& reader)
+void SvcVoiceInit::parse(NothrowBitReader& reader)
 {
-	codec = reader.read_ascii_string();
+	reader.read_ascii_string(codec);
 	legacy_quality = reader.read_uint8();
 	if (legacy_quality == 255) {
 		sample_rate = reader.read_short();
 	}
 
-	std::cout << "SvcVoiceInit: codec=" << codec
-		<< ", legacy_quality=" << static_cast<int>(legacy_quality)
-		<< ", sample_rate=" << sample_rate << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcVoiceInit: codec=" << codec
+			<< ", legacy_quality=" << static_cast<int>(legacy_quality)
+			<< ", sample_rate=" << sample_rate << '\n';
+	}
+}
+
+void SvcVoiceInit::skip(NothrowBitReader& reader)
+{
+	reader.skip_ascii_string();
+	if (reader.read_uint8() == 255) {
+		reader.skip_bits(16);
+	}
 }
 
-void SvcVoiceData::parse(BitReader& reader)
+void SvcVoiceData::parse(NothrowBitReader& reader)
 {
 	from_client = reader.read_bool();
 	proximity = reader.read_bool();
 	length = reader.read_uint16();
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
 
-	std::cout << "SvcVoiceData: from_client=" << from_client
-		<< ", proximity=" << proximity
-		<< ", length=" << length << " bits" << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcVoiceData: from_client=" << from_client
+			<< ", proximity=" << proximity
+			<< ", length=" << length << " bits" << '\n';
+	}
+}
+
+void SvcVoiceData::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(1 + 1);
+	reader.skip_bits(reader.read_uint16());
 }
 
-void SvcSounds::parse(BitReader& reader)
+void SvcSounds::parse(NothrowBitReader& reader)
 {
 	reliable_sound = reader.read_bool();
 	if (reliable_sound) {
@@ -234,45 +431,81 @@ void SvcSounds::parse(BitReader& reader)
 		num_sounds = reader.read_bits(8);
 		length = reader.read_bits(16);
 	}
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
 
-	std::cout << "SvcSounds: reliable_sound=" << reliable_sound
-		<< ", num_sounds=" << num_sounds
-		<< ", length=" << length << " bits" << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcSounds: reliable_sound=" << reliable_sound
+			<< ", num_sounds=" << num_sounds
+			<< ", length=" << length << " bits" << '\n';
+	}
 }
 
-void SvcSetView::parse(BitReader& reader)
+void SvcSounds::skip(NothrowBitReader& reader)
+{
+	int length;
+	if (reader.read_bool()) {
+		length = reader.read_bits(8);
+	}
+	else {
+		reader.skip_bits(8);
+		length = reader.read_bits(16);
+	}
+	reader.skip_bits(length);
+}
+
+void SvcSetView::parse(NothrowBitReader& reader)
 {
 	entity_index = reader.read_bits(11);
 
-	std::cout << "SvcSetView: entity_index=" << entity_index << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcSetView: entity_index=" << entity_index << '\n';
+	}
+}
+
+void SvcSetView::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(11);
 }
 
-void SvcFixAngle::parse(BitReader& reader)
+void SvcFixAngle::parse(NothrowBitReader& reader)
 {
 	relative = reader.read_bit();
 	angle.x = reader.read_bit_angle(16);
 	angle.y = reader.read_bit_angle(16);
 	angle.z = reader.read_bit_angle(16);
 
-	std::cout << "SvcFixAngle: relative=" << relative
-		<< ", angle.x=" << angle.x
-		<< ", angle.y=" << angle.y
-		<< ", angle.z=" << angle.z << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcFixAngle: relative=" << relative
+			<< ", angle.x=" << angle.x
+			<< ", angle.y=" << angle.y
+			<< ", angle.z=" << angle.z << '\n';
+	}
 }
 
-void SvcCrosshairAngle::parse(BitReader& reader)
+void SvcFixAngle::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(1 + 3 * 16);
+}
+
+void SvcCrosshairAngle::parse(NothrowBitReader& reader)
 {
 	angle.x = reader.read_bit_angle(16);
 	angle.y = reader.read_bit_angle(16);
 	angle.z = reader.read_bit_angle(16);
 
-	std::cout << "SvcCrosshairAngle: angle.x=" << angle.x
-		<< ", angle.y=" << angle.y
-		<< ", angle.z=" << angle.z << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcCrosshairAngle: angle.x=" << angle.x
+			<< ", angle.y=" << angle.y
+			<< ", angle.z=" << angle.z << '\n';
+	}
+}
+
+void SvcCrosshairAngle::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(3 * 16);
 }
 
-void SvcBSPDecal::parse(BitReader& reader)
+void SvcBSPDecal::parse(NothrowBitReader& reader)
 {
 	pos = reader.read_bit_vec3_coord();
 	decal_texture_index = reader.read_bits(9);
@@ -286,44 +519,79 @@ void SvcBSPDecal::parse(BitReader& reader)
 	}
 	low_priority = reader.read_bool();
 
-	std::cout << "SvcBSPDecal: pos=(" << pos.x << ", " << pos.y << ", " << pos.z << ")"
-		<< ", decal_texture_index=" << decal_texture_index
-		<< ", entity_index=" << entity_index
-		<< ", model_index=" << model_index
-		<< ", low_priority=" << low_priority << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcBSPDecal: pos=(" << pos.x << ", " << pos.y << ", " << pos.z << ")"
+			<< ", decal_texture_index=" << decal_texture_index
+			<< ", entity_index=" << entity_index
+			<< ", model_index=" << model_index
+			<< ", low_priority=" << low_priority << '\n';
+	}
 }
 
-void SvcUserMessage::parse(BitReader& reader)
+void SvcBSPDecal::skip(NothrowBitReader& reader)
+{
+	reader.read_bit_vec3_coord();
+	reader.skip_bits(9);
+	if (reader.read_bool()) {
+		reader.skip_bits(11 + 13);
+	}
+	reader.skip_bits(1);
+}
+
+void SvcUserMessage::parse(NothrowBitReader& reader)
 {
 	msg_type = reader.read_uint8();
 	length = reader.read_bits(11);
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
 
-	std::cout << "SvcUserMessage: msg_type=" << static_cast<int>(msg_type)
-		<< ", length=" << length << " bits" << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcUserMessage: msg_type=" << static_cast<int>(msg_type)
+			<< ", length=" << length << " bits" << '\n';
+	}
 }
 
-void SvcEntityMessage::parse(BitReader& reader)
+void SvcUserMessage::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(8);
+	reader.skip_bits(reader.read_bits(11));
+}
+
+void SvcEntityMessage::parse(NothrowBitReader& reader)
 {
 	entity_index = reader.read_bits(11);
 	class_id = reader.read_bits(9);
 	length = reader.read_bits(11);
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
 
-	std::cout << "SvcEntityMessage: entity_index=" << entity_index
-		<< ", class_id=" << class_id
-		<< ", length=" << length << " bits" << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcEntityMessage: entity_index=" << entity_index
+			<< ", class_id=" << class_id
+			<< ", length=" << length << " bits" << '\n';
+	}
 }
 
-void SvcGameEvent::parse(BitReader& reader)
+void SvcEntityMessage::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(11 + 9);
+	reader.skip_bits(reader.read_bits(11));
+}
+
+void SvcGameEvent::parse(NothrowBitReader& reader)
 {
 	length = reader.read_bits(11);
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
+
+	if (auto* out = trace::stream()) {
+		*out << "SvcGameEvent: length=" << length << " bits" << '\n';
+	}
+}
 
-	std::cout << "SvcGameEvent: length=" << length << " bits" << std::endl;
+void SvcGameEvent::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(reader.read_bits(11));
 }
 
-void SvcPacketEntities::parse(BitReader& reader)
+void SvcPacketEntities::parse(NothrowBitReader& reader)
 {
 	max_entries = reader.read_bits(11);
 	is_delta = reader.read_bit();
@@ -338,80 +606,138 @@ void SvcPacketEntities::parse(BitReader& reader)
 	updated_entries = reader.read_bits(11);
 	length = reader.read_bits(20);
 	update_baseline = reader.read_bit();
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
+
+	if (auto* out = trace::stream()) {
+		*out << "SvcPacketEntities: max_entries=" << max_entries
+			<< ", is_delta=" << is_delta
+			<< ", delta_from=" << delta_from
+			<< ", baseline=" << baseline
+			<< ", updated_entries=" << updated_entries
+			<< ", length=" << length
+			<< ", update_baseline=" << update_baseline << '\n';
+	}
+}
 
-	std::cout << "SvcPacketEntities: max_entries=" << max_entries
-		<< ", is_delta=" << is_delta
-		<< ", delta_from=" << delta_from
-		<< ", baseline=" << baseline
-		<< ", updated_entries=" << updated_entries
-		<< ", length=" << length
-		<< ", update_baseline=" << update_baseline << std::endl;
+void SvcPacketEntities::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(11);
+	if (reader.read_bit()) {
+		reader.skip_bits(32);
+	}
+	reader.skip_bits(1 + 11);
+	int length = reader.read_bits(20);
+	reader.skip_bits(1 + length);
 }
 
-void SvcTempEntities::parse(BitReader& reader)
+void SvcTempEntities::parse(NothrowBitReader& reader)
 {
 	num_entries = reader.read_bits(8);
 	length = reader.read_var_int32(); // maybe just 17??
-	data = reader.read_many_bits(length);
+	data = BitReader(reader.read_view(length));
 
-	std::cout << "SvcTempEntities: num_entries=" << num_entries
-		<< ", length=" << length << " bits" << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcTempEntities: num_entries=" << num_entries
+			<< ", length=" << length << " bits" << '\n';
+	}
 }
 
-void SvcPrefetch::parse(BitReader& reader)
+void SvcTempEntities::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(8);
+	reader.skip_bits(reader.read_var_int32());
+}
+
+void SvcPrefetch::parse(NothrowBitReader& reader)
 {
 	sound_index = reader.read_bits(14);
-	std::cout << "SvcPrefetch: sound_index=" << sound_index << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcPrefetch: sound_index=" << sound_index << '\n';
+	}
 }
 
-void SvcMenu::parse(BitReader& reader)
+void SvcPrefetch::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(14);
+}
+
+void SvcMenu::parse(NothrowBitReader& reader)
 {
 	menu_type = reader.read_int16();
 	length = reader.read_uint16();
-	std::cout << "SvcMenu: menu_type=" << menu_type
-		<< ", length=" << length << std::endl;
+	data = BitReader(reader.read_view(length * 8));
+	if (auto* out = trace::stream()) {
+		*out << "SvcMenu: menu_type=" << menu_type
+			<< ", length=" << length << '\n';
+	}
+}
+
+void SvcMenu::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(16);
+	reader.skip_bits(reader.read_uint16() * 8);
 }
 
-void SvcGameEventList::parse(BitReader& reader)
+void SvcGameEventList::parse(NothrowBitReader& reader)
 {
 	events = reader.read_bits(9);
 	length = reader.read_bits(20);
-	data = reader.read_many_bits(length);
-	std::cout << "SvcGameEventList: events=" << events
-		<< ", length=" << length << " bits" << std::endl;
+	data = BitReader(reader.read_view(length));
+	if (auto* out = trace::stream()) {
+		*out << "SvcGameEventList: events=" << events
+			<< ", length=" << length << " bits" << '\n';
+	}
+}
+
+void SvcGameEventList::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(9);
+	reader.skip_bits(reader.read_bits(20));
 }
 
-void SvcGetCvarValue::parse(BitReader& reader)
+void SvcGetCvarValue::parse(NothrowBitReader& reader)
 {
 	cookie = reader.read_int32();
-	cvar_name = reader.read_ascii_string();
-	std::cout << "SvcGetCvarValue: cookie=" << cookie
-		<< ", cvar_name=" << cvar_name << std::endl;
+	reader.read_ascii_string(cvar_name);
+	if (auto* out = trace::stream()) {
+		*out << "SvcGetCvarValue: cookie=" << cookie
+			<< ", cvar_name=" << cvar_name << '\n';
+	}
 }
 
-void SvcCmdKeyValues::parse(BitReader& reader) {
-	length = reader.read_uint32();
-	if (length <= 0 || length > reader.bits_left() / 8) {
-		return;
-		throw std::runtime_error(
-			"SvcCmdKeyValues::parse tried to read past end of buffer. Length: "
-			+ std::to_string(length)
-			+ ", Bits left: "
-			+ std::to_string(reader.bits_left())
-			+ " (bytes left: "
-			+ std::to_string(reader.bits_left() / 8)
-			+ ")."
-		);
+void SvcGetCvarValue::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(32);
+	reader.skip_ascii_string();
+}
+
+void SvcCmdKeyValues::parse(NothrowBitReader& reader) {
+	// A byte count. One that runs past the packet, including any that would
+	// be negative as an int, fails the reader like other length prefixes.
+	uint32_t bytes = reader.read_uint32();
+	length = static_cast<int>(bytes);
+	data = BitReader(reader.read_view(size_t{ bytes } * 8));
+	if (auto* out = trace::stream()) {
+		*out << "SvcCmdKeyValues: length=" << bytes << " bytes" << '\n';
 	}
-	data = reader.read_bytes(length);
-	std::cout << "SvcCmdKeyValues: length=" << length << " bits" << std::endl;
 }
 
-void SvcSetPauseTimed::parse(BitReader& reader)
+void SvcCmdKeyValues::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(size_t{ reader.read_uint32() } * 8);
+}
+
+void SvcSetPauseTimed::parse(NothrowBitReader& reader)
 {
 	paused = reader.read_bool();
 	expire_time = reader.read_float32();
-	std::cout << "SvcSetPauseTimed: paused=" << paused
-            << ", expire_time=" << expire_time << std::endl;
+	if (auto* out = trace::stream()) {
+		*out << "SvcSetPauseTimed: paused=" << paused
+	            << ", expire_time=" << expire_time << '\n';
+	}
+}
+
+void SvcSetPauseTimed::skip(NothrowBitReader& reader)
+{
+	reader.skip_bits(1 + 32);
 }
@@ -1,9 +1,11 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory_resource>
 #include "structs.h"
-
-class BitReader;
+#include "Util/Arena.h"
+#include "Util/BitReader.h"
 
 struct NetMessage {
 	enum class Type {
@@ -43,37 +45,56 @@ struct NetMessage {
 	};
 
 
-    NetMessage(Type _type) : type(_type) {};
-    virtual void parse(BitReader& reader) = 0;
+    NetMessage(Type _type, std::pmr::memory_resource* _memory) : type(_type), memory(_memory) {};
+    virtual ~NetMessage() = default;
+    // Declared so the virtual destructor does not turn moves into copies when
+    // a columnar store grows or merges.
+    NetMessage(const NetMessage&) = default;
+    NetMessage(NetMessage&&) = default;
+    NetMessage& operator=(const NetMessage&) = default;
+    NetMessage& operator=(NetMessage&&) = default;
+    virtual void parse(NothrowBitReader& reader) = 0;
+    // Every concrete message also has a static skip(NothrowBitReader&) that advances
+    // past its encoding with as little work as possible, for indexing.
 
     Type type;
+    // Strings and containers of the message allocate from here (usually the demo's arena).
+    std::pmr::memory_resource* memory;
 };
 
 struct NetNop : public NetMessage {
-    NetNop() : NetMessage(Type::net_nop) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::net_nop;
+    explicit NetNop(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 };
 
 struct NetDisconnect : public NetMessage {
-    NetDisconnect() : NetMessage(Type::net_disconnect) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::net_disconnect;
+    explicit NetDisconnect(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
-    std::string text;
+    std::pmr::string text{ memory };
 };
 
 struct NetFile : public NetMessage {
-    NetFile() : NetMessage(Type::net_file) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::net_file;
+    explicit NetFile(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int transfer_id{};
-    std::string file_name;
+    std::pmr::string file_name{ memory };
     bool file_requested{};
 
 };
 
 struct NetTick : public NetMessage {
-    NetTick() : NetMessage(Type::net_tick) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::net_tick;
+    explicit NetTick(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
     void print();
 
     inline static const float SCALEUP = 100000.0f;
@@ -84,33 +105,43 @@ struct NetTick : public NetMessage {
 };
 
 struct NetStringCmd : public NetMessage {
-    NetStringCmd() : NetMessage(Type::net_string_cmd) {};
-    void parse(BitReader& reader);
-    std::string command;
+    static constexpr Type TYPE = Type::net_string_cmd;
+    explicit NetStringCmd(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
+    std::pmr::string command{ memory };
 };
 
 struct NetSetConVar : public NetMessage {
-    NetSetConVar() : NetMessage(Type::net_set_con_var) {};
-    void parse(BitReader& reader);
-    std::vector<ConVar> convars;
+    static constexpr Type TYPE = Type::net_set_con_var;
+    explicit NetSetConVar(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
+    std::pmr::vector<ConVar> convars{ memory };
 };
 
 struct NetSignonState : public NetMessage {
-    NetSignonState() : NetMessage(Type::net_signon_state) {}
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::net_signon_state;
+    explicit NetSignonState(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {}
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
     int signon_state{};
     int spawn_count{};
 };
 
 struct SvcPrint : public NetMessage {
-    SvcPrint() : NetMessage(Type::svc_print) {};
-    void parse(BitReader& reader);
-    std::string text;
+    static constexpr Type TYPE = Type::svc_print;
+    explicit SvcPrint(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
+    std::pmr::string text{ memory };
 };
 
 struct SvcServerInfo : public NetMessage {
-    SvcServerInfo() : NetMessage(Type::svc_server_info) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_server_info;
+    explicit SvcServerInfo(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int protocol{};
     int server_count{};
@@ -123,51 +154,59 @@ struct SvcServerInfo : public NetMessage {
     int max_clients{};
     float tick_interval{};
     char os{}; // L = linux, W = Win32
-    std::string game_dir;
-    std::string map_name;
-    std::string sky_name;
-    std::string host_name;
+    std::pmr::string game_dir{ memory };
+    std::pmr::string map_name{ memory };
+    std::pmr::string sky_name{ memory };
+    std::pmr::string host_name{ memory };
     bool is_replay{};
 };
 
 struct SvcSendTable : public NetMessage {
-    SvcSendTable() : NetMessage(Type::svc_send_table) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_send_table;
+    explicit SvcSendTable(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
     bool needs_decoder{};
     int length{};
     //int props{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcClassInfo : public NetMessage { 
-    SvcClassInfo() : NetMessage(Type::svc_class_info) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_class_info;
+    explicit SvcClassInfo(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     // todo: move this somewhere else and rename?
     typedef struct class_s
     {
         int		classID;
-        std::string	data_table_name;
-        std::string	class_name;
+        std::pmr::string	data_table_name;
+        std::pmr::string	class_name;
     } class_t;
 
     int num_server_classes{};
     bool create_on_client{};
-    std::vector<class_t> server_classes;
+    std::pmr::vector<class_t> server_classes{ memory };
 };
 
 struct SvcSetPause : public NetMessage {
-    SvcSetPause() : NetMessage(Type::svc_set_pause) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_set_pause;
+    explicit SvcSetPause(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     bool paused{};
 };
 
 struct SvcCreateStringTable : public NetMessage {
-    SvcCreateStringTable() : NetMessage(Type::svc_create_string_table) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_create_string_table;
+    explicit SvcCreateStringTable(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
-    std::string table_name;
+    std::pmr::string table_name{ memory };
     int max_entries{};
     int num_entries{};
     int length{};
@@ -175,73 +214,89 @@ struct SvcCreateStringTable : public NetMessage {
     int user_data_size{};
     int user_data_size_bits{};
     bool data_compressed{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcUpdateStringTable : public NetMessage {
-    SvcUpdateStringTable() : NetMessage(Type::svc_update_string_table) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_update_string_table;
+    explicit SvcUpdateStringTable(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int table_id{};
     int num_changed_entries{};
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcVoiceInit : public NetMessage {
-    SvcVoiceInit() : NetMessage(Type::svc_voice_init) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_voice_init;
+    explicit SvcVoiceInit(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
-    std::string codec;
+    std::pmr::string codec{ memory };
     int legacy_quality{};
     int sample_rate{};
 };
 
 struct SvcVoiceData : public NetMessage {
-    SvcVoiceData() : NetMessage(Type::svc_voice_data) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_voice_data;
+    explicit SvcVoiceData(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int from_client{};
     bool proximity{};
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcSounds : public NetMessage {
-    SvcSounds() : NetMessage(Type::svc_sounds) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_sounds;
+    explicit SvcSounds(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     bool reliable_sound{};
     int num_sounds{};
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcSetView : public NetMessage {
-    SvcSetView() : NetMessage(Type::svc_set_view) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_set_view;
+    explicit SvcSetView(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int entity_index{};
 };
 
 struct SvcFixAngle : public NetMessage {
-    SvcFixAngle() : NetMessage(Type::svc_fix_angle) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_fix_angle;
+    explicit SvcFixAngle(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     bool relative{};
     QAngle angle{};
 };
 
 struct SvcCrosshairAngle : public NetMessage {
-    SvcCrosshairAngle() : NetMessage(Type::svc_crosshair_angle) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_crosshair_angle;
+    explicit SvcCrosshairAngle(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     QAngle angle{};
 };
 
 struct SvcBSPDecal : public NetMessage {
-    SvcBSPDecal() : NetMessage(Type::svc_bsp_decal) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_bsp_decal;
+    explicit SvcBSPDecal(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     Vector pos{};
     int decal_texture_index{};
@@ -251,35 +306,43 @@ struct SvcBSPDecal : public NetMessage {
 };
 
 struct SvcUserMessage : public NetMessage {
-    SvcUserMessage() : NetMessage(Type::svc_user_message) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_user_message;
+    explicit SvcUserMessage(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int msg_type{};
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcEntityMessage : public NetMessage {
-    SvcEntityMessage() : NetMessage(Type::svc_entity_message) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_entity_message;
+    explicit SvcEntityMessage(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int entity_index{};
     int class_id{};
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcGameEvent : public NetMessage {
-    SvcGameEvent() : NetMessage(Type::svc_game_event) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_game_event;
+    explicit SvcGameEvent(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcPacketEntities : public NetMessage {
-    SvcPacketEntities() : NetMessage(Type::svc_packet_entities) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_packet_entities;
+    explicit SvcPacketEntities(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int max_entries{};
     bool is_delta{};
@@ -288,63 +351,81 @@ struct SvcPacketEntities : public NetMessage {
     int updated_entries{};
     int length{};
     bool update_baseline{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcTempEntities : public NetMessage {
-    SvcTempEntities() : NetMessage(Type::svc_temp_entities) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_temp_entities;
+    explicit SvcTempEntities(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int num_entries{};
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcPrefetch : public NetMessage {
-    SvcPrefetch() : NetMessage(Type::svc_prefetch) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_prefetch;
+    explicit SvcPrefetch(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int sound_index{};
 };
 
 struct SvcMenu : public NetMessage {
-    SvcMenu() : NetMessage(Type::svc_menu) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_menu;
+    explicit SvcMenu(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int menu_type{};
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcGameEventList : public NetMessage {
-    SvcGameEventList() : NetMessage(Type::svc_game_event_list) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_game_event_list;
+    explicit SvcGameEventList(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int events{};
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcGetCvarValue : public NetMessage {
-    SvcGetCvarValue() : NetMessage(Type::svc_get_cvar_value) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_get_cvar_value;
+    explicit SvcGetCvarValue(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
-    std::string cookie;
-    std::string cvar_name;
+    int cookie{};
+    std::pmr::string cvar_name{ memory };
 };
 
 struct SvcCmdKeyValues : public NetMessage {
-    SvcCmdKeyValues() : NetMessage(Type::svc_cmd_key_values) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_cmd_key_values;
+    explicit SvcCmdKeyValues(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     int length{};
-    std::vector<std::byte> data;
+    BitReader data;
 };
 
 struct SvcSetPauseTimed : public NetMessage {
-    SvcSetPauseTimed() : NetMessage(Type::svc_set_pause_timed) {};
-    void parse(BitReader& reader);
+    static constexpr Type TYPE = Type::svc_set_pause_timed;
+    explicit SvcSetPauseTimed(std::pmr::memory_resource* memory) : NetMessage(TYPE, memory) {};
+    void parse(NothrowBitReader& reader);
+    static void skip(NothrowBitReader& reader);
 
     bool paused{};
     float expire_time{};
 };
+
+// Name of a net message type as in the dump, e.g. "NetTick"; empty for ids
+// that are not net messages.
+std::string_view net_message_name(NetMessage::Type type);
@@ -0,0 +1,167 @@
+#pragma once
+#include "NetMessage.h"
+#include "Util/Arena.h"
+#include <array>
+#include <iterator>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <vector>
+
+// Every concrete net message. Dispatch tables and the columnar store below are
+// generated from this list, so adding a message type only means adding it here.
+using NetMessageTypes = std::tuple<
+    NetNop, NetDisconnect, NetFile, NetTick, NetStringCmd, NetSetConVar, NetSignonState,
+    SvcPrint, SvcServerInfo, SvcSendTable, SvcClassInfo, SvcSetPause, SvcCreateStringTable,
+    SvcUpdateStringTable, SvcVoiceInit, SvcVoiceData, SvcSounds, SvcSetView, SvcFixAngle,
+    SvcCrosshairAngle, SvcBSPDecal, SvcUserMessage, SvcEntityMessage, SvcGameEvent,
+    SvcPacketEntities, SvcTempEntities, SvcPrefetch, SvcMenu, SvcGameEventList,
+    SvcGetCvarValue, SvcCmdKeyValues, SvcSetPauseTimed>;
+
+// Net message ids are 6 bits on the wire.
+constexpr size_t NET_MESSAGE_ID_COUNT = 64;
+
+// Position of a message inside a NetMessageStore.
+struct NetMessageRef {
+    NetMessage::Type type;
+    uint32_t index;
+};
+
+// Location of a not yet decoded message inside its packet's payload. The bit
+// range covers the message body, after the 6-bit type id.
+struct NetMessageIndexEntry {
+    NetMessage::Type type;
+    uint32_t bit_offset;
+    uint32_t bit_length;
+};
+
+template <typename List>
+class BasicNetMessageStore;
+
+// Structure-of-arrays storage for net messages: one contiguous vector per
+// concrete type, so walking every SvcGameEvent of a demo is a linear scan with
+// no pointer chasing or virtual calls.
+template <typename... Ts>
+class BasicNetMessageStore<std::tuple<Ts...>> {
+    std::pmr::memory_resource* memory;
+    std::tuple<std::pmr::vector<Ts>...> columns;
+
+    template <typename T>
+    static NetMessageRef decode_into(BasicNetMessageStore& store, NothrowBitReader& reader) {
+        auto& column = std::get<std::pmr::vector<T>>(store.columns);
+        T& message = column.emplace_back(store.memory);
+        message.T::parse(reader);
+        if (reader.failed()) {
+            column.pop_back();
+        }
+        return { T::TYPE, static_cast<uint32_t>(column.size() - 1) };
+    }
+
+    template <typename T>
+    static const NetMessage& at(const BasicNetMessageStore& store, uint32_t index) {
+        return std::get<std::pmr::vector<T>>(store.columns)[index];
+    }
+
+    using Decoder = NetMessageRef(*)(BasicNetMessageStore&, NothrowBitReader&);
+    using Accessor = const NetMessage&(*)(const BasicNetMessageStore&, uint32_t);
+
+    static constexpr std::array<Decoder, NET_MESSAGE_ID_COUNT> decoders = [] {
+        std::array<Decoder, NET_MESSAGE_ID_COUNT> table{};
+        ((table[static_cast<size_t>(Ts::TYPE)] = &decode_into<Ts>), ...);
+        return table;
+    }();
+
+    static constexpr std::array<Accessor, NET_MESSAGE_ID_COUNT> accessors = [] {
+        std::array<Accessor, NET_MESSAGE_ID_COUNT> table{};
+        ((table[static_cast<size_t>(Ts::TYPE)] = &at<Ts>), ...);
+        return table;
+    }();
+
+public:
+    explicit BasicNetMessageStore(std::pmr::memory_resource* memory)
+        : memory(memory), columns(std::pmr::vector<Ts>(memory)...) {}
+
+    static bool is_known(NetMessage::Type type) {
+        return decoders[static_cast<size_t>(type)] != nullptr;
+    }
+
+    // Decodes one message of the given type from reader and appends it to its
+    // column. The type must be known. If reader fails, nothing is appended
+    // and the returned ref is not valid.
+    NetMessageRef decode(NetMessage::Type type, NothrowBitReader& reader) {
+        return decoders[static_cast<size_t>(type)](*this, reader);
+    }
+
+    template <typename T>
+    std::span<const T> all() const {
+        return std::get<std::pmr::vector<T>>(columns);
+    }
+
+    // Moves every message of others, in order, to the end of this store. For
+    // each of them returns, per wire id, the index its first message of that
+    // type now has here; a ref into others[i] is valid for this store after
+    // adding offsets[i][ref.type].
+    std::vector<std::array<uint32_t, NET_MESSAGE_ID_COUNT>> append(std::span<BasicNetMessageStore* const> others) {
+        std::vector<std::array<uint32_t, NET_MESSAGE_ID_COUNT>> offsets(others.size());
+        ([&] {
+            auto& column = std::get<std::pmr::vector<Ts>>(columns);
+            size_t total = column.size();
+            for (auto* other : others) {
+                total += std::get<std::pmr::vector<Ts>>(other->columns).size();
+            }
+            column.reserve(total);
+            for (size_t i = 0; i < others.size(); i++) {
+                auto& source = std::get<std::pmr::vector<Ts>>(others[i]->columns);
+                offsets[i][static_cast<size_t>(Ts::TYPE)] = static_cast<uint32_t>(column.size());
+                column.insert(column.end(), std::make_move_iterator(source.begin()), std::make_move_iterator(source.end()));
+                source.clear();
+            }
+        }(), ...);
+        return offsets;
+    }
+
+    const NetMessage& get(NetMessageRef ref) const {
+        return accessors[static_cast<size_t>(ref.type)](*this, ref.index);
+    }
+
+    // Calls fn with the concrete message that ref points to.
+    template <typename Fn>
+    void visit(NetMessageRef ref, Fn&& fn) const {
+        ((ref.type == Ts::TYPE ? (fn(std::get<std::pmr::vector<Ts>>(columns)[ref.index]), true) : false) || ...);
+    }
+};
+
+using NetMessageStore = BasicNetMessageStore<NetMessageTypes>;
+
+namespace detail {
+
+template <typename T>
+ArenaPtr<NetMessage> create_net_message(std::pmr::memory_resource* memory) {
+    return make_in<T>(memory);
+}
+
+template <typename... Ts>
+constexpr auto make_net_message_factories(std::tuple<Ts...>*) {
+    std::array<ArenaPtr<NetMessage>(*)(std::pmr::memory_resource*), NET_MESSAGE_ID_COUNT> table{};
+    ((table[static_cast<size_t>(Ts::TYPE)] = &create_net_message<Ts>), ...);
+    return table;
+}
+
+template <typename... Ts>
+constexpr auto make_net_message_skippers(std::tuple<Ts...>*) {
+    std::array<void(*)(NothrowBitReader&), NET_MESSAGE_ID_COUNT> table{};
+    ((table[static_cast<size_t>(Ts::TYPE)] = &Ts::skip), ...);
+    return table;
+}
+
+}
+
+// Factory per wire id; nullptr for ids that are not valid net messages.
+inline constexpr auto net_message_factories =
+    detail::make_net_message_factories(static_cast<NetMessageTypes*>(nullptr));
+
+// T::skip per wire id; nullptr for ids that are not valid net messages.
+inline constexpr auto net_message_skippers =
+    detail::make_net_message_skippers(static_cast<NetMessageTypes*>(nullptr));
@@ -0,0 +1,94 @@
+#include "Demo/ParseStats.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+void TypeStats::add(uint64_t decoded_bits, uint64_t decode_nanoseconds) {
+    count++;
+    bits += decoded_bits;
+    nanoseconds += decode_nanoseconds;
+    size_t bucket = decode_nanoseconds ? std::bit_width(decode_nanoseconds) - 1 : 0;
+    latency[std::min(bucket, LATENCY_BUCKETS - 1)]++;
+}
+
+void TypeStats::merge(const TypeStats& other) {
+    count += other.count;
+    bits += other.bits;
+    nanoseconds += other.nanoseconds;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        latency[i] += other.latency[i];
+    }
+}
+
+uint64_t TypeStats::percentile(double fraction) const {
+    if (count == 0) {
+        return 0;
+    }
+    // Nearest rank: the smallest sample with at least fraction * count samples
+    // at or below it.
+    auto wanted = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += latency[i];
+        if (seen >= wanted) {
+            return uint64_t(1) << (i + 1);
+        }
+    }
+    return uint64_t(1) << LATENCY_BUCKETS;
+}
+
+void ParseStats::merge(const ParseStats& other) {
+    for (size_t i = 0; i < frames.size(); i++) {
+        frames[i].merge(other.frames[i]);
+    }
+    for (size_t i = 0; i < net_messages.size(); i++) {
+        net_messages[i].merge(other.net_messages[i]);
+    }
+}
+
+namespace {
+
+template <size_t N, typename NameFn>
+void print_table(std::ostream& out, const char* title, const std::array<TypeStats, N>& types, NameFn&& name) {
+    std::vector<size_t> order;
+    uint64_t total_nanoseconds = 0;
+    for (size_t i = 0; i < N; i++) {
+        if (types[i].count > 0) {
+            order.push_back(i);
+            total_nanoseconds += types[i].nanoseconds;
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return types[a].nanoseconds > types[b].nanoseconds; });
+
+    out << std::left << std::setw(24) << title << std::right << std::setw(10) << "count" << std::setw(14) << "bytes"
+        << std::setw(12) << "total ms" << std::setw(8) << "time %" << std::setw(10) << "mean ns" << std::setw(10) << "p50 ns"
+        << std::setw(10) << "p99 ns" << '\n';
+    for (auto i : order) {
+        const auto& type = types[i];
+        std::string type_name(name(i));
+        if (type_name.empty()) {
+            type_name = std::to_string(i);
+        }
+        out << std::left << std::setw(24) << type_name << std::right << std::setw(10) << type.count << std::setw(14) << type.bits / 8
+            << std::fixed << std::setprecision(2) << std::setw(12) << type.nanoseconds / 1e6
+            << std::setprecision(1) << std::setw(8) << (total_nanoseconds ? 100.0 * type.nanoseconds / total_nanoseconds : 0.0)
+            << std::setw(10) << type.nanoseconds / type.count << std::setw(10) << "<" + std::to_string(type.percentile(0.5))
+            << std::setw(10) << "<" + std::to_string(type.percentile(0.99)) << '\n';
+    }
+    out << std::defaultfloat;
+}
+
+}
+
+void ParseStats::print(std::ostream& out) const {
+    if (!DEMO_STATS) {
+        out << "Parse stats are not compiled in (DEMO_STATS=0).\n";
+        return;
+    }
+    print_table(out, "Frame", frames, [](size_t i) { return frame_name(static_cast<DemoMessage::Type>(i)); });
+    out << '\n';
+    print_table(out, "Net message", net_messages, [](size_t i) { return net_message_name(static_cast<NetMessage::Type>(i)); });
+}
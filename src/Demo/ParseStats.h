@@ -0,0 +1,128 @@
+#pragma once
+#include "DemoMessage.h"
+#include "NetMessageStore.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Per type counts, sizes and decode times of frames and net messages. Decode
+// sites write
+//
+//     stats::Timer timer(stats::net_message(type));
+//     ... decode ...
+//     timer.stop(bits);
+//
+// which does nothing unless a ParseStats is installed on the thread with
+// stats::Scope. Building with DEMO_STATS=0 turns the timers into empty
+// objects and the compiler drops the instrumentation entirely.
+#ifndef DEMO_STATS
+#define DEMO_STATS 1
+#endif
+
+// Decode times go into power of two buckets: bucket i counts decodes that
+// took [2^i, 2^(i+1)) ns, bucket 0 also takes 0 ns.
+constexpr size_t LATENCY_BUCKETS = 40;
+
+struct TypeStats {
+    uint64_t count = 0;
+    uint64_t bits = 0;
+    uint64_t nanoseconds = 0;
+    std::array<uint64_t, LATENCY_BUCKETS> latency{};
+
+    void add(uint64_t decoded_bits, uint64_t decode_nanoseconds);
+    void merge(const TypeStats& other);
+    // Upper bound of the latency bucket holding the given fraction (0-1) of
+    // decodes, in ns. 0 if nothing was counted.
+    uint64_t percentile(double fraction) const;
+};
+
+constexpr size_t FRAME_TYPE_COUNT = static_cast<size_t>(DemoMessage::Type::LAST_CMD) + 1;
+
+// Frame times cover the frame's own fields only; the net messages inside a
+// packet are counted under their own types, so the two tables add up to the
+// whole decode. Frame sizes include the type and tick header.
+class ParseStats {
+public:
+    std::array<TypeStats, FRAME_TYPE_COUNT> frames{};
+    std::array<TypeStats, NET_MESSAGE_ID_COUNT> net_messages{};
+
+    TypeStats& frame(DemoMessage::Type type) { return frames[static_cast<size_t>(type)]; }
+    TypeStats& net_message(NetMessage::Type type) { return net_messages[static_cast<size_t>(type)]; }
+
+    // Adds the counters of another thread or demo.
+    void merge(const ParseStats& other);
+    // One table for frames and one for net messages, slowest type first.
+    void print(std::ostream& out) const;
+};
+
+namespace stats {
+
+#if DEMO_STATS
+// Per thread, so parallel chunks and batch jobs count without contention and
+// are merged once they are done.
+inline thread_local ParseStats* active = nullptr;
+
+inline TypeStats* frame(DemoMessage::Type type) {
+    return active ? &active->frame(type) : nullptr;
+}
+
+inline TypeStats* net_message(NetMessage::Type type) {
+    return active ? &active->net_message(type) : nullptr;
+}
+
+class Timer {
+    TypeStats* target;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit Timer(TypeStats* target) : target(target) {
+        if (target) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    // Counts one decode of the given size; only the first call counts.
+    void stop(uint64_t bits) {
+        if (target) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            target->add(bits, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            target = nullptr;
+        }
+    }
+};
+
+// Installs stats on the current thread for the lifetime of the scope.
+class Scope {
+    ParseStats* previous;
+
+public:
+    explicit Scope(ParseStats* stats) : previous(active) { active = stats; }
+    ~Scope() { active = previous; }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+#else
+constexpr TypeStats* frame(DemoMessage::Type) {
+    return nullptr;
+}
+
+constexpr TypeStats* net_message(NetMessage::Type) {
+    return nullptr;
+}
+
+class Timer {
+public:
+    explicit constexpr Timer(TypeStats*) {}
+    constexpr void stop(uint64_t) {}
+};
+
+class Scope {
+public:
+    explicit Scope(ParseStats*) {}
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+#endif
+
+}
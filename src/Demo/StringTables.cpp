@@ -0,0 +1,228 @@
+#include "Demo/StringTables.h"
+#include "Demo/NetMessage.h"
+#include "Util/Lzss.h"
+#include "Util/math.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr int STRING_LIMIT = 1024;
+constexpr int SNAPSHOT_NAME_LIMIT = 256;
+constexpr int SNAPSHOT_STRING_LIMIT = 4096;
+
+// The last STRING_HISTORY_SIZE entry strings of one update, oldest first.
+class StringHistory {
+    std::array<std::string_view, STRING_HISTORY_SIZE> strings{};
+    size_t first = 0;
+    size_t count = 0;
+
+public:
+    std::string_view at(size_t index) const {
+        if (index >= count) {
+            throw std::runtime_error("String table history index out of range: " + std::to_string(index));
+        }
+        return strings[(first + index) % STRING_HISTORY_SIZE];
+    }
+
+    void push(std::string_view string) {
+        if (count == STRING_HISTORY_SIZE) {
+            first = (first + 1) % STRING_HISTORY_SIZE;
+            count--;
+        }
+        strings[(first + count) % STRING_HISTORY_SIZE] = string;
+        count++;
+    }
+};
+
+}
+
+NetworkStringTable& StringTables::create(const SvcCreateStringTable& message) {
+    auto& table = add_table(message.table_name, message.max_entries);
+    table.user_data_fixed_size = message.user_data_fixed_size;
+    table.user_data_size = message.user_data_size;
+    table.user_data_size_bits = message.user_data_size_bits;
+
+    BitReader reader = message.data;
+    if (!message.data_compressed) {
+        read_entries(table, reader, message.num_entries);
+        return table;
+    }
+
+    // Compressed tables carry both sizes ahead of the LZSS payload.
+    reader.read_uint32();
+    auto compressed_size = reader.read_uint32();
+    if (static_cast<size_t>(reader.bits_left()) < compressed_size * size_t{ 8 }) {
+        throw std::runtime_error("Compressed string table truncated: " + std::string(table.name));
+    }
+    auto compressed = reader.read_bytes(compressed_size);
+    auto decompressed = lzss::decompress(compressed);
+    BitReader decompressed_reader(decompressed);
+    read_entries(table, decompressed_reader, message.num_entries);
+    return table;
+}
+
+NetworkStringTable& StringTables::update(const SvcUpdateStringTable& message) {
+    auto* table = find(message.table_id);
+    if (!table) {
+        throw std::runtime_error("Update for unknown string table " + std::to_string(message.table_id));
+    }
+    BitReader reader = message.data;
+    read_entries(*table, reader, message.num_changed_entries);
+    return *table;
+}
+
+std::vector<NetworkStringTable*> StringTables::read_snapshot(std::span<const std::byte> data) {
+    std::vector<NetworkStringTable*> touched;
+    BitReader reader(data);
+    std::string name;
+    std::string string;
+
+    int table_count = reader.read_bits(8);
+    for (int i = 0; i < table_count; i++) {
+        reader.read_ascii_string(name, SNAPSHOT_NAME_LIMIT);
+        auto* table = find(name);
+        int entry_count = reader.read_uint16();
+        if (!table) {
+            // Normally created during sign-on; size it to fit the snapshot.
+            table = &add_table(name, std::max(entry_count, 1));
+        }
+
+        table->entries.clear();
+        table->changed.clear();
+        table->entries.reserve(entry_count);
+        for (int entry = 0; entry < entry_count; entry++) {
+            reader.read_ascii_string(string, SNAPSHOT_STRING_LIMIT);
+            auto& added = table->entries.emplace_back();
+            added.string = pool.intern(string);
+            if (reader.read_bit()) {
+                auto size = reader.read_uint16();
+                added.user_data = reader.read_bytes(size);
+            }
+            table->changed.push_back(entry);
+        }
+
+        // Client-side entries are local to the recording client; skip them.
+        if (reader.read_bit()) {
+            int client_count = reader.read_uint16();
+            for (int entry = 0; entry < client_count; entry++) {
+                reader.skip_ascii_string(SNAPSHOT_STRING_LIMIT);
+                if (reader.read_bit()) {
+                    reader.skip_bits(reader.read_uint16() * size_t{ 8 });
+                }
+            }
+        }
+        touched.push_back(table);
+    }
+    return touched;
+}
+
+void StringTables::clear() {
+    tables.clear();
+    by_name.clear();
+    userinfo_table = nullptr;
+    modelprecache_table = nullptr;
+    instancebaseline_table = nullptr;
+}
+
+NetworkStringTable* StringTables::find(int id) {
+    return id >= 0 && static_cast<size_t>(id) < tables.size() ? tables[id].get() : nullptr;
+}
+
+NetworkStringTable* StringTables::find(std::string_view name) {
+    auto found = by_name.find(name);
+    return found != by_name.end() ? found->second : nullptr;
+}
+
+NetworkStringTable& StringTables::add_table(std::string_view name, int max_entries) {
+    if (tables.size() >= MAX_STRING_TABLES) {
+        throw std::runtime_error("Too many string tables");
+    }
+    if (max_entries <= 0) {
+        throw std::runtime_error("String table without entries: " + std::string(name));
+    }
+
+    auto& table = *tables.emplace_back(std::make_unique<NetworkStringTable>());
+    table.id = static_cast<int>(tables.size() - 1);
+    table.name = pool.intern(name);
+    table.max_entries = max_entries;
+    table.entry_bits = Q_log2(max_entries);
+    // A table that is created again under the same name replaces the old one
+    // for lookups by name; ids keep referring to both.
+    by_name[table.name] = &table;
+
+    if (table.name == "userinfo") {
+        userinfo_table = &table;
+    }
+    else if (table.name == "modelprecache") {
+        modelprecache_table = &table;
+    }
+    else if (table.name == "instancebaseline") {
+        instancebaseline_table = &table;
+    }
+    return table;
+}
+
+void StringTables::read_entries(NetworkStringTable& table, BitReader& reader, int count) {
+    StringHistory history;
+    std::string entry;
+    std::string suffix;
+    table.changed.clear();
+
+    int last_index = -1;
+    for (int i = 0; i < count; i++) {
+        int index = last_index + 1;
+        if (!reader.read_bit()) {
+            index = static_cast<int>(reader.read_bits(table.entry_bits));
+        }
+        last_index = index;
+        if (index < 0 || index >= table.max_entries) {
+            throw std::runtime_error("String table index out of range in " + std::string(table.name) + ": " + std::to_string(index));
+        }
+
+        bool has_string = reader.read_bool();
+        if (has_string) {
+            if (reader.read_bool()) {
+                // Prefix of an earlier entry of this update, then the rest.
+                auto previous = history.at(reader.read_bits(5));
+                auto prefix_length = reader.read_bits(SUBSTRING_BITS);
+                entry.assign(previous.substr(0, prefix_length));
+                reader.read_ascii_string(suffix, STRING_LIMIT);
+                entry += suffix;
+            }
+            else {
+                reader.read_ascii_string(entry, STRING_LIMIT);
+            }
+        }
+
+        bool has_user_data = reader.read_bool();
+        std::vector<std::byte> user_data;
+        if (has_user_data) {
+            if (table.user_data_fixed_size) {
+                user_data = reader.read_many_bits(table.user_data_size_bits);
+            }
+            else {
+                user_data = reader.read_bytes(reader.read_bits(MAX_USERDATA_BITS));
+            }
+        }
+
+        std::string_view string;
+        if (static_cast<size_t>(index) < table.entries.size()) {
+            // Existing entries keep their string; only the data changes.
+            auto& existing = table.entries[index];
+            if (has_user_data) {
+                existing.user_data = std::move(user_data);
+            }
+            string = existing.string;
+        }
+        else {
+            table.entries.resize(index);
+            string = pool.intern(has_string ? std::string_view(entry) : std::string_view());
+            table.entries.push_back({ string, std::move(user_data) });
+        }
+        table.changed.push_back(index);
+        history.push(string);
+    }
+}
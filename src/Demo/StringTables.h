@@ -0,0 +1,81 @@
+#pragma once
+#include "Util/BitReader.h"
+#include "Util/StringPool.h"
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct SvcCreateStringTable;
+struct SvcUpdateStringTable;
+
+constexpr int MAX_STRING_TABLES = 32;
+// Entries an update can refer back to, and the width of the prefix length.
+constexpr int STRING_HISTORY_SIZE = 32;
+constexpr int SUBSTRING_BITS = 5;
+constexpr int MAX_USERDATA_BITS = 14;
+
+struct StringTableEntry {
+    // Interned in the owning StringTables' pool.
+    std::string_view string;
+    std::vector<std::byte> user_data;
+};
+
+struct NetworkStringTable {
+    int id{};
+    std::string_view name;
+    int max_entries{};
+    // Width of an explicit entry index in updates.
+    int entry_bits{};
+    bool user_data_fixed_size{};
+    int user_data_size{};
+    int user_data_size_bits{};
+    std::vector<StringTableEntry> entries;
+    // Entries touched by the last create, update or snapshot, in wire order.
+    std::vector<int> changed;
+
+    const StringTableEntry* find(int index) const {
+        return index >= 0 && static_cast<size_t>(index) < entries.size() ? &entries[index] : nullptr;
+    }
+};
+
+// The server's string tables as the client sees them, rebuilt from
+// svc_create_string_table, svc_update_string_table and STRING_TABLES frames.
+// Entry strings are interned in one pool shared by all tables.
+class StringTables {
+public:
+    // Creates a table and decodes its initial entries. Throws
+    // std::runtime_error on malformed data; the table exists regardless.
+    NetworkStringTable& create(const SvcCreateStringTable& message);
+    // Applies changed entries to an existing table.
+    NetworkStringTable& update(const SvcUpdateStringTable& message);
+    // Replaces the entries of the named tables from the body of a
+    // STRING_TABLES frame. Returns the tables it touched.
+    std::vector<NetworkStringTable*> read_snapshot(std::span<const std::byte> data);
+    // Drops every table, keeping the pool.
+    void clear();
+
+    NetworkStringTable* find(int id);
+    NetworkStringTable* find(std::string_view name);
+    const std::vector<std::unique_ptr<NetworkStringTable>>& all() const { return tables; }
+
+    // Tables the decoder needs on every entity or event, or nullptr until
+    // they are created.
+    const NetworkStringTable* userinfo() const { return userinfo_table; }
+    const NetworkStringTable* modelprecache() const { return modelprecache_table; }
+    const NetworkStringTable* instancebaseline() const { return instancebaseline_table; }
+
+    StringPool pool;
+
+private:
+    std::vector<std::unique_ptr<NetworkStringTable>> tables;
+    std::unordered_map<std::string_view, NetworkStringTable*> by_name;
+    NetworkStringTable* userinfo_table = nullptr;
+    NetworkStringTable* modelprecache_table = nullptr;
+    NetworkStringTable* instancebaseline_table = nullptr;
+
+    NetworkStringTable& add_table(std::string_view name, int max_entries);
+    void read_entries(NetworkStringTable& table, BitReader& reader, int count);
+};
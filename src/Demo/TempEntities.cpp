@@ -0,0 +1,94 @@
+#include "Demo/TempEntities.h"
+#include "Demo/NetMessage.h"
+#include <stdexcept>
+#include <string>
+
+void TempEntities::reset(std::shared_ptr<const DataTables> tables) {
+    data_tables = std::move(tables);
+    classes.clear();
+    if (data_tables) {
+        classes.resize(data_tables->flat_classes.size());
+    }
+    events = 0;
+}
+
+void TempEntities::apply(const SvcTempEntities& message, int tick) {
+    if (!data_tables) {
+        throw std::runtime_error("Temp entities without data tables");
+    }
+
+    // Length checked at parse time, as for entity updates.
+    UncheckedBitReader reader(message.data);
+    // Events that do not name a class are deltas from the one before them in
+    // the same message.
+    TempEntityClass* previous = nullptr;
+    uint32_t previous_row = 0;
+    for (int i = 0; i < message.num_entries; i++) {
+        float delay = 0.0f;
+        if (reader.read_bit()) {
+            delay = reader.read_signed_bits(8) / 100.0f;
+        }
+
+        TempEntityClass* state;
+        uint32_t row;
+        if (reader.read_bit()) {
+            // Class ids are sent one-based here.
+            auto class_id = static_cast<int>(reader.read_bits(data_tables->class_bits)) - 1;
+            if (class_id < 0 || static_cast<size_t>(class_id) >= classes.size()) {
+                throw std::runtime_error("Unknown temp entity class " + std::to_string(class_id));
+            }
+            state = &class_state(class_id);
+            row = state->values.acquire(-1);
+        }
+        else {
+            if (!previous) {
+                throw std::runtime_error("Temp entity delta without a previous event");
+            }
+            state = previous;
+            row = state->values.acquire(-1);
+            state->values.copy_row(state->values, previous_row, row);
+        }
+
+        try {
+            state->values.read_props(reader, row, changed_props);
+            if (reader.failed()) {
+                throw std::runtime_error("Temp entity runs past its length");
+            }
+        }
+        catch (...) {
+            // Rows are only appended, so the failed event's row is the last
+            // one; drop it to keep the columns in step with ticks.
+            state->values.pop_row();
+            throw;
+        }
+        state->ticks.push_back(tick);
+        state->delays.push_back(delay);
+        events++;
+        previous = state;
+        previous_row = row;
+    }
+}
+
+const TempEntityClass* TempEntities::find_class(int class_id) const {
+    if (class_id < 0 || static_cast<size_t>(class_id) >= classes.size()) {
+        return nullptr;
+    }
+    return classes[class_id].get();
+}
+
+const TempEntityClass* TempEntities::find_class(std::string_view name) const {
+    for (const auto& state : classes) {
+        if (state && state->values.layout->name == name) {
+            return state.get();
+        }
+    }
+    return nullptr;
+}
+
+TempEntityClass& TempEntities::class_state(int class_id) {
+    auto& state = classes[class_id];
+    if (!state) {
+        state = std::make_unique<TempEntityClass>(data_tables->flat_classes[class_id]);
+    }
+    return *state;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "DataTables.h"
+#include "Entities.h"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+struct SvcTempEntities;
+
+// Every temp entity of one class received so far, one row per event in the
+// order they arrived. Rows are only ever appended, so each column is the
+// full history of one prop value.
+struct TempEntityClass {
+    explicit TempEntityClass(const FlatClass& layout) : values(layout) {}
+
+    // Prop columns, laid out like those of a networked entity class.
+    EntityClass values;
+    // Per row: the tick of the packet and the delay the server attached.
+    std::vector<int32_t> ticks;
+    std::vector<float> delays;
+
+    size_t rows() const { return ticks.size(); }
+};
+
+// Temp entities (impacts, explosions, blood, shots) decoded from
+// svc_temp_entities with the flattened layouts of the data tables.
+class TempEntities {
+public:
+    // Binds to a new set of tables and drops every record.
+    void reset(std::shared_ptr<const DataTables> tables);
+    // Appends the events of one message. Throws std::runtime_error if it is
+    // malformed; events before the error stay appended.
+    void apply(const SvcTempEntities& message, int tick);
+
+    // nullptr until an event of the class has been received.
+    const TempEntityClass* find_class(int class_id) const;
+    const TempEntityClass* find_class(std::string_view name) const;
+
+    // Events appended since the last reset().
+    uint64_t events = 0;
+
+private:
+    std::shared_ptr<const DataTables> data_tables;
+    // Indexed by class id, created on first use.
+    std::vector<std::unique_ptr<TempEntityClass>> classes;
+    std::vector<int> changed_props;
+
+    TempEntityClass& class_state(int class_id);
+};
@@ -0,0 +1,237 @@
+#include "Demo/UserMessages.h"
+#include "Demo/NetMessage.h"
+#include <stdexcept>
+
+namespace {
+
+// Counter-Strike: Source registers its user messages in this order, which
+// makes the index of a name its msg_type.
+constexpr std::string_view CSTRIKE_MESSAGES[] = {
+    "Geiger", "Train", "HudText", "SayText", "SayText2", "TextMsg", "HudMsg", "ResetHUD",
+    "GameTitle", "ItemPickup", "ShowMenu", "Shake", "Fade", "VGUIMenu", "Rumble", "CloseCaption",
+    "SendAudio", "RawAudio", "VoiceMask", "RequestState", "BarTime", "Damage", "RadioText", "HintText",
+    "KeyHintText", "ReloadEffect", "PlayerAnimEvent", "AmmoDenied", "UpdateRadar", "KillCam",
+};
+
+// Trailing parameters are only present up to the last one the server set.
+template <size_t N>
+int read_params(BitReader& reader, std::array<std::string, N>& params) {
+    int count = 0;
+    while (count < static_cast<int>(N) && reader.bits_left() >= 8) {
+        reader.read_ascii_string(params[count++]);
+    }
+    return count;
+}
+
+void read_color(BitReader& reader, std::array<uint8_t, 4>& color) {
+    for (auto& channel : color) {
+        channel = reader.read_uint8();
+    }
+}
+
+}
+
+void SayText::parse(BitReader& reader) {
+    client = reader.read_uint8();
+    reader.read_ascii_string(text);
+    chat = reader.read_uint8() != 0;
+}
+
+void SayText2::parse(BitReader& reader) {
+    client = reader.read_uint8();
+    chat = reader.read_uint8() != 0;
+    reader.read_ascii_string(format);
+    param_count = read_params(reader, params);
+}
+
+void TextMsg::parse(BitReader& reader) {
+    destination = reader.read_uint8();
+    reader.read_ascii_string(format);
+    param_count = read_params(reader, params);
+}
+
+void HudMsg::parse(BitReader& reader) {
+    channel = reader.read_uint8();
+    x = reader.read_float32();
+    y = reader.read_float32();
+    read_color(reader, color1);
+    read_color(reader, color2);
+    effect = reader.read_uint8();
+    fade_in = reader.read_float32();
+    fade_out = reader.read_float32();
+    hold_time = reader.read_float32();
+    fx_time = reader.read_float32();
+    reader.read_ascii_string(text);
+}
+
+void ResetHUD::parse(BitReader& reader) {
+    reset = reader.read_uint8();
+}
+
+void ShowMenu::parse(BitReader& reader) {
+    valid_slots = reader.read_uint16();
+    display_time = reader.read_int8();
+    need_more = reader.read_uint8() != 0;
+    reader.read_ascii_string(text);
+}
+
+void Shake::parse(BitReader& reader) {
+    command = reader.read_uint8();
+    amplitude = reader.read_float32();
+    frequency = reader.read_float32();
+    duration = reader.read_float32();
+}
+
+void Fade::parse(BitReader& reader) {
+    duration = reader.read_uint16();
+    hold_time = reader.read_uint16();
+    flags = reader.read_uint16();
+    read_color(reader, color);
+}
+
+void VGUIMenu::parse(BitReader& reader) {
+    reader.read_ascii_string(name);
+    show = reader.read_uint8() != 0;
+    key_count = reader.read_uint8();
+    if (keys.size() < static_cast<size_t>(key_count)) {
+        keys.resize(key_count);
+    }
+    for (int i = 0; i < key_count; i++) {
+        reader.read_ascii_string(keys[i].first);
+        reader.read_ascii_string(keys[i].second);
+    }
+}
+
+void SendAudio::parse(BitReader& reader) {
+    reader.read_ascii_string(sound);
+}
+
+void BarTime::parse(BitReader& reader) {
+    seconds = reader.read_int16();
+}
+
+void Damage::parse(BitReader& reader) {
+    armor = reader.read_uint8();
+    health = reader.read_uint8();
+    damage_bits = reader.read_int32();
+    // Sent as plain floats, not as a bit coordinate.
+    origin.x = reader.read_float32();
+    origin.y = reader.read_float32();
+    origin.z = reader.read_float32();
+}
+
+void RadioText::parse(BitReader& reader) {
+    destination = reader.read_uint8();
+    client = reader.read_uint8();
+    reader.read_ascii_string(format);
+    param_count = read_params(reader, params);
+}
+
+void HintText::parse(BitReader& reader) {
+    reader.read_ascii_string(text);
+}
+
+void KeyHintText::parse(BitReader& reader) {
+    // Hint count, always 1.
+    reader.read_uint8();
+    reader.read_ascii_string(text);
+}
+
+void ReloadEffect::parse(BitReader& reader) {
+    entity = reader.read_uint16();
+}
+
+void AmmoDenied::parse(BitReader& reader) {
+    ammo_type = reader.read_uint16();
+}
+
+UserMessages::UserMessages() {
+    for (size_t i = 0; i < std::size(CSTRIKE_MESSAGES); i++) {
+        entries[i].name = CSTRIKE_MESSAGES[i];
+    }
+    set<SayText>(find(SayText::NAME));
+    set<SayText2>(find(SayText2::NAME));
+    set<TextMsg>(find(TextMsg::NAME));
+    set<HudMsg>(find(HudMsg::NAME));
+    set<ResetHUD>(find(ResetHUD::NAME));
+    set<ShowMenu>(find(ShowMenu::NAME));
+    set<Shake>(find(Shake::NAME));
+    set<Fade>(find(Fade::NAME));
+    set<VGUIMenu>(find(VGUIMenu::NAME));
+    set<SendAudio>(find(SendAudio::NAME));
+    set<BarTime>(find(BarTime::NAME));
+    set<Damage>(find(Damage::NAME));
+    set<RadioText>(find(RadioText::NAME));
+    set<HintText>(find(HintText::NAME));
+    set<KeyHintText>(find(KeyHintText::NAME));
+    set<ReloadEffect>(find(ReloadEffect::NAME));
+    set<AmmoDenied>(find(AmmoDenied::NAME));
+}
+
+void UserMessages::set(int msg_type, std::string name, Decoder decoder) {
+    if (msg_type < 0 || static_cast<size_t>(msg_type) >= entries.size()) {
+        throw std::out_of_range("User message type out of range: " + std::to_string(msg_type));
+    }
+    // A name moves to its new id rather than being decoded under both.
+    for (auto& entry : entries) {
+        if (entry.name == name) {
+            entry.name.clear();
+            entry.decoder = nullptr;
+        }
+    }
+    entries[msg_type].name = std::move(name);
+    entries[msg_type].decoder = decoder;
+    bind();
+}
+
+int UserMessages::find(std::string_view name) const {
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::string_view UserMessages::name(int msg_type) const {
+    return msg_type >= 0 && static_cast<size_t>(msg_type) < entries.size() ? std::string_view(entries[msg_type].name) : std::string_view();
+}
+
+bool UserMessages::decode(const SvcUserMessage& message, UserMessage& out) const {
+    auto decoder = entries[message.msg_type & 0xFF].decoder;
+    if (!decoder) {
+        return false;
+    }
+    BitReader reader = message.data;
+    decoder(reader, out);
+    return true;
+}
+
+void UserMessages::subscribe(std::string_view name, Handler handler) {
+    subscriptions.push_back({ std::string(name), std::move(handler) });
+    bind();
+}
+
+bool UserMessages::dispatch(const SvcUserMessage& message, int tick) {
+    const auto& entry = entries[message.msg_type & 0xFF];
+    if (entry.handlers.empty() || !decode(message, record)) {
+        return false;
+    }
+    for (auto subscription : entry.handlers) {
+        subscriptions[subscription].handler(record, tick);
+    }
+    dispatched++;
+    return true;
+}
+
+void UserMessages::bind() {
+    for (auto& entry : entries) {
+        entry.handlers.clear();
+    }
+    for (size_t i = 0; i < subscriptions.size(); i++) {
+        int msg_type = find(subscriptions[i].name);
+        if (msg_type >= 0 && entries[msg_type].decoder) {
+            entries[msg_type].handlers.push_back(i);
+        }
+    }
+}
@@ -0,0 +1,251 @@
+#pragma once
+#include "Util/BitReader.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+struct SvcUserMessage;
+
+// Typed payloads of the Counter-Strike: Source user messages. Each decodes
+// straight from the view SvcUserMessage keeps into the packet. Decoding into
+// a record that held the same type before reuses its strings' capacity.
+
+// Chat line with the text already formatted by the server.
+struct SayText {
+    static constexpr std::string_view NAME = "SayText";
+    void parse(BitReader& reader);
+
+    int client{};
+    std::string text;
+    bool chat{};
+};
+
+// Chat line as a localization token plus its parameters, e.g.
+// "Cstrike_Chat_All" with the player name and the text.
+struct SayText2 {
+    static constexpr std::string_view NAME = "SayText2";
+    void parse(BitReader& reader);
+
+    int client{};
+    bool chat{};
+    std::string format;
+    std::array<std::string, 4> params;
+    int param_count{};
+};
+
+// Centre, console or notify text, usually a localization token.
+struct TextMsg {
+    static constexpr std::string_view NAME = "TextMsg";
+    void parse(BitReader& reader);
+
+    // HUD_PRINTNOTIFY 1, HUD_PRINTCONSOLE 2, HUD_PRINTTALK 3, HUD_PRINTCENTER 4.
+    int destination{};
+    std::string format;
+    std::array<std::string, 4> params;
+    int param_count{};
+};
+
+struct HudMsg {
+    static constexpr std::string_view NAME = "HudMsg";
+    void parse(BitReader& reader);
+
+    int channel{};
+    float x{}, y{};
+    std::array<uint8_t, 4> color1{};
+    std::array<uint8_t, 4> color2{};
+    int effect{};
+    float fade_in{}, fade_out{}, hold_time{}, fx_time{};
+    std::string text;
+};
+
+struct ResetHUD {
+    static constexpr std::string_view NAME = "ResetHUD";
+    void parse(BitReader& reader);
+
+    int reset{};
+};
+
+struct ShowMenu {
+    static constexpr std::string_view NAME = "ShowMenu";
+    void parse(BitReader& reader);
+
+    int valid_slots{};
+    int display_time{};
+    bool need_more{};
+    std::string text;
+};
+
+struct Shake {
+    static constexpr std::string_view NAME = "Shake";
+    void parse(BitReader& reader);
+
+    int command{};
+    float amplitude{}, frequency{}, duration{};
+};
+
+struct Fade {
+    static constexpr std::string_view NAME = "Fade";
+    void parse(BitReader& reader);
+
+    int duration{};
+    int hold_time{};
+    int flags{};
+    std::array<uint8_t, 4> color{};
+};
+
+struct VGUIMenu {
+    static constexpr std::string_view NAME = "VGUIMenu";
+    void parse(BitReader& reader);
+
+    std::string name;
+    bool show{};
+    // Key/value pairs; only the first key_count are valid, the rest keep
+    // their capacity for the next decode.
+    std::vector<std::pair<std::string, std::string>> keys;
+    int key_count{};
+};
+
+struct SendAudio {
+    static constexpr std::string_view NAME = "SendAudio";
+    void parse(BitReader& reader);
+
+    std::string sound;
+};
+
+struct BarTime {
+    static constexpr std::string_view NAME = "BarTime";
+    void parse(BitReader& reader);
+
+    int seconds{};
+};
+
+// Damage taken by the recording player since its last update.
+struct Damage {
+    static constexpr std::string_view NAME = "Damage";
+    void parse(BitReader& reader);
+
+    int armor{};
+    int health{};
+    int32_t damage_bits{};
+    Vector origin{};
+};
+
+// Radio command, as a localization token plus its parameters.
+struct RadioText {
+    static constexpr std::string_view NAME = "RadioText";
+    void parse(BitReader& reader);
+
+    int destination{};
+    int client{};
+    std::string format;
+    std::array<std::string, 4> params;
+    int param_count{};
+};
+
+struct HintText {
+    static constexpr std::string_view NAME = "HintText";
+    void parse(BitReader& reader);
+
+    std::string text;
+};
+
+struct KeyHintText {
+    static constexpr std::string_view NAME = "KeyHintText";
+    void parse(BitReader& reader);
+
+    std::string text;
+};
+
+struct ReloadEffect {
+    static constexpr std::string_view NAME = "ReloadEffect";
+    void parse(BitReader& reader);
+
+    int entity{};
+};
+
+struct AmmoDenied {
+    static constexpr std::string_view NAME = "AmmoDenied";
+    void parse(BitReader& reader);
+
+    int ammo_type{};
+};
+
+using UserMessage = std::variant<std::monostate, SayText, SayText2, TextMsg, HudMsg, ResetHUD, ShowMenu, Shake, Fade, VGUIMenu,
+    SendAudio, BarTime, Damage, RadioText, HintText, KeyHintText, ReloadEffect, AmmoDenied>;
+
+// Decoders of user messages, indexed by msg_type. User message ids are
+// assigned by the order the game registers them in, which is not recorded in
+// the demo; the defaults are the ids of Counter-Strike: Source and set()
+// rebinds them for other games or versions. Unregistered types are never
+// decoded.
+class UserMessages {
+public:
+    using Decoder = void (*)(BitReader& reader, UserMessage& out);
+    using Handler = std::function<void(const UserMessage& message, int tick)>;
+
+    UserMessages();
+
+    // Binds msg_type to the decoder of T. A null decoder unbinds it.
+    template <typename T>
+    void set(int msg_type) {
+        set(msg_type, std::string(T::NAME), &decode_as<T>);
+    }
+    void set(int msg_type, std::string name, Decoder decoder);
+    // msg_type bound to a name, or -1.
+    int find(std::string_view name) const;
+    std::string_view name(int msg_type) const;
+
+    // Decodes a registered message into out and returns true; leaves out
+    // alone and returns false otherwise. Throws std::runtime_error if the
+    // payload is shorter than its type requires.
+    bool decode(const SvcUserMessage& message, UserMessage& out) const;
+
+    // Calls handler with every message of type T, in file order. Subscribe
+    // before loading.
+    template <typename T>
+    void subscribe(std::function<void(const T&, int tick)> handler) {
+        subscribe(T::NAME, [handler = std::move(handler)](const UserMessage& message, int tick) {
+            handler(std::get<T>(message), tick);
+        });
+    }
+    void subscribe(std::string_view name, Handler handler);
+    bool has_subscriptions() const { return !subscriptions.empty(); }
+    // Decodes the message and calls its handlers if it has any. Returns
+    // whether it was decoded.
+    bool dispatch(const SvcUserMessage& message, int tick);
+
+    // Messages decoded and handed to handlers so far.
+    uint64_t dispatched = 0;
+
+private:
+    struct Entry {
+        std::string name;
+        Decoder decoder = nullptr;
+        // Indices into subscriptions.
+        std::vector<size_t> handlers;
+    };
+    struct Subscription {
+        std::string name;
+        Handler handler;
+    };
+
+    // Indexed by msg_type, which is one byte on the wire.
+    std::array<Entry, 256> entries;
+    std::vector<Subscription> subscriptions;
+    UserMessage record;
+
+    template <typename T>
+    static void decode_as(BitReader& reader, UserMessage& out) {
+        auto* message = std::get_if<T>(&out);
+        if (!message) {
+            message = &out.emplace<T>();
+        }
+        message->parse(reader);
+    }
+
+    void bind();
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <memory_resource>
 
 constexpr int COORD_INTEGER_BITS = 14;
 constexpr int COORD_FRACTIONAL_BITS = 5;
@@ -26,8 +27,8 @@ struct Vector
 };
 
 struct ConVar {
-	std::string name;
-	std::string value;
+	std::pmr::string name;
+	std::pmr::string value;
 };
 
 struct CmdInfo {
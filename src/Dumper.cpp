@@ -1,55 +1,344 @@
 #include "Dumper.h"
 #include "Demo/Demo.h"
+#include "Demo/NetMessageStore.h"
+#include <stdexcept>
 
-bool Dumper::open(const std::string& output_file_path) const {
-    file.open(output_file_path, std::ios::out);
-    if (!file) {
-        std::cerr << "Failed to open output file: " << output_file_path << std::endl;
-        return false;
+namespace {
+
+constexpr size_t HEADER_WIDTH = 20;
+
+OutputBuffer& put_vector(OutputBuffer& out, float x, float y, float z) {
+    return out.put('(').put(x).put(", ").put(y).put(", ").put(z).put(')');
+}
+
+// One "Name: key=value, key=value" line.
+class Line {
+    OutputBuffer& out;
+    bool first = true;
+
+    OutputBuffer& key(std::string_view name) {
+        out.put(first ? ": " : ", ").put(name).put('=');
+        first = false;
+        return out;
+    }
+
+public:
+    Line(OutputBuffer& out, std::string_view indent, std::string_view name) : out(out) {
+        out.put(indent).put(name);
     }
-    return true;
+    // Destructors must not throw; a failed write is reported by close().
+    ~Line() { out.put_deferred("\n"); }
+
+    template <typename T>
+    Line& field(std::string_view name, const T& value) {
+        key(name).put(value);
+        return *this;
+    }
+    Line& field(std::string_view name, const std::pmr::string& value) {
+        key(name).put(std::string_view(value));
+        return *this;
+    }
+    Line& field(std::string_view name, const Vector& value) {
+        put_vector(key(name), value.x, value.y, value.z);
+        return *this;
+    }
+    Line& field(std::string_view name, const QAngle& value) {
+        put_vector(key(name), value.x, value.y, value.z);
+        return *this;
+    }
+    // Size of an undecoded blob.
+    Line& bits(std::string_view name, int length) {
+        key(name).put(length).put(" bits");
+        return *this;
+    }
+};
+
+}
+
+void Dumper::open(const std::string& output_file_path, bool background_writer) const {
+    out.open(output_file_path, background_writer);
 }
 
 void Dumper::dump_header() const {
-    if (!file.is_open()) {
-        std::cerr << "Output file is not open. Cannot dump header." << std::endl;
-        return;
+    if (!out.is_open()) {
+        throw std::runtime_error("Output file is not open. Cannot dump header.");
     }
 
     const auto& header = demo.header;
-    file << std::left << "HEADER\n"
-        << std::setw(20) << "Demo File Stamp: " << header.file_stamp << "\n"
-        << std::setw(20) << "Demo Protocol: " << header.demo_protocol << "\n"
-        << std::setw(20) << "Network Protocol: " << header.network_protocol << "\n"
-        << std::setw(20) << "Server Name: " << header.server_name << "\n"
-        << std::setw(20) << "Client Name: " << header.client_name << "\n"
-        << std::setw(20) << "Map Name: " << header.map_name << "\n"
-        << std::setw(20) << "Game Directory: " << header.game_directory << "\n"
-        << std::setw(20) << "Playback Time: " << header.playback_time << "\n"
-        << std::setw(20) << "Playback Ticks: " << header.playback_ticks << "\n"
-        << std::setw(20) << "Playback Frames: " << header.playback_frames << "\n"
-        << std::setw(20) << "Signon Length: " << header.signon_length << "\n"
-        << line_break << std::endl;
+    out.put("HEADER\n");
+    out.put_padded("Demo File Stamp: ", HEADER_WIDTH).put(header.file_stamp).put('\n');
+    out.put_padded("Demo Protocol: ", HEADER_WIDTH).put(header.demo_protocol).put('\n');
+    out.put_padded("Network Protocol: ", HEADER_WIDTH).put(header.network_protocol).put('\n');
+    out.put_padded("Server Name: ", HEADER_WIDTH).put(header.server_name).put('\n');
+    out.put_padded("Client Name: ", HEADER_WIDTH).put(header.client_name).put('\n');
+    out.put_padded("Map Name: ", HEADER_WIDTH).put(header.map_name).put('\n');
+    out.put_padded("Game Directory: ", HEADER_WIDTH).put(header.game_directory).put('\n');
+    out.put_padded("Playback Time: ", HEADER_WIDTH).put(header.playback_time).put('\n');
+    out.put_padded("Playback Ticks: ", HEADER_WIDTH).put(header.playback_ticks).put('\n');
+    out.put_padded("Playback Frames: ", HEADER_WIDTH).put(header.playback_frames).put('\n');
+    out.put_padded("Signon Length: ", HEADER_WIDTH).put(header.signon_length).put('\n');
+    out.put(line_break).put('\n');
 }
 
 void Dumper::dump_messages() const {
+    if (!out.is_open()) {
+        throw std::runtime_error("Output file is not open. Cannot dump messages.");
+    }
     for (const auto& msg : demo.messages) {
-        switch (msg->type)
-        {
-        case DemoMessage::Type::SIGN_ON:
-        case DemoMessage::Type::PACKET:
-            break;
-        case DemoMessage::Type::CONSOLE_CMD:
-            break;
-
-        default:
-            break;
-        }
+        dump_frame(*msg);
     }
 }
 
 void Dumper::close() const {
-    if (file.is_open()) {
-        file.close();
+    out.close();
+}
+
+void Dumper::dump_frame(const DemoMessage& message) const {
+    out.put('[').put(message.tick).put("] ").put(frame_name(message.type));
+    switch (message.type)
+    {
+    case DemoMessage::Type::SIGN_ON:
+    case DemoMessage::Type::PACKET:
+        dump_packet(static_cast<const Packet&>(message));
+        return;
+    case DemoMessage::Type::CONSOLE_CMD:
+        out.put(": ").put(std::string_view(static_cast<const ConsoleCmd&>(message).command));
+        break;
+    case DemoMessage::Type::USER_CMD: {
+        const auto& user_cmd = static_cast<const UserCmd&>(message);
+        out.put(": cmd=").put(user_cmd.cmd).put(", size=").put(user_cmd.data.size()).put(" bytes");
+        break;
+    }
+    case DemoMessage::Type::DATA_TABLES:
+        out.put(": size=").put(static_cast<const DataTable&>(message).data.size()).put(" bytes");
+        break;
+    case DemoMessage::Type::STRING_TABLES:
+        out.put(": size=").put(static_cast<const StringTable&>(message).data.size()).put(" bytes");
+        break;
+    default:
+        break;
+    }
+    out.put('\n');
+}
+
+void Dumper::dump_packet(const Packet& packet) const {
+    const auto& info = packet.cmd_info;
+    out.put(": in_sequence=").put(packet.in_sequence).put(", out_sequence=").put(packet.out_sequence)
+        .put(", size=").put(packet.data.size()).put(" bytes\n");
+    Line(out, "  ", "CmdInfo").field("flags", info.flags)
+        .field("view_origin", info.view_origin)
+        .field("view_angles", info.view_angles)
+        .field("local_view_angles", info.local_view_angles);
+
+    switch (demo.net_storage) {
+    case Demo::NetStorage::POLYMORPHIC:
+        for (const auto& net_message : packet.net_messages) {
+            dump_net_message(*net_message);
+        }
+        break;
+    case Demo::NetStorage::COLUMNAR:
+        for (auto ref : packet.net_refs) {
+            dump_net_message(demo.net_store.get(ref));
+        }
+        break;
+    case Demo::NetStorage::LAZY: {
+        // Messages nobody accessed yet are decoded into scratch memory, so
+        // dumping leaves the demo as it was.
+        Arena scratch(1 << 16);
+        for (size_t i = 0; i < packet.net_index.size(); i++) {
+            if (i < packet.net_messages.size() && packet.net_messages[i]) {
+                dump_net_message(*packet.net_messages[i]);
+                continue;
+            }
+            const auto& entry = packet.net_index[i];
+            auto reader = packet.payload();
+            reader.seek(entry.bit_offset);
+            auto net_message = net_message_factories[static_cast<size_t>(entry.type)](scratch.memory());
+            net_message->parse(reader);
+            dump_net_message(*net_message);
+            net_message.reset();
+            scratch.release();
+        }
+        break;
+    }
+    }
+}
+
+void Dumper::dump_net_message(const NetMessage& message) const {
+    constexpr std::string_view indent = "  ";
+    switch (message.type)
+    {
+    case NetMessage::Type::net_nop:
+        Line(out, indent, "NetNop");
+        break;
+    case NetMessage::Type::net_disconnect:
+        Line(out, indent, "NetDisconnect").field("text", static_cast<const NetDisconnect&>(message).text);
+        break;
+    case NetMessage::Type::net_file: {
+        const auto& m = static_cast<const NetFile&>(message);
+        Line(out, indent, "NetFile").field("transfer_id", m.transfer_id).field("file_name", m.file_name)
+            .field("file_requested", m.file_requested);
+        break;
+    }
+    case NetMessage::Type::net_tick: {
+        const auto& m = static_cast<const NetTick&>(message);
+        Line(out, indent, "NetTick").field("tick", m.tick).field("host_frame_time", m.host_frame_time)
+            .field("host_frame_time_std_deviation", m.host_frame_time_std_deviation);
+        break;
+    }
+    case NetMessage::Type::net_string_cmd:
+        Line(out, indent, "NetStringCmd").field("command", static_cast<const NetStringCmd&>(message).command);
+        break;
+    case NetMessage::Type::net_set_con_var: {
+        const auto& m = static_cast<const NetSetConVar&>(message);
+        Line(out, indent, "NetSetConVar").field("count", m.convars.size());
+        for (const auto& convar : m.convars) {
+            out.put(indent).put(indent).put(std::string_view(convar.name)).put('=').put(std::string_view(convar.value)).put('\n');
+        }
+        break;
+    }
+    case NetMessage::Type::net_signon_state: {
+        const auto& m = static_cast<const NetSignonState&>(message);
+        Line(out, indent, "NetSignonState").field("signon_state", m.signon_state).field("spawn_count", m.spawn_count);
+        break;
+    }
+    case NetMessage::Type::svc_print:
+        Line(out, indent, "SvcPrint").field("text", static_cast<const SvcPrint&>(message).text);
+        break;
+    case NetMessage::Type::svc_server_info: {
+        const auto& m = static_cast<const SvcServerInfo&>(message);
+        Line(out, indent, "SvcServerInfo").field("protocol", m.protocol).field("server_count", m.server_count)
+            .field("is_hltv", m.is_hltv).field("is_dedicated", m.is_dedicated).field("client_crc", m.client_crc)
+            .field("max_classes", m.max_classes).field("map_crc", m.map_crc).field("player_slot", m.player_slot)
+            .field("max_clients", m.max_clients).field("tick_interval", m.tick_interval).field("os", m.os)
+            .field("game_dir", m.game_dir).field("map_name", m.map_name).field("sky_name", m.sky_name)
+            .field("host_name", m.host_name).field("is_replay", m.is_replay);
+        break;
+    }
+    case NetMessage::Type::svc_send_table: {
+        const auto& m = static_cast<const SvcSendTable&>(message);
+        Line(out, indent, "SvcSendTable").field("needs_decoder", m.needs_decoder).bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_class_info: {
+        const auto& m = static_cast<const SvcClassInfo&>(message);
+        Line(out, indent, "SvcClassInfo").field("num_server_classes", m.num_server_classes)
+            .field("create_on_client", m.create_on_client);
+        for (const auto& server_class : m.server_classes) {
+            Line(out, "    ", "class").field("id", server_class.classID).field("class_name", server_class.class_name)
+                .field("data_table_name", server_class.data_table_name);
+        }
+        break;
+    }
+    case NetMessage::Type::svc_set_pause:
+        Line(out, indent, "SvcSetPause").field("paused", static_cast<const SvcSetPause&>(message).paused);
+        break;
+    case NetMessage::Type::svc_create_string_table: {
+        const auto& m = static_cast<const SvcCreateStringTable&>(message);
+        Line(out, indent, "SvcCreateStringTable").field("table_name", m.table_name).field("max_entries", m.max_entries)
+            .field("num_entries", m.num_entries).field("user_data_fixed_size", m.user_data_fixed_size)
+            .field("user_data_size", m.user_data_size).field("user_data_size_bits", m.user_data_size_bits)
+            .field("data_compressed", m.data_compressed).bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_update_string_table: {
+        const auto& m = static_cast<const SvcUpdateStringTable&>(message);
+        Line(out, indent, "SvcUpdateStringTable").field("table_id", m.table_id)
+            .field("num_changed_entries", m.num_changed_entries).bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_voice_init: {
+        const auto& m = static_cast<const SvcVoiceInit&>(message);
+        Line(out, indent, "SvcVoiceInit").field("codec", m.codec).field("legacy_quality", m.legacy_quality)
+            .field("sample_rate", m.sample_rate);
+        break;
+    }
+    case NetMessage::Type::svc_voice_data: {
+        const auto& m = static_cast<const SvcVoiceData&>(message);
+        Line(out, indent, "SvcVoiceData").field("from_client", m.from_client).field("proximity", m.proximity)
+            .bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_sounds: {
+        const auto& m = static_cast<const SvcSounds&>(message);
+        Line(out, indent, "SvcSounds").field("reliable_sound", m.reliable_sound).field("num_sounds", m.num_sounds)
+            .bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_set_view:
+        Line(out, indent, "SvcSetView").field("entity_index", static_cast<const SvcSetView&>(message).entity_index);
+        break;
+    case NetMessage::Type::svc_fix_angle: {
+        const auto& m = static_cast<const SvcFixAngle&>(message);
+        Line(out, indent, "SvcFixAngle").field("relative", m.relative).field("angle", m.angle);
+        break;
+    }
+    case NetMessage::Type::svc_crosshair_angle:
+        Line(out, indent, "SvcCrosshairAngle").field("angle", static_cast<const SvcCrosshairAngle&>(message).angle);
+        break;
+    case NetMessage::Type::svc_bsp_decal: {
+        const auto& m = static_cast<const SvcBSPDecal&>(message);
+        Line(out, indent, "SvcBSPDecal").field("pos", m.pos).field("decal_texture_index", m.decal_texture_index)
+            .field("entity_index", m.entity_index).field("model_index", m.model_index).field("low_priority", m.low_priority);
+        break;
+    }
+    case NetMessage::Type::svc_user_message: {
+        const auto& m = static_cast<const SvcUserMessage&>(message);
+        Line line(out, indent, "SvcUserMessage");
+        line.field("msg_type", m.msg_type);
+        if (auto name = demo.user_messages.name(m.msg_type); !name.empty()) {
+            line.field("name", name);
+        }
+        line.bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_entity_message: {
+        const auto& m = static_cast<const SvcEntityMessage&>(message);
+        Line(out, indent, "SvcEntityMessage").field("entity_index", m.entity_index).field("class_id", m.class_id)
+            .bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_game_event:
+        Line(out, indent, "SvcGameEvent").bits("length", static_cast<const SvcGameEvent&>(message).length);
+        break;
+    case NetMessage::Type::svc_packet_entities: {
+        const auto& m = static_cast<const SvcPacketEntities&>(message);
+        Line(out, indent, "SvcPacketEntities").field("max_entries", m.max_entries).field("is_delta", m.is_delta)
+            .field("delta_from", m.delta_from).field("baseline", m.baseline).field("updated_entries", m.updated_entries)
+            .field("update_baseline", m.update_baseline).bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_temp_entities: {
+        const auto& m = static_cast<const SvcTempEntities&>(message);
+        Line(out, indent, "SvcTempEntities").field("num_entries", m.num_entries).bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_prefetch:
+        Line(out, indent, "SvcPrefetch").field("sound_index", static_cast<const SvcPrefetch&>(message).sound_index);
+        break;
+    case NetMessage::Type::svc_menu: {
+        const auto& m = static_cast<const SvcMenu&>(message);
+        Line(out, indent, "SvcMenu").field("menu_type", m.menu_type).bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_game_event_list: {
+        const auto& m = static_cast<const SvcGameEventList&>(message);
+        Line(out, indent, "SvcGameEventList").field("events", m.events).bits("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_get_cvar_value: {
+        const auto& m = static_cast<const SvcGetCvarValue&>(message);
+        Line(out, indent, "SvcGetCvarValue").field("cookie", m.cookie).field("cvar_name", m.cvar_name);
+        break;
+    }
+    case NetMessage::Type::svc_cmd_key_values:
+        // The message counts its payload in bytes.
+        Line(out, indent, "SvcCmdKeyValues").bits("length", static_cast<const SvcCmdKeyValues&>(message).length * 8);
+        break;
+    case NetMessage::Type::svc_set_pause_timed: {
+        const auto& m = static_cast<const SvcSetPauseTimed&>(message);
+        Line(out, indent, "SvcSetPauseTimed").field("paused", m.paused).field("expire_time", m.expire_time);
+        break;
+    }
     }
 }
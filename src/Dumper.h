@@ -1,24 +1,37 @@
 #pragma once
-#include <fstream>
-#include <iostream>
-#include <iomanip> 
+#include "Util/OutputBuffer.h"
+#include <string>
 
 class Demo;
+struct DemoMessage;
+struct NetMessage;
+struct Packet;
 
+// Writes a loaded demo as text. Everything is formatted into one large
+// reusable buffer (see OutputBuffer) and written in big blocks.
 class Dumper {
     const Demo& demo;
-    mutable std::ofstream file;
+    mutable OutputBuffer out;
 
 public:
     Dumper(const Demo& demo)
         : demo(demo) {}
 
-    bool open(const std::string& output_file_path) const;
+    // With background_writer, blocks are written on a second thread while the
+    // next one is formatted. Errors here and below throw std::runtime_error,
+    // so batch workers report them in the demo's log, not on the console.
+    void open(const std::string& output_file_path, bool background_writer = false) const;
     void dump_header() const;
+    // Every frame in file order, with the net messages of each packet in the
+    // demo's storage mode.
     void dump_messages() const;
+    // Throws std::runtime_error if writing the dump failed.
     void close() const;
 
 private:
     const std::string line_break = "=======================================\n";
-};
 
+    void dump_frame(const DemoMessage& message) const;
+    void dump_packet(const Packet& packet) const;
+    void dump_net_message(const NetMessage& message) const;
+};
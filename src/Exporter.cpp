@@ -0,0 +1,249 @@
+#include "Exporter.h"
+#include "Demo/Demo.h"
+#include "Util/Trace.h"
+#include <cmath>
+#include <stdexcept>
+
+using column_file::ColumnSpec;
+using column_file::Encoding;
+using column_file::TableWriter;
+using column_file::Type;
+
+void Exporter::run(const std::string& demo_path, const std::string& output_path) {
+    writer.open(output_path);
+    frames = &writer.add_table("frames", {
+        { "tick", Type::INT32 },
+        { "view_origin.x", Type::FLOAT32 },
+        { "view_origin.y", Type::FLOAT32 },
+        { "view_origin.z", Type::FLOAT32 },
+        { "view_angles.x", Type::FLOAT32 },
+        { "view_angles.y", Type::FLOAT32 },
+        { "view_angles.z", Type::FLOAT32 },
+        { "local_view_angles.x", Type::FLOAT32 },
+        { "local_view_angles.y", Type::FLOAT32 },
+        { "local_view_angles.z", Type::FLOAT32 },
+        { "host_frame_time", Type::FLOAT32 },
+        { "host_frame_time_std_deviation", Type::FLOAT32 },
+    });
+    frame_pending = false;
+    event_tables.clear();
+    entity_tables.clear();
+    for (const auto& name : options.entity_classes) {
+        entity_tables.emplace_back().class_name = name;
+    }
+    if (!entity_tables.empty()) {
+        demo.track_entities = true;
+    }
+
+    demo.parse_stream(demo_path, *this);
+    write_frame();
+    writer.close();
+}
+
+VisitResult Exporter::on_message(const DemoMessage& message) {
+    if (message.type != DemoMessage::Type::PACKET) {
+        return VisitResult::CONTINUE;
+    }
+    write_frame();
+    frame_pending = true;
+    frame_tick = message.tick;
+    frame_info = static_cast<const Packet&>(message).cmd_info;
+    frame_time = NAN;
+    frame_time_std_deviation = NAN;
+    return VisitResult::CONTINUE;
+}
+
+VisitResult Exporter::on_net_message(const Packet& packet, const NetMessage& message) {
+    try {
+        switch (message.type) {
+        case NetMessage::Type::net_tick:
+            if (packet.type == DemoMessage::Type::PACKET) {
+                const auto& net_tick = static_cast<const NetTick&>(message);
+                frame_time = net_tick.host_frame_time;
+                frame_time_std_deviation = net_tick.host_frame_time_std_deviation;
+            }
+            break;
+        case NetMessage::Type::svc_game_event_list:
+            game_events.parse_list(static_cast<const SvcGameEventList&>(message));
+            event_tables.clear();
+            break;
+        case NetMessage::Type::svc_game_event:
+            write_event(static_cast<const SvcGameEvent&>(message), packet.tick);
+            break;
+        case NetMessage::Type::svc_packet_entities:
+            // Demo has applied the update before handing it out.
+            for (auto& entities : entity_tables) {
+                write_entities(entities, packet.tick);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    catch (const std::exception& e) {
+        auto what = message.type == NetMessage::Type::svc_packet_entities ? "entities" : "game event";
+        trace::log() << "Failed to export " << what << ": " << e.what() << std::endl;
+    }
+    return VisitResult::CONTINUE;
+}
+
+Encoding Exporter::string_encoding() const {
+    return options.dictionary_strings ? Encoding::DICTIONARY : Encoding::PLAIN;
+}
+
+void Exporter::write_frame() {
+    if (!frame_pending) {
+        return;
+    }
+    frame_pending = false;
+    size_t column = 0;
+    frames->put(column++, int32_t{ frame_tick });
+    for (float value : {
+        frame_info.view_origin.x, frame_info.view_origin.y, frame_info.view_origin.z,
+        frame_info.view_angles.x, frame_info.view_angles.y, frame_info.view_angles.z,
+        frame_info.local_view_angles.x, frame_info.local_view_angles.y, frame_info.local_view_angles.z,
+        frame_time, frame_time_std_deviation }) {
+        frames->put(column++, value);
+    }
+    frames->end_row();
+    rows++;
+}
+
+void Exporter::write_event(const SvcGameEvent& message, int tick) {
+    BitReader reader = message.data;
+    auto id = static_cast<int>(reader.read_bits(MAX_EVENT_BITS));
+    const auto* descriptor = game_events.find(id);
+    if (!descriptor) {
+        throw std::runtime_error("Unknown game event id " + std::to_string(id));
+    }
+    event.tick = tick;
+    event.decode(*descriptor, reader);
+
+    auto& table = event_table(*descriptor);
+    table.put(0, int32_t{ tick });
+    for (size_t key = 0; key < descriptor->keys.size(); key++) {
+        auto column = key + 1;
+        switch (descriptor->types[key]) {
+        case GameEventKeyType::STRING:
+            table.put(column, event.get_string(static_cast<int>(key)));
+            break;
+        case GameEventKeyType::FLOAT:
+            table.put(column, event.get_float(static_cast<int>(key)));
+            break;
+        default:
+            table.put(column, int32_t{ event.get_int(static_cast<int>(key)) });
+            break;
+        }
+    }
+    table.end_row();
+    rows++;
+}
+
+TableWriter& Exporter::event_table(const GameEventDescriptor& descriptor) {
+    if (event_tables.size() <= static_cast<size_t>(descriptor.id)) {
+        event_tables.resize(descriptor.id + 1);
+    }
+    auto& table = event_tables[descriptor.id];
+    if (table) {
+        return *table;
+    }
+
+    // A repeated list keeps the table of an event that did not change.
+    auto name = "event/" + std::string(descriptor.name);
+    table = writer.find_table(name);
+    std::vector<ColumnSpec> columns{ { "tick", Type::INT32 } };
+    for (size_t key = 0; key < descriptor.keys.size(); key++) {
+        auto type = descriptor.types[key] == GameEventKeyType::STRING ? Type::STRING
+            : descriptor.types[key] == GameEventKeyType::FLOAT ? Type::FLOAT32
+            : Type::INT32;
+        columns.push_back({ std::string(descriptor.keys[key]), type, string_encoding() });
+    }
+    if (table && table->columns().size() != columns.size()) {
+        throw std::runtime_error("Game event " + std::string(descriptor.name) + " changed its keys");
+    }
+    if (!table) {
+        table = &writer.add_table(std::move(name), std::move(columns));
+    }
+    return *table;
+}
+
+void Exporter::write_entities(EntityTable& entities, int tick) {
+    if (entities.tick != std::numeric_limits<int>::min() && tick - entities.tick < options.entity_interval) {
+        return;
+    }
+    const auto* state = demo.entities.find_class(entities.class_name);
+    if (!state) {
+        return;
+    }
+    if (!entities.table) {
+        add_entity_table(entities, *state);
+    }
+    else if (state->layout != entities.layout) {
+        throw std::runtime_error("Layout of " + entities.class_name + " changed");
+    }
+    entities.tick = tick;
+
+    auto& table = *entities.table;
+    for (size_t row = 0; row < state->rows(); row++) {
+        if (state->row_entity[row] < 0) {
+            continue;
+        }
+        table.put(0, int32_t{ tick });
+        table.put(1, state->row_entity[row]);
+        size_t column = 2;
+        for (auto [kind, source] : entities.sources) {
+            switch (kind) {
+            case PropColumns::Kind::INT:
+                table.put(column++, state->ints[source][row]);
+                break;
+            case PropColumns::Kind::FLOAT:
+                table.put(column++, state->floats[source][row]);
+                break;
+            case PropColumns::Kind::STRING:
+                table.put(column++, std::string_view(state->strings[source][row]));
+                break;
+            }
+        }
+        table.end_row();
+        rows++;
+    }
+}
+
+void Exporter::add_entity_table(EntityTable& entities, const EntityClass& state) {
+    static constexpr const char* COMPONENTS[] = { ".x", ".y", ".z" };
+    const auto& layout = *state.layout;
+
+    std::vector<ColumnSpec> columns{ { "tick", Type::INT32 }, { "index", Type::INT32 } };
+    entities.sources.clear();
+    auto add = [&](std::string name, PropColumns::Kind kind, uint32_t source) {
+        auto type = kind == PropColumns::Kind::INT ? Type::INT32
+            : kind == PropColumns::Kind::FLOAT ? Type::FLOAT32
+            : Type::STRING;
+        columns.push_back({ std::move(name), type, string_encoding() });
+        entities.sources.emplace_back(kind, source);
+    };
+
+    for (size_t prop = 0; prop < layout.props.size(); prop++) {
+        const auto& prop_columns = state.columns[prop];
+        // Props that share a name are told apart by their table.
+        auto name = layout.prop_names[prop];
+        if (layout.find(name) != static_cast<int>(prop)) {
+            name = layout.prop_tables[prop] + "." + name;
+        }
+        bool array = layout.props[prop].type == PropType::ARRAY;
+        size_t elements = array ? layout.props[prop].num_elements : 1;
+        for (size_t element = 0; element < elements; element++) {
+            auto element_name = array ? name + "[" + std::to_string(element) + "]" : name;
+            for (size_t component = 0; component < prop_columns.components; component++) {
+                add(prop_columns.components > 1 ? element_name + COMPONENTS[component] : element_name,
+                    prop_columns.kind, static_cast<uint32_t>(prop_columns.first + element * prop_columns.components + component));
+            }
+        }
+        if (array) {
+            add(name + ".count", PropColumns::Kind::INT, prop_columns.count);
+        }
+    }
+
+    entities.layout = &layout;
+    entities.table = &writer.add_table("entity/" + entities.class_name, std::move(columns));
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "Demo/DemoVisitor.h"
+#include "Demo/Entities.h"
+#include "Demo/GameEvents.h"
+#include "Demo/structs.h"
+#include "Util/ColumnFile.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Demo;
+
+struct ExportOptions {
+    // Server classes whose entities are exported, e.g. "CCSPlayer". Empty
+    // exports no entities and leaves entity tracking off.
+    std::vector<std::string> entity_classes;
+    // Entities are sampled on every packet entities update whose tick is at
+    // least this far past the previous sample.
+    int entity_interval = 1;
+    // STRING columns with a per row group dictionary instead of plain bytes.
+    bool dictionary_strings = true;
+    uint32_t row_group_rows = column_file::Writer::DEFAULT_ROW_GROUP_ROWS;
+};
+
+// Streams a demo into a column file (see column_file) with these tables:
+//
+//     frames         one row per packet: tick, CmdInfo view origin and
+//                    angles, and the frame time of the packet's net_tick
+//                    (NaN without one)
+//     event/<name>   one row per game event: tick and every key
+//     entity/<class> one row per entity per sample: tick, index and every
+//                    prop value, vectors split into .x/.y/.z, arrays into
+//                    [i] with a .count column
+//
+// Tables are added as their first row arrives, so events that never occur
+// have no table.
+class Exporter : public DemoVisitor {
+public:
+    Exporter(Demo& demo, ExportOptions options = {})
+        : demo(demo), options(std::move(options)), writer(this->options.row_group_rows) {}
+
+    // Parses the demo at demo_path with Demo::parse_stream and writes the
+    // tables to output_path. Call once per Exporter. Throws
+    // std::runtime_error if either file fails.
+    void run(const std::string& demo_path, const std::string& output_path);
+
+    VisitResult on_message(const DemoMessage& message) override;
+    VisitResult on_net_message(const Packet& packet, const NetMessage& message) override;
+
+    // Rows written so far, over all tables.
+    uint64_t rows = 0;
+
+private:
+    struct EntityTable {
+        std::string class_name;
+        column_file::TableWriter* table = nullptr;
+        // Layout the columns were made for, and where each column after tick
+        // and index is read from in the EntityClass.
+        const FlatClass* layout = nullptr;
+        std::vector<std::pair<PropColumns::Kind, uint32_t>> sources;
+        // Tick of the last sample.
+        int tick = std::numeric_limits<int>::min();
+    };
+
+    Demo& demo;
+    ExportOptions options;
+    column_file::Writer writer;
+    column_file::TableWriter* frames = nullptr;
+    // The packet being streamed. Its row is written when the next packet
+    // starts, once its net_tick has been seen.
+    bool frame_pending = false;
+    int frame_tick = 0;
+    CmdInfo frame_info{};
+    float frame_time = 0;
+    float frame_time_std_deviation = 0;
+    GameEvents game_events;
+    GameEvent event;
+    // Indexed by event id, created on first use.
+    std::vector<column_file::TableWriter*> event_tables;
+    std::vector<EntityTable> entity_tables;
+
+    column_file::Encoding string_encoding() const;
+    void write_frame();
+    void write_event(const SvcGameEvent& message, int tick);
+    column_file::TableWriter& event_table(const GameEventDescriptor& descriptor);
+    void write_entities(EntityTable& entities, int tick);
+    void add_entity_table(EntityTable& entities, const EntityClass& state);
+};
@@ -0,0 +1,412 @@
+#include "NdjsonWriter.h"
+#include "Demo/Demo.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr char HEX[] = "0123456789abcdef";
+
+// Length of the well-formed UTF-8 sequence starting at text[i], which is
+// not ASCII, or 0 if there is none: no overlong forms, surrogates or code
+// points past U+10FFFF.
+size_t utf8_length(std::string_view text, size_t i) {
+    auto byte = [&](size_t at) { return at < text.size() ? static_cast<unsigned char>(text[at]) : 0u; };
+    auto c = byte(i);
+    size_t length;
+    unsigned low = 0x80, high = 0xbf;  // bounds of the second byte
+    if (c >= 0xc2 && c <= 0xdf) {
+        length = 2;
+    }
+    else if (c >= 0xe0 && c <= 0xef) {
+        length = 3;
+        low = c == 0xe0 ? 0xa0 : 0x80;
+        high = c == 0xed ? 0x9f : 0xbf;
+    }
+    else if (c >= 0xf0 && c <= 0xf4) {
+        length = 4;
+        low = c == 0xf0 ? 0x90 : 0x80;
+        high = c == 0xf4 ? 0x8f : 0xbf;
+    }
+    else {
+        return 0;
+    }
+    if (byte(i + 1) < low || byte(i + 1) > high) {
+        return 0;
+    }
+    for (size_t k = 2; k < length; k++) {
+        if ((byte(i + k) & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Strings in a demo are whatever bytes the server sent; bytes that are not
+// valid UTF-8 are written as U+FFFD so every line stays valid JSON.
+void put_json(OutputBuffer& out, std::string_view text) {
+    out.put('"');
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+            continue;
+        }
+        if (c >= 0x80) {
+            if (size_t length = utf8_length(text, i)) {
+                i += length - 1;
+                continue;
+            }
+            out.put(text.substr(run, i - run)).put("\\ufffd");
+            run = i + 1;
+            continue;
+        }
+        out.put(text.substr(run, i - run));
+        run = i + 1;
+        switch (c) {
+        case '"': out.put("\\\""); break;
+        case '\\': out.put("\\\\"); break;
+        case '\n': out.put("\\n"); break;
+        case '\r': out.put("\\r"); break;
+        case '\t': out.put("\\t"); break;
+        default:
+            out.put("\\u00").put(HEX[c >> 4]).put(HEX[c & 0xf]);
+            break;
+        }
+    }
+    out.put(text.substr(run)).put('"');
+}
+
+void put_json(OutputBuffer& out, const std::pmr::string& text) {
+    put_json(out, std::string_view(text));
+}
+
+void put_json(OutputBuffer& out, bool value) {
+    out.put(value ? "true" : "false");
+}
+
+template <typename T>
+    requires std::is_arithmetic_v<T>
+void put_json(OutputBuffer& out, T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (!std::isfinite(value)) {
+            out.put("null");
+            return;
+        }
+    }
+    out.put(value);
+}
+
+void put_json(OutputBuffer& out, const Vector& value) {
+    out.put('[');
+    put_json(out, value.x);
+    out.put(',');
+    put_json(out, value.y);
+    out.put(',');
+    put_json(out, value.z);
+    out.put(']');
+}
+
+void put_json(OutputBuffer& out, const QAngle& value) {
+    put_json(out, Vector{ value.x, value.y, value.z });
+}
+
+}
+
+// One {"tick":..,"<kind>":..,"fields":{..}} line. Fields are written in the
+// same order for every record of a kind, which is what lets the selection
+// be remembered per position instead of looked up per record.
+class NdjsonWriter::Record {
+    NdjsonWriter& writer;
+    std::vector<int8_t>& mask;
+    size_t position = 0;
+    bool first = true;
+
+public:
+    Record(NdjsonWriter& writer, size_t kind, int tick, std::string_view kind_key, std::string_view name)
+        : writer(writer), mask(writer.field_masks[kind]) {
+        auto& out = writer.out;
+        out.put("{\"tick\":").put(tick).put(",\"").put(kind_key).put("\":\"").put(name).put("\",\"fields\":{");
+    }
+    ~Record() {
+        // Destructors must not throw; a failed write is reported by close().
+        writer.out.put_deferred("}}\n");
+        writer.records++;
+    }
+
+    // Writes the key of a field and returns true if the field is selected.
+    bool begin(std::string_view name) {
+        if (position == mask.size()) {
+            mask.push_back(writer.is_selected_field(name) ? 1 : 0);
+        }
+        if (!mask[position++]) {
+            return false;
+        }
+        auto& out = writer.out;
+        out.put(first ? "\"" : ",\"").put(name).put("\":");
+        first = false;
+        return true;
+    }
+
+    template <typename T>
+    Record& field(std::string_view name, const T& value) {
+        if (begin(name)) {
+            put_json(writer.out, value);
+        }
+        return *this;
+    }
+};
+
+NdjsonWriter::NdjsonWriter(Demo& demo, NdjsonOptions options) : demo(demo), options(std::move(options)) {
+    auto wanted = [&](std::string_view name) {
+        return this->options.records.empty()
+            || std::find(this->options.records.begin(), this->options.records.end(), name) != this->options.records.end();
+    };
+    for (int type = 1; type <= static_cast<int>(DemoMessage::Type::LAST_CMD); type++) {
+        selected[type] = wanted(frame_name(static_cast<DemoMessage::Type>(type)));
+    }
+    for (size_t id = 0; id < NET_MESSAGE_ID_COUNT; id++) {
+        auto name = net_message_name(static_cast<NetMessage::Type>(id));
+        selected[FRAME_KINDS + id] = !name.empty() && wanted(name);
+        any_net_message = any_net_message || selected[FRAME_KINDS + id];
+    }
+}
+
+void NdjsonWriter::run(const std::string& demo_path, const std::string& output_path) {
+    out.open(output_path);
+    demo.parse_stream(demo_path, *this);
+    out.close();
+}
+
+VisitResult NdjsonWriter::on_message(const DemoMessage& message) {
+    if (selected[static_cast<size_t>(message.type)]) {
+        write_frame(message);
+    }
+    bool packet = message.type == DemoMessage::Type::PACKET || message.type == DemoMessage::Type::SIGN_ON;
+    return packet && !any_net_message ? VisitResult::SKIP_PACKET : VisitResult::CONTINUE;
+}
+
+VisitResult NdjsonWriter::on_net_message(const Packet& packet, const NetMessage& message) {
+    if (selected[FRAME_KINDS + static_cast<size_t>(message.type)]) {
+        write_net_message(packet.tick, message);
+    }
+    return VisitResult::CONTINUE;
+}
+
+bool NdjsonWriter::is_selected_field(std::string_view name) const {
+    return options.fields.empty() || std::find(options.fields.begin(), options.fields.end(), name) != options.fields.end();
+}
+
+void NdjsonWriter::write_frame(const DemoMessage& message) {
+    Record record(*this, static_cast<size_t>(message.type), message.tick, "frame", frame_name(message.type));
+    switch (message.type) {
+    case DemoMessage::Type::SIGN_ON:
+    case DemoMessage::Type::PACKET: {
+        const auto& packet = static_cast<const Packet&>(message);
+        const auto& info = packet.cmd_info;
+        record.field("in_sequence", packet.in_sequence).field("out_sequence", packet.out_sequence)
+            .field("size", packet.data.size()).field("flags", info.flags).field("view_origin", info.view_origin)
+            .field("view_angles", info.view_angles).field("local_view_angles", info.local_view_angles);
+        break;
+    }
+    case DemoMessage::Type::CONSOLE_CMD:
+        record.field("command", static_cast<const ConsoleCmd&>(message).command);
+        break;
+    case DemoMessage::Type::USER_CMD: {
+        const auto& user_cmd = static_cast<const UserCmd&>(message);
+        record.field("cmd", user_cmd.cmd).field("size", user_cmd.data.size());
+        break;
+    }
+    case DemoMessage::Type::DATA_TABLES:
+        record.field("size", static_cast<const DataTable&>(message).data.size());
+        break;
+    case DemoMessage::Type::STRING_TABLES:
+        record.field("size", static_cast<const StringTable&>(message).data.size());
+        break;
+    default:
+        break;
+    }
+}
+
+void NdjsonWriter::write_net_message(int tick, const NetMessage& message) {
+    Record record(*this, FRAME_KINDS + static_cast<size_t>(message.type), tick, "message", net_message_name(message.type));
+    switch (message.type)
+    {
+    case NetMessage::Type::net_nop:
+        break;
+    case NetMessage::Type::net_disconnect:
+        record.field("text", static_cast<const NetDisconnect&>(message).text);
+        break;
+    case NetMessage::Type::net_file: {
+        const auto& m = static_cast<const NetFile&>(message);
+        record.field("transfer_id", m.transfer_id).field("file_name", m.file_name).field("file_requested", m.file_requested);
+        break;
+    }
+    case NetMessage::Type::net_tick: {
+        const auto& m = static_cast<const NetTick&>(message);
+        record.field("tick", m.tick).field("host_frame_time", m.host_frame_time)
+            .field("host_frame_time_std_deviation", m.host_frame_time_std_deviation);
+        break;
+    }
+    case NetMessage::Type::net_string_cmd:
+        record.field("command", static_cast<const NetStringCmd&>(message).command);
+        break;
+    case NetMessage::Type::net_set_con_var: {
+        const auto& m = static_cast<const NetSetConVar&>(message);
+        if (record.begin("convars")) {
+            out.put('{');
+            for (size_t i = 0; i < m.convars.size(); i++) {
+                if (i > 0) {
+                    out.put(',');
+                }
+                put_json(out, m.convars[i].name);
+                out.put(':');
+                put_json(out, m.convars[i].value);
+            }
+            out.put('}');
+        }
+        break;
+    }
+    case NetMessage::Type::net_signon_state: {
+        const auto& m = static_cast<const NetSignonState&>(message);
+        record.field("signon_state", m.signon_state).field("spawn_count", m.spawn_count);
+        break;
+    }
+    case NetMessage::Type::svc_print:
+        record.field("text", static_cast<const SvcPrint&>(message).text);
+        break;
+    case NetMessage::Type::svc_server_info: {
+        const auto& m = static_cast<const SvcServerInfo&>(message);
+        record.field("protocol", m.protocol).field("server_count", m.server_count)
+            .field("is_hltv", m.is_hltv).field("is_dedicated", m.is_dedicated).field("client_crc", m.client_crc)
+            .field("max_classes", m.max_classes).field("map_crc", m.map_crc).field("player_slot", m.player_slot)
+            .field("max_clients", m.max_clients).field("tick_interval", m.tick_interval).field("os", m.os)
+            .field("game_dir", m.game_dir).field("map_name", m.map_name).field("sky_name", m.sky_name)
+            .field("host_name", m.host_name).field("is_replay", m.is_replay);
+        break;
+    }
+    case NetMessage::Type::svc_send_table: {
+        const auto& m = static_cast<const SvcSendTable&>(message);
+        record.field("needs_decoder", m.needs_decoder).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_class_info: {
+        const auto& m = static_cast<const SvcClassInfo&>(message);
+        record.field("num_server_classes", m.num_server_classes).field("create_on_client", m.create_on_client);
+        if (record.begin("classes")) {
+            out.put('[');
+            for (size_t i = 0; i < m.server_classes.size(); i++) {
+                const auto& server_class = m.server_classes[i];
+                out.put(i > 0 ? ",{\"id\":" : "{\"id\":").put(server_class.classID).put(",\"class_name\":");
+                put_json(out, server_class.class_name);
+                out.put(",\"data_table_name\":");
+                put_json(out, server_class.data_table_name);
+                out.put('}');
+            }
+            out.put(']');
+        }
+        break;
+    }
+    case NetMessage::Type::svc_set_pause:
+        record.field("paused", static_cast<const SvcSetPause&>(message).paused);
+        break;
+    case NetMessage::Type::svc_create_string_table: {
+        const auto& m = static_cast<const SvcCreateStringTable&>(message);
+        record.field("table_name", m.table_name).field("max_entries", m.max_entries)
+            .field("num_entries", m.num_entries).field("user_data_fixed_size", m.user_data_fixed_size)
+            .field("user_data_size", m.user_data_size).field("user_data_size_bits", m.user_data_size_bits)
+            .field("data_compressed", m.data_compressed).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_update_string_table: {
+        const auto& m = static_cast<const SvcUpdateStringTable&>(message);
+        record.field("table_id", m.table_id).field("num_changed_entries", m.num_changed_entries).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_voice_init: {
+        const auto& m = static_cast<const SvcVoiceInit&>(message);
+        record.field("codec", m.codec).field("legacy_quality", m.legacy_quality).field("sample_rate", m.sample_rate);
+        break;
+    }
+    case NetMessage::Type::svc_voice_data: {
+        const auto& m = static_cast<const SvcVoiceData&>(message);
+        record.field("from_client", m.from_client).field("proximity", m.proximity).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_sounds: {
+        const auto& m = static_cast<const SvcSounds&>(message);
+        record.field("reliable_sound", m.reliable_sound).field("num_sounds", m.num_sounds).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_set_view:
+        record.field("entity_index", static_cast<const SvcSetView&>(message).entity_index);
+        break;
+    case NetMessage::Type::svc_fix_angle: {
+        const auto& m = static_cast<const SvcFixAngle&>(message);
+        record.field("relative", m.relative).field("angle", m.angle);
+        break;
+    }
+    case NetMessage::Type::svc_crosshair_angle:
+        record.field("angle", static_cast<const SvcCrosshairAngle&>(message).angle);
+        break;
+    case NetMessage::Type::svc_bsp_decal: {
+        const auto& m = static_cast<const SvcBSPDecal&>(message);
+        record.field("pos", m.pos).field("decal_texture_index", m.decal_texture_index)
+            .field("entity_index", m.entity_index).field("model_index", m.model_index).field("low_priority", m.low_priority);
+        break;
+    }
+    case NetMessage::Type::svc_user_message: {
+        const auto& m = static_cast<const SvcUserMessage&>(message);
+        // name is empty for ids the registry does not know.
+        record.field("msg_type", m.msg_type).field("name", demo.user_messages.name(m.msg_type)).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_entity_message: {
+        const auto& m = static_cast<const SvcEntityMessage&>(message);
+        record.field("entity_index", m.entity_index).field("class_id", m.class_id).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_game_event:
+        record.field("length", static_cast<const SvcGameEvent&>(message).length);
+        break;
+    case NetMessage::Type::svc_packet_entities: {
+        const auto& m = static_cast<const SvcPacketEntities&>(message);
+        record.field("max_entries", m.max_entries).field("is_delta", m.is_delta)
+            .field("delta_from", m.delta_from).field("baseline", m.baseline).field("updated_entries", m.updated_entries)
+            .field("update_baseline", m.update_baseline).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_temp_entities: {
+        const auto& m = static_cast<const SvcTempEntities&>(message);
+        record.field("num_entries", m.num_entries).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_prefetch:
+        record.field("sound_index", static_cast<const SvcPrefetch&>(message).sound_index);
+        break;
+    case NetMessage::Type::svc_menu: {
+        const auto& m = static_cast<const SvcMenu&>(message);
+        record.field("menu_type", m.menu_type).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_game_event_list: {
+        const auto& m = static_cast<const SvcGameEventList&>(message);
+        record.field("events", m.events).field("length", m.length);
+        break;
+    }
+    case NetMessage::Type::svc_get_cvar_value: {
+        const auto& m = static_cast<const SvcGetCvarValue&>(message);
+        record.field("cookie", m.cookie).field("cvar_name", m.cvar_name);
+        break;
+    }
+    case NetMessage::Type::svc_cmd_key_values:
+        // The message counts its payload in bytes; records use bits.
+        record.field("length", static_cast<const SvcCmdKeyValues&>(message).length * 8);
+        break;
+    case NetMessage::Type::svc_set_pause_timed: {
+        const auto& m = static_cast<const SvcSetPauseTimed&>(message);
+        record.field("paused", m.paused).field("expire_time", m.expire_time);
+        break;
+    }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Demo/DemoVisitor.h"
+#include "Demo/NetMessageStore.h"
+#include "Util/OutputBuffer.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Demo;
+
+struct NdjsonOptions {
+    // Frame types ("PACKET", "CONSOLE_CMD", ...) and net message names
+    // ("NetTick", "SvcGameEvent", ...) to write records for. Empty writes
+    // every frame and net message.
+    std::vector<std::string> records;
+    // Fields to write in "fields", by name. Empty writes all of them.
+    std::vector<std::string> fields;
+};
+
+// Streams a demo as newline-delimited JSON, one object per frame and per net
+// message, straight from Demo::parse_stream:
+//
+//     {"tick":100,"frame":"PACKET","fields":{"in_sequence":5,...}}
+//     {"tick":100,"message":"NetTick","fields":{"tick":100,...}}
+//
+// Vectors and angles are [x,y,z] arrays, blob lengths are in bits and floats
+// that are not finite are null. Records are formatted into one reusable
+// OutputBuffer, so a record allocates nothing. Records and fields that are
+// not selected are never formatted, and packets are not decoded at all when
+// no net message is selected.
+class NdjsonWriter : public DemoVisitor {
+public:
+    NdjsonWriter(Demo& demo, NdjsonOptions options = {});
+
+    // Parses the demo at demo_path and writes its records to output_path, or
+    // to stdout for "-". Throws std::runtime_error if either file fails.
+    void run(const std::string& demo_path, const std::string& output_path);
+
+    VisitResult on_message(const DemoMessage& message) override;
+    VisitResult on_net_message(const Packet& packet, const NetMessage& message) override;
+
+    // Records written so far.
+    uint64_t records = 0;
+
+private:
+    // Frame types and net message ids share one numbering: frame types
+    // first, net messages after them.
+    static constexpr size_t FRAME_KINDS = 16;
+    static constexpr size_t KINDS = FRAME_KINDS + NET_MESSAGE_ID_COUNT;
+
+    Demo& demo;
+    NdjsonOptions options;
+    OutputBuffer out;
+    std::array<bool, KINDS> selected{};
+    bool any_net_message = false;
+    // Per kind, whether each field in the order the record writes them is
+    // selected: 1 or 0, filled in on first use.
+    std::array<std::vector<int8_t>, KINDS> field_masks;
+
+    class Record;
+
+    bool is_selected_field(std::string_view name) const;
+    void write_frame(const DemoMessage& message);
+    void write_net_message(int tick, const NetMessage& message);
+};
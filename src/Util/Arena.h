@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+// Destroys an arena-allocated object without freeing its memory; the arena
+// releases the memory of all its objects at once.
+struct ArenaDelete {
+    template <typename T>
+    void operator()(T* object) const {
+        std::destroy_at(object);
+    }
+};
+
+template <typename T>
+using ArenaPtr = std::unique_ptr<T, ArenaDelete>;
+
+// Constructs a T in memory. The object receives the resource as its last
+// constructor argument so its own strings and vectors can allocate from it too.
+// ArenaDelete never hands the storage back, so memory must be one that frees
+// in bulk, such as an Arena's; any other resource would leak every object.
+template <typename T, typename... Args>
+ArenaPtr<T> make_in(std::pmr::memory_resource* memory, Args&&... args) {
+    void* storage = memory->allocate(sizeof(T), alignof(T));
+    return ArenaPtr<T>(new (storage) T(std::forward<Args>(args)..., memory));
+}
+
+// Bump allocator backing all messages of a demo. Allocation is a pointer
+// increment; nothing is returned to the system until release() or destruction.
+// release() keeps the initial block, so an arena that is reset after every
+// frame settles into reusing the same memory.
+class Arena {
+    std::unique_ptr<std::byte[]> initial_block;
+    std::pmr::monotonic_buffer_resource resource;
+
+public:
+    explicit Arena(size_t initial_size = 1 << 20)
+        : initial_block(new std::byte[initial_size]),
+          resource(initial_block.get(), initial_size) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    std::pmr::memory_resource* memory() {
+        return &resource;
+    }
+
+    template <typename T, typename... Args>
+    ArenaPtr<T> make(Args&&... args) {
+        return make_in<T>(&resource, std::forward<Args>(args)...);
+    }
+
+    // Every object allocated from the arena must already be destroyed.
+    void release() {
+        resource.release();
+    }
+};
@@ -1,55 +1,106 @@
 #pragma once
-#include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include <ios>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstring>
 #include <stdexcept>
 
+// Reads little-endian values from an in-memory demo image, usually a
+// MappedFile. read_span() hands out views into that memory instead of copies;
+// they are valid for as long as the underlying bytes are.
 class BinaryReader {
-    std::ifstream& file;
+    std::span<const std::byte> data;
+    size_t position = 0;
+
+    const std::byte* take(size_t length) {
+        if (length > data.size() - position) {
+            throw std::runtime_error("Failed to read " + std::to_string(length) + " bytes or reached EOF.");
+        }
+        const std::byte* start = data.data() + position;
+        position += length;
+        return start;
+    }
+
+    template <typename T>
+    T read_value() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
 
 public:
-    explicit BinaryReader(std::ifstream& file) : file(file) {}
+    explicit BinaryReader(std::span<const std::byte> data) : data(data) {}
+
+    void seek(std::streamoff offset, std::ios_base::seekdir direction = std::ios::beg) {
+        std::streamoff base = 0;
+        if (direction == std::ios::cur) {
+            base = static_cast<std::streamoff>(position);
+        }
+        else if (direction == std::ios::end) {
+            base = static_cast<std::streamoff>(data.size());
+        }
+        std::streamoff target = base + offset;
+        if (target < 0 || target > static_cast<std::streamoff>(data.size())) {
+            throw std::out_of_range("Seek position is beyond the end of the file.");
+        }
+        position = static_cast<size_t>(target);
+    }
+
+    size_t tell() const {
+        return position;
+    }
 
-    void seek(std::streampos position, std::ios_base::seekdir direction = std::ios::beg) {
-        file.seekg(position, direction);
+    size_t size() const {
+        return data.size();
+    }
+
+    // The bytes from the current position to the end.
+    std::span<const std::byte> remaining() const {
+        return data.subspan(position);
+    }
+
+    std::span<const std::byte> read_span(size_t length) {
+        return { take(length), length };
     }
 
     std::vector<std::byte> read_bytes(size_t length) {
-        std::vector<std::byte> buffer(length);
-        if (!file.read(reinterpret_cast<char*>(buffer.data()), length)) {
-            throw std::runtime_error("Failed to read " + std::to_string(length) + " bytes or reached EOF.");
-        }
-        return buffer;
+        auto bytes = read_span(length);
+        return { bytes.begin(), bytes.end() };
     }
 
-    std::string read_string(size_t length) {
-        std::vector<char> buffer(length + 1, '\0');
-        file.read(buffer.data(), length);
-        return std::string(buffer.data());
+    // Reads a fixed-size field and returns the text up to its first NUL as a
+    // view into the underlying bytes.
+    std::string_view read_string(size_t length) {
+        const char* start = reinterpret_cast<const char*>(take(length));
+        const void* terminator = std::memchr(start, '\0', length);
+        return std::string_view(start, terminator ? static_cast<const char*>(terminator) - start : length);
     }
 
     uint8_t read_byte() {
-        char buffer;
-        if (!file.read(&buffer, 1)) {
-            throw std::runtime_error("Failed to read byte or reached EOF.");
-        }
-        return buffer;
+        return std::to_integer<uint8_t>(*take(1));
     }
 
     int32_t read_int32() {
-        int32_t value = 0;
-        file.read(reinterpret_cast<char*>(&value), sizeof(value));
-        return value;
+        return read_value<int32_t>();
+    }
+
+    uint32_t read_uint32() {
+        return read_value<uint32_t>();
+    }
+
+    uint64_t read_uint64() {
+        return read_value<uint64_t>();
     }
 
     float read_float32() {
-        float value = 0.0f;
-        file.read(reinterpret_cast<char*>(&value), sizeof(value));
-        return value;
+        return read_value<float>();
     }
 
     bool eof() const {
-        return file.eof();
+        return position >= data.size();
     }
 };
@@ -1,24 +1,293 @@
 #pragma once
 
+#include "Demo/structs.h"
 #include <cstdint>
+#include <span>
 #include <vector>
+#include <string>
 #include <stdexcept>
 #include <bit>
 #include <cstring>
 #include <cstddef>
 #include <cmath>
+#include <algorithm>
+
+// Why a non-throwing reader failed; see BasicBitReader::error().
+enum class ReadError : uint8_t {
+    NONE,
+    PAST_END,        // a read or seek ran past the end of the view
+    BAD_BIT_COUNT,   // a field read of more than 32 (or, signed, of 0) bits
+    BAD_VAR_INT,     // a varint longer than 5 bytes
+};
+
+// What a reader does when a read cannot be done: checked policies validate
+// the bit count of field reads, throwing policies report failures with
+// exceptions (std::out_of_range, std::invalid_argument, std::runtime_error).
+//
+// CheckedReads validates and throws. It is what BitReader uses.
+//
+// NothrowReads validates but never throws: the first failure is kept in
+// error() and every read after it returns zeros, so a decoder tests failed()
+// once per message instead of unwinding. Net messages are decoded this way.
+//
+// UncheckedReads is for payloads whose length was already validated against
+// their packet, such as the entity data of SvcPacketEntities: bit counts are
+// trusted and failures are kept as with NothrowReads.
+//
+// Memory is never read past the view's bytes under any policy, and bulk reads
+// (read_view, read_bytes, read_many_bits, skip_bits) always check their length.
+struct CheckedReads {
+    static constexpr bool checked = true;
+    static constexpr bool throws = true;
+};
+
+struct NothrowReads {
+    static constexpr bool checked = true;
+    static constexpr bool throws = false;
+};
+
+struct UncheckedReads {
+    static constexpr bool checked = false;
+    static constexpr bool throws = false;
+};
+
+// Reads little-endian bit streams as written by the Source engine's bf_write.
+// Bits are pulled from a 64-bit cache that is refilled a whole word at a time,
+// so extracting a field is a mask and a shift rather than a loop over bits.
+//
+// A BitReader never owns its bytes. It is a view over memory owned by someone
+// else (a Packet's payload, a mapped demo file, a pooled buffer), and that
+// owner must outlive the reader, every copy of it and every view taken from it
+// with read_view(). Copies are cheap and independent: each has its own
+// position over the same bytes.
+template <typename Policy>
+class BasicBitReader {
+    template <typename>
+    friend class BasicBitReader;
+
+    std::span<const std::byte> data;  // whole bytes covering the view
+    size_t begin_bit = 0;     // first bit of the view within data[0]
+    size_t end_bit = 0;       // one past the last bit of the view, from data[0]
+    size_t byte_offset = 0;   // next byte to be loaded into the cache
+    uint64_t cache = 0;       // unread bits, lowest bit first
+    int cache_bits = 0;       // number of valid bits in cache
+    ReadError failure = ReadError::NONE;  // first failure of a non-throwing reader
+
+    // Bits of the last byte that lie past end_bit.
+    int tail_bits() const {
+        return static_cast<int>(data.size() * 8 - end_bit);
+    }
+
+    size_t position() const {
+        size_t loaded = byte_offset * 8;
+        if (byte_offset == data.size()) {
+            loaded -= tail_bits();
+        }
+        return loaded - cache_bits;
+    }
+
+    static uint64_t load_word(const std::byte* src) {
+        uint64_t word;
+        std::memcpy(&word, src, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big) {
+            word = ((word & 0x00000000FFFFFFFFull) << 32) | ((word & 0xFFFFFFFF00000000ull) >> 32);
+            word = ((word & 0x0000FFFF0000FFFFull) << 16) | ((word & 0xFFFF0000FFFF0000ull) >> 16);
+            word = ((word & 0x00FF00FF00FF00FFull) << 8) | ((word & 0xFF00FF00FF00FF00ull) >> 8);
+        }
+        return word;
+    }
+
+    // The last bytes of the view as a word, zero-padded past the end.
+    static uint64_t load_tail(const std::byte* src, size_t num_bytes) {
+        std::byte padded[sizeof(uint64_t)]{};
+        std::memcpy(padded, src, num_bytes);
+        return load_word(padded);
+    }
+
+    // Tops the cache up with as many whole bytes as fit, from one word load.
+    // Bits above cache_bits may already hold the following bytes; OR-ing the
+    // same data again is harmless. Near the end of the view the word comes
+    // from a zero-padded copy, so nothing past data is read. Loading the last
+    // byte also drops its bits past end_bit from the count.
+    void refill() {
+        if (byte_offset == data.size()) {
+            return;
+        }
+        size_t available = data.size() - byte_offset;
+        int taken = (64 - cache_bits) >> 3;
+        if (available >= sizeof(uint64_t)) [[likely]] {
+            cache |= load_word(data.data() + byte_offset) << cache_bits;
+        }
+        else {
+            cache |= load_tail(data.data() + byte_offset, available) << cache_bits;
+            taken = std::min(taken, static_cast<int>(available));
+        }
+        byte_offset += taken;
+        cache_bits += taken * 8;
+        if (byte_offset == data.size()) {
+            cache_bits -= tail_bits();
+        }
+    }
+
+    void ensure_bits(int num_bits) {
+        if (cache_bits < num_bits) {
+            refill();
+            if (cache_bits < num_bits) [[unlikely]] {
+                if constexpr (Policy::throws) {
+                    throw std::out_of_range("Attempting to read beyond the buffer limit.");
+                }
+                else {
+                    pad_cache(num_bits);
+                }
+            }
+        }
+    }
+
+    // Past the end of a non-throwing reader: the missing bits read as zero
+    // and are consumed in place, so the position stays at end_bit.
+    void pad_cache(int num_bits) {
+        cache = cache_bits > 0 ? cache & (~uint64_t{ 0 } >> (64 - cache_bits)) : 0;
+        cache_bits = num_bits;
+        fail(ReadError::PAST_END);
+    }
 
-class BitReader {
-    std::vector<std::byte> data;
-    size_t bit_offset = 0;
+    void fail(ReadError error) {
+        if (failure == ReadError::NONE) {
+            failure = error;
+        }
+    }
+
+    // Whether the next num_bits can be read in bulk. A non-throwing reader
+    // that cannot moves to the end instead, so later reads fail as well.
+    bool check_remaining(size_t num_bits) {
+        if (num_bits > static_cast<size_t>(bits_left())) [[unlikely]] {
+            if constexpr (Policy::throws) {
+                throw std::out_of_range("Attempting to read beyond the buffer limit.");
+            }
+            else {
+                seek_to(end_bit);
+                fail(ReadError::PAST_END);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Whether num_bits is a valid width for a field read, at least min_bits.
+    bool check_bit_count(int num_bits, int min_bits, const char* what) {
+        if constexpr (Policy::checked) {
+            if (num_bits < min_bits || num_bits > 32) [[unlikely]] {
+                if constexpr (Policy::throws) {
+                    throw std::invalid_argument(what);
+                }
+                else {
+                    fail(ReadError::BAD_BIT_COUNT);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    uint32_t take_bits(int num_bits) {
+        ensure_bits(num_bits);
+        return static_cast<uint32_t>(cache & ((uint64_t{ 1 } << num_bits) - 1));
+    }
+
+    // Copies num_bytes whole bytes starting at the current position into dest and
+    // advances past them. Byte-aligned input is a straight memcpy; otherwise each
+    // output word is merged from two neighbouring input words.
+    void copy_bytes(std::byte* dest, size_t num_bytes) {
+        if (num_bytes == 0) {
+            return;
+        }
+        size_t start = position();
+        const std::byte* src = data.data() + start / 8;
+        int shift = start % 8;
+
+        if (shift == 0) {
+            std::memcpy(dest, src, num_bytes);
+        }
+        else {
+            size_t i = 0;
+            // Each step reads src[i .. i + 8], so stay one byte clear of the end.
+            for (; i + sizeof(uint64_t) < num_bytes; i += sizeof(uint64_t)) {
+                uint64_t lo = load_word(src + i);
+                uint64_t hi = std::to_integer<uint64_t>(src[i + sizeof(uint64_t)]);
+                uint64_t merged = (lo >> shift) | (hi << (64 - shift));
+                for (size_t b = 0; b < sizeof(uint64_t); ++b) {
+                    dest[i + b] = static_cast<std::byte>(merged >> (b * 8));
+                }
+            }
+            for (; i < num_bytes; ++i) {
+                auto lo = std::to_integer<unsigned>(src[i]);
+                auto hi = std::to_integer<unsigned>(src[i + 1]);
+                dest[i] = static_cast<std::byte>((lo >> shift) | (hi << (8 - shift)));
+            }
+        }
+        seek_to(start + num_bytes * 8);
+    }
+
+    void seek_to(size_t bit) {
+        byte_offset = bit / 8;
+        cache = 0;
+        cache_bits = 0;
+        int skip = bit % 8;
+        if (skip > 0) {
+            refill();
+            cache >>= skip;
+            cache_bits -= skip;
+        }
+    }
+
+    BasicBitReader(std::span<const std::byte> bytes, size_t first_bit, size_t num_bits)
+        : data(bytes), begin_bit(first_bit), end_bit(first_bit + num_bits) {
+        seek_to(begin_bit);
+    }
 
 public:
-    explicit BitReader(const std::vector<std::byte>& source)
-        : data(source) {}
+    BasicBitReader() = default;
+
+    explicit BasicBitReader(std::span<const std::byte> source)
+        : data(source), end_bit(source.size() * 8) {}
+
+    // The reader would outlive a temporary buffer; keep the bytes alive elsewhere.
+    explicit BasicBitReader(std::vector<std::byte>&&) = delete;
+
+    // The same view and position under another policy, typically an unchecked
+    // reader over a view whose length was validated when it was read.
+    template <typename Other>
+    explicit BasicBitReader(const BasicBitReader<Other>& other)
+        : data(other.data), begin_bit(other.begin_bit), end_bit(other.end_bit), byte_offset(other.byte_offset),
+          cache(other.cache), cache_bits(other.cache_bits), failure(other.failure) {}
 
     int bits_left() const {
-        int total_bits = static_cast<int>(data.size()) * 8;
-        return total_bits - bit_offset;
+        return static_cast<int>(end_bit - position());
+    }
+
+    // Whether a read of a non-throwing reader has failed; the values it and
+    // every later read returned are padding. Always false for throwing
+    // readers, which throw instead.
+    bool failed() const {
+        return failure != ReadError::NONE;
+    }
+
+    ReadError error() const {
+        return failure;
+    }
+
+    // Returns a reader over the next num_bits and advances past them. The view
+    // borrows the same bytes as this reader and is subject to the same lifetime.
+    BasicBitReader read_view(size_t num_bits) {
+        if (!check_remaining(num_bits)) {
+            return {};
+        }
+        size_t first = position();
+        size_t last = first + num_bits;
+        size_t first_byte = first / 8;
+        size_t end_byte = (last + 7) / 8;
+        seek_to(last);
+        return BasicBitReader(data.subspan(first_byte, end_byte - first_byte), first % 8, num_bits);
     }
 
     bool read_bool() {
@@ -26,38 +295,33 @@ public:
     }
 
     int read_bit() {
-        if (bit_offset >= static_cast<int>(data.size()) * 8) {
-            throw std::out_of_range("Attempting to read beyond the buffer limit.");
-        }
-        int byte_index = bit_offset / 8;
-        int bit_in_byte = bit_offset % 8;
-        int bit_value = (std::to_integer<int>(data[byte_index]) >> bit_in_byte) & 1;
-        ++bit_offset;
+        ensure_bits(1);
+        int bit_value = static_cast<int>(cache & 1);
+        cache >>= 1;
+        --cache_bits;
         return bit_value;
     }
 
     uint32_t read_bits(int num_bits) {
-        if (num_bits > 32) throw std::invalid_argument("Bit count exceeds 32");
-        uint32_t result = 0;
-        for (int i = 0; i < num_bits; ++i) {
-            result |= (read_bit() << i);
+        if (!check_bit_count(num_bits, 0, "Bit count exceeds 32")) {
+            return 0;
         }
+        uint32_t result = take_bits(num_bits);
+        cache >>= num_bits;
+        cache_bits -= num_bits;
         return result;
     }
 
     uint32_t peek_bits(int num_bits) {
-        if (num_bits > 32) throw std::invalid_argument("Bit count exceeds 32");
-
-        int saved_bit_offset = bit_offset;
-        uint32_t result = read_bits(num_bits);
-        bit_offset = saved_bit_offset;
-
-        return result;
+        if (!check_bit_count(num_bits, 0, "Bit count exceeds 32")) {
+            return 0;
+        }
+        return take_bits(num_bits);
     }
 
     std::vector<bool> read_bit_array(size_t num_bits) {
         std::vector<bool> bit_array;
-        bit_array.reserve(num_bits);
+        bit_array.reserve(std::min<size_t>(num_bits, bits_left()));
 
         for (size_t i = 0; i < num_bits; ++i) {
             bit_array.push_back(read_bit());
@@ -67,17 +331,16 @@ public:
     }
 
     std::vector<std::byte> read_many_bits(size_t num_bits) {
-        std::vector<std::byte> result;
+        if (!check_remaining(num_bits)) {
+            return {};
+        }
         size_t num_full_bytes = num_bits / 8;
         size_t remaining_bits = num_bits % 8;
 
-        for (size_t i = 0; i < num_full_bytes; ++i) {
-            uint32_t byte = read_bits(8);
-            result.push_back(static_cast<std::byte>(byte));
-        }
+        std::vector<std::byte> result(num_full_bytes + (remaining_bits > 0 ? 1 : 0));
+        copy_bytes(result.data(), num_full_bytes);
         if (remaining_bits > 0) {
-            uint32_t last_partial_byte = read_bits(remaining_bits);
-            result.push_back(static_cast<std::byte>(last_partial_byte));
+            result.back() = static_cast<std::byte>(read_bits(static_cast<int>(remaining_bits)));
         }
 
         return result;
@@ -85,9 +348,11 @@ public:
 
 
     int read_signed_bits(int num_bits) {
-        if (num_bits == 0 || num_bits > 32) throw std::invalid_argument("Bit count out of range");
+        if (!check_bit_count(num_bits, 1, "Bit count out of range")) {
+            return 0;
+        }
         int shift = 32 - num_bits;
-        return (read_bits(num_bits) << shift) >> shift; // sign extend
+        return static_cast<int32_t>(read_bits(num_bits) << shift) >> shift; // sign extend
     }
 
     std::byte read_byte() {
@@ -95,25 +360,82 @@ public:
     }
 
     std::vector<std::byte> read_bytes(size_t count) {
-        std::vector<std::byte> bytes;
-        bytes.reserve(count);
-        for (size_t i = 0; i < count; ++i) {
-            bytes.push_back(read_byte());
+        if (!check_remaining(count * 8)) {
+            return {};
         }
+        std::vector<std::byte> bytes(count);
+        copy_bytes(bytes.data(), count);
         return bytes;
     }
 
     std::string read_ascii_string(int limit = 0) {
         std::string result;
-        while (limit == 0 || result.size() < limit) {
+        read_ascii_string(result, limit);
+        return result;
+    }
+
+    // Reads into an existing string, reusing its capacity and allocator.
+    template <typename String>
+        requires requires(String& s) { s.push_back('\0'); }
+    void read_ascii_string(String& result, int limit = 0) {
+        result.clear();
+        size_t current = position();
+        if (current % 8 == 0) {
+            // Aligned strings can be located in place; only the copy remains.
+            const char* start = reinterpret_cast<const char*>(data.data() + current / 8);
+            size_t available = (end_bit - current) / 8;
+            size_t max_length = (limit == 0) ? available : std::min<size_t>(available, limit);
+            const void* terminator = std::memchr(start, '\0', max_length);
+            if (terminator || max_length < available) {
+                size_t length = terminator ? static_cast<const char*>(terminator) - start : max_length;
+                result.assign(start, length);
+                seek_to(current + (length + (terminator ? 1 : 0)) * 8);
+                return;
+            }
+        }
+
+        while (limit == 0 || result.size() < static_cast<size_t>(limit)) {
             char val = static_cast<char>(read_bits(8));
             if (val == '\0') {
                 break;
             }
-            result += val;
+            result.push_back(val);
         }
+    }
 
-        return result;
+    // Advances past a string without copying it; consumes exactly what
+    // read_ascii_string(limit) would.
+    void skip_ascii_string(int limit = 0) {
+        size_t current = position();
+        if (current % 8 == 0) {
+            const char* start = reinterpret_cast<const char*>(data.data() + current / 8);
+            size_t available = (end_bit - current) / 8;
+            size_t max_length = (limit == 0) ? available : std::min<size_t>(available, limit);
+            const void* terminator = std::memchr(start, '\0', max_length);
+            if (terminator || max_length < available) {
+                size_t length = terminator ? static_cast<const char*>(terminator) - start + 1 : max_length;
+                seek_to(current + length * 8);
+                return;
+            }
+        }
+
+        for (int count = 0; limit == 0 || count < limit; ++count) {
+            if (read_bits(8) == 0) {
+                break;
+            }
+        }
+    }
+
+    void skip_bits(size_t num_bits) {
+        if (num_bits <= static_cast<size_t>(cache_bits)) {
+            // num_bits can be 64 here, which a single shift would not handle.
+            cache = num_bits < 64 ? cache >> num_bits : 0;
+            cache_bits -= static_cast<int>(num_bits);
+            return;
+        }
+        if (check_remaining(num_bits)) {
+            seek_to(position() + num_bits);
+        }
     }
 
     int8_t read_int8() {
@@ -152,8 +474,8 @@ public:
     }
 
     float read_bit_angle(int numbits) {
-        if (numbits <= 0 || numbits > 32) {
-            throw std::invalid_argument("Invalid bit count for read_bit_angle");
+        if (!check_bit_count(numbits, 1, "Invalid bit count for read_bit_angle")) {
+            return 0.0f;
         }
         float shift = std::pow(2.0f, static_cast<float>(numbits));
         uint32_t i = read_bits(numbits);
@@ -198,6 +520,59 @@ public:
         return value;
     }
 
+    float read_bit_coord_mp(bool integral, bool low_precision) {
+        int intval = 0, fractval = 0, signbit = 0;
+        float value = 0.0;
+
+        bool in_bounds = read_bit() != 0;
+        if (integral) {
+            intval = read_bit();
+            if (intval) {
+                signbit = read_bit();
+                value = static_cast<float>(read_bits(in_bounds ? COORD_INTEGER_BITS_MP : COORD_INTEGER_BITS) + 1);
+            }
+        }
+        else {
+            intval = read_bit();
+            signbit = read_bit();
+            if (intval) {
+                intval = read_bits(in_bounds ? COORD_INTEGER_BITS_MP : COORD_INTEGER_BITS) + 1;
+            }
+            fractval = read_bits(low_precision ? COORD_FRACTIONAL_BITS_MP_LOWPRECISION : COORD_FRACTIONAL_BITS);
+            value = intval + static_cast<float>(fractval * (low_precision ? COORD_RESOLUTION_LOWPRECISION : COORD_RESOLUTION));
+        }
+        if (signbit) value = -value;
+
+        return value;
+    }
+
+    float read_bit_normal() {
+        int signbit = read_bit();
+        uint32_t fractval = read_bits(NORMAL_FRACTIONAL_BITS);
+        float value = static_cast<float>(fractval * NORMAL_RESOLUTION);
+        if (signbit) value = -value;
+
+        return value;
+    }
+
+    // The engine's ReadUBitVar: four low bits, then a 2-bit selector for how
+    // many more follow (0, 4, 8 or 28).
+    uint32_t read_ubit_var() {
+        uint32_t ret = read_bits(6);
+        switch (ret & (16 | 32)) {
+        case 16:
+            ret = (ret & 15) | (read_bits(4) << 4);
+            break;
+        case 32:
+            ret = (ret & 15) | (read_bits(8) << 4);
+            break;
+        case 48:
+            ret = (ret & 15) | (read_bits(32 - 4) << 4);
+            break;
+        }
+        return ret;
+    }
+
     uint32_t read_var_int32() {
         uint32_t result = 0;
         int count = 0;
@@ -205,7 +580,13 @@ public:
 
         do {
             if (count == 5) {
-                throw std::runtime_error("VarInt32 too long");
+                if constexpr (Policy::throws) {
+                    throw std::runtime_error("VarInt32 too long");
+                }
+                else {
+                    fail(ReadError::BAD_VAR_INT);
+                    return 0;
+                }
             }
             b = read_bits(8);
             result |= (b & 0x7F) << (7 * count); 
@@ -216,17 +597,28 @@ public:
     }
 
     void seek(int position) {
-        if (position > static_cast<int>(data.size()) * 8) {
-            throw std::out_of_range("Seek position is beyond the buffer limit.");
+        if (position < 0 || static_cast<size_t>(position) > end_bit - begin_bit) {
+            if constexpr (Policy::throws) {
+                throw std::out_of_range("Seek position is beyond the buffer limit.");
+            }
+            else {
+                seek_to(end_bit);
+                fail(ReadError::PAST_END);
+                return;
+            }
         }
-        bit_offset = position;
+        seek_to(begin_bit + position);
     }
 
     int tell() const {
-        return bit_offset;
+        return static_cast<int>(position() - begin_bit);
     }
 
     void reset() {
-        bit_offset = 0;
+        seek(0);
     }
 };
+
+using BitReader = BasicBitReader<CheckedReads>;
+using NothrowBitReader = BasicBitReader<NothrowReads>;
+using UncheckedBitReader = BasicBitReader<UncheckedReads>;
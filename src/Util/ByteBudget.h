@@ -0,0 +1,35 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+// Caps how many bytes are in use at once across threads. acquire() blocks
+// until the request fits; a request larger than the whole budget is clamped
+// to it, so an oversized job still runs, just alone.
+class ByteBudget {
+    std::mutex mutex;
+    std::condition_variable released;
+    size_t limit;
+    size_t in_use = 0;
+
+public:
+    explicit ByteBudget(size_t limit) : limit(std::max<size_t>(limit, 1)) {}
+
+    // Returns the amount actually taken; hand exactly that back to release().
+    size_t acquire(size_t bytes) {
+        bytes = std::min(bytes, limit);
+        std::unique_lock lock(mutex);
+        released.wait(lock, [&] { return in_use + bytes <= limit; });
+        in_use += bytes;
+        return bytes;
+    }
+
+    void release(size_t bytes) {
+        {
+            std::lock_guard lock(mutex);
+            in_use -= bytes;
+        }
+        released.notify_all();
+    }
+};
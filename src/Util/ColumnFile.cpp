@@ -0,0 +1,314 @@
+#include "Util/ColumnFile.h"
+#include "Util/BinaryReader.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace column_file {
+
+namespace {
+
+constexpr char MAGIC[8] = { 'D', 'E', 'M', 'O', 'C', 'O', 'L', 'S' };
+constexpr uint32_t VERSION = 1;
+constexpr size_t CHUNK_ALIGNMENT = 8;
+// Magic and version at the start, footer offset and magic at the end.
+constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+constexpr size_t TRAILER_SIZE = sizeof(uint64_t) + sizeof(MAGIC);
+
+template <typename T>
+std::span<const T> as_span(std::span<const std::byte> bytes) {
+    return { reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T) };
+}
+
+}
+
+void TableWriter::put(size_t column, std::string_view value) {
+    auto& column_values = values[column];
+    if (specs[column].encoding == Encoding::PLAIN) {
+        column_values.bytes.append(value);
+        column_values.offsets.push_back(static_cast<uint32_t>(column_values.bytes.size()));
+        return;
+    }
+    auto [entry, added] = column_values.dictionary.try_emplace(std::string(value),
+        static_cast<uint32_t>(column_values.dictionary.size()));
+    if (added) {
+        column_values.dictionary_bytes.append(value);
+        column_values.dictionary_offsets.push_back(static_cast<uint32_t>(column_values.dictionary_bytes.size()));
+    }
+    column_values.codes.push_back(entry->second);
+}
+
+void TableWriter::end_row() {
+    group_rows++;
+    for (size_t i = 0; i < specs.size(); i++) {
+        if (values[i].size(specs[i].type, specs[i].encoding) != group_rows) {
+            throw std::logic_error("Row of table " + name + " has no single value for " + specs[i].name);
+        }
+    }
+    total_rows++;
+    if (group_rows == writer.row_group_rows) {
+        flush();
+    }
+}
+
+size_t TableWriter::Values::size(Type type, Encoding encoding) const {
+    switch (type) {
+    case Type::INT32:
+        return ints.size();
+    case Type::FLOAT32:
+        return floats.size();
+    case Type::STRING:
+        return encoding == Encoding::PLAIN ? offsets.size() - 1 : codes.size();
+    }
+    return 0;
+}
+
+void TableWriter::Values::clear() {
+    ints.clear();
+    floats.clear();
+    offsets.assign(1, 0);
+    bytes.clear();
+    codes.clear();
+    dictionary.clear();
+    dictionary_offsets.assign(1, 0);
+    dictionary_bytes.clear();
+}
+
+TableWriter::TableWriter(Writer& writer, std::string name, std::vector<ColumnSpec> specs)
+    : writer(writer), name(std::move(name)), specs(std::move(specs)), values(this->specs.size()) {}
+
+void TableWriter::flush() {
+    if (group_rows == 0) {
+        return;
+    }
+    auto& group = row_groups.emplace_back();
+    group.rows = group_rows;
+    for (size_t i = 0; i < specs.size(); i++) {
+        auto& column_values = values[i];
+        writer.align(CHUNK_ALIGNMENT);
+        auto start = writer.offset;
+        switch (specs[i].type) {
+        case Type::INT32:
+            writer.write(column_values.ints.data(), column_values.ints.size() * sizeof(int32_t));
+            break;
+        case Type::FLOAT32:
+            writer.write(column_values.floats.data(), column_values.floats.size() * sizeof(float));
+            break;
+        case Type::STRING:
+            if (specs[i].encoding == Encoding::PLAIN) {
+                writer.write(column_values.offsets.data(), column_values.offsets.size() * sizeof(uint32_t));
+                writer.write(column_values.bytes.data(), column_values.bytes.size());
+            }
+            else {
+                writer.write_value(static_cast<uint32_t>(column_values.dictionary.size()));
+                writer.write(column_values.dictionary_offsets.data(), column_values.dictionary_offsets.size() * sizeof(uint32_t));
+                writer.write(column_values.dictionary_bytes.data(), column_values.dictionary_bytes.size());
+                writer.align(sizeof(uint32_t));
+                writer.write(column_values.codes.data(), column_values.codes.size() * sizeof(uint32_t));
+            }
+            break;
+        }
+        group.chunks.emplace_back(start, writer.offset - start);
+        column_values.clear();
+    }
+    group_rows = 0;
+}
+
+void Writer::open(const std::string& path) {
+    tables.clear();
+    offset = 0;
+    out.open(path);
+    write(MAGIC, sizeof(MAGIC));
+    write_value(VERSION);
+    write_value(uint32_t{ 0 });
+}
+
+TableWriter& Writer::add_table(std::string name, std::vector<ColumnSpec> columns) {
+    if (find_table(name)) {
+        throw std::invalid_argument("Duplicate table " + name);
+    }
+    tables.push_back(std::unique_ptr<TableWriter>(new TableWriter(*this, std::move(name), std::move(columns))));
+    return *tables.back();
+}
+
+TableWriter* Writer::find_table(std::string_view name) {
+    for (auto& table : tables) {
+        if (table->name == name) {
+            return table.get();
+        }
+    }
+    return nullptr;
+}
+
+void Writer::close() {
+    if (!out.is_open()) {
+        return;
+    }
+    for (auto& table : tables) {
+        table->flush();
+    }
+
+    align(CHUNK_ALIGNMENT);
+    uint64_t footer = offset;
+    write_value(static_cast<uint32_t>(tables.size()));
+    for (const auto& table : tables) {
+        write_string(table->name);
+        write_value(static_cast<uint32_t>(table->specs.size()));
+        for (const auto& spec : table->specs) {
+            write_string(spec.name);
+            write_value(static_cast<uint8_t>(spec.type));
+            write_value(static_cast<uint8_t>(spec.type == Type::STRING ? spec.encoding : Encoding::PLAIN));
+        }
+        write_value(static_cast<uint32_t>(table->row_groups.size()));
+        for (const auto& group : table->row_groups) {
+            write_value(group.rows);
+            for (auto [chunk_offset, chunk_size] : group.chunks) {
+                write_value(chunk_offset);
+                write_value(chunk_size);
+            }
+        }
+    }
+    write_value(footer);
+    write(MAGIC, sizeof(MAGIC));
+    tables.clear();
+    out.close();
+}
+
+void Writer::write(const void* data, size_t size) {
+    out.put(std::string_view(static_cast<const char*>(data), size));
+    offset += size;
+}
+
+void Writer::write_string(std::string_view text) {
+    write_value(static_cast<uint32_t>(text.size()));
+    write(text.data(), text.size());
+}
+
+void Writer::align(size_t alignment) {
+    static constexpr char zeros[CHUNK_ALIGNMENT] = {};
+    write(zeros, (alignment - offset % alignment) % alignment);
+}
+
+int Reader::Table::find(std::string_view column) const {
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].name == column) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+Reader::Reader(const std::string& path) : file(path) {
+    auto bytes = file.bytes();
+    if (bytes.size() < HEADER_SIZE + TRAILER_SIZE || std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC)) != 0
+        || std::memcmp(bytes.data() + bytes.size() - sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a column file: " + path);
+    }
+
+    BinaryReader reader(bytes);
+    reader.seek(sizeof(MAGIC));
+    if (reader.read_uint32() != VERSION) {
+        throw std::runtime_error("Unsupported column file version: " + path);
+    }
+    reader.seek(bytes.size() - TRAILER_SIZE);
+    auto footer = reader.read_uint64();
+    if (footer < HEADER_SIZE || footer > bytes.size() - TRAILER_SIZE) {
+        throw std::runtime_error("Corrupt column file footer: " + path);
+    }
+
+    reader.seek(static_cast<std::streamoff>(footer));
+    all_tables.resize(reader.read_uint32());
+    for (auto& table : all_tables) {
+        table.name = reader.read_string(reader.read_uint32());
+        table.columns.resize(reader.read_uint32());
+        for (auto& column : table.columns) {
+            column.name = reader.read_string(reader.read_uint32());
+            column.type = static_cast<Type>(reader.read_byte());
+            column.encoding = static_cast<Encoding>(reader.read_byte());
+        }
+        table.row_groups.resize(reader.read_uint32());
+        for (auto& group : table.row_groups) {
+            group.rows = reader.read_uint32();
+            table.rows += group.rows;
+            for (size_t i = 0; i < table.columns.size(); i++) {
+                auto chunk_offset = reader.read_uint64();
+                auto chunk_size = reader.read_uint64();
+                if (chunk_offset > footer || chunk_size > footer - chunk_offset) {
+                    throw std::runtime_error("Column chunk out of range in " + path);
+                }
+                group.chunks.push_back(bytes.subspan(chunk_offset, chunk_size));
+            }
+        }
+    }
+}
+
+const Reader::Table* Reader::find(std::string_view table) const {
+    for (const auto& candidate : all_tables) {
+        if (candidate.name == table) {
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
+
+std::span<const int32_t> Reader::ints(const Table& table, size_t row_group, size_t column) const {
+    if (table.columns.at(column).type != Type::INT32) {
+        throw std::out_of_range("Column is not INT32: " + table.columns[column].name);
+    }
+    return as_span<int32_t>(table.row_groups.at(row_group).chunks[column]);
+}
+
+std::span<const float> Reader::floats(const Table& table, size_t row_group, size_t column) const {
+    if (table.columns.at(column).type != Type::FLOAT32) {
+        throw std::out_of_range("Column is not FLOAT32: " + table.columns[column].name);
+    }
+    return as_span<float>(table.row_groups.at(row_group).chunks[column]);
+}
+
+std::string_view Reader::string(const Table& table, size_t row_group, size_t column, size_t row) const {
+    const auto& spec = table.columns.at(column);
+    if (spec.type != Type::STRING) {
+        throw std::out_of_range("Column is not STRING: " + spec.name);
+    }
+    const auto& group = table.row_groups.at(row_group);
+    auto chunk = group.chunks[column];
+    if (row >= group.rows) {
+        throw std::out_of_range("Row out of range in column " + spec.name);
+    }
+
+    auto words = as_span<uint32_t>(chunk);
+    auto corrupt = [&] { return std::runtime_error("Corrupt string column " + spec.name); };
+    auto text = [&](std::span<const uint32_t> offsets, size_t base, size_t index) {
+        auto begin = offsets[index];
+        auto end = offsets[index + 1];
+        if (begin > end || base + end > chunk.size()) {
+            throw corrupt();
+        }
+        return std::string_view(reinterpret_cast<const char*>(chunk.data()) + base + begin, end - begin);
+    };
+
+
+    if (spec.encoding == Encoding::PLAIN) {
+        if (words.size() < size_t{ group.rows } + 1) {
+            throw corrupt();
+        }
+        auto offsets = words.first(group.rows + 1);
+        return text(offsets, offsets.size_bytes(), row);
+    }
+    if (words.empty() || words.size() < size_t{ words[0] } + 2) {
+        throw corrupt();
+    }
+    uint32_t entries = words[0];
+    auto offsets = words.subspan(1, entries + 1);
+    size_t base = (1 + offsets.size()) * sizeof(uint32_t);
+    size_t codes_start = (base + offsets.back() + 3) / 4;
+    if (codes_start + group.rows > words.size()) {
+        throw corrupt();
+    }
+    auto code = words[codes_start + row];
+    if (code >= entries) {
+        throw corrupt();
+    }
+    return text(offsets, base, code);
+}
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include "Util/MappedFile.h"
+#include "Util/OutputBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A self-describing columnar file that readers can memory map and use in
+// place. Layout, all little endian:
+//
+//     "DEMOCOLS" u32 version u32 0
+//     column chunks, each starting at a multiple of 8 bytes
+//     footer
+//     u64 footer offset, "DEMOCOLS"
+//
+// The footer lists the tables. A table has named, typed columns and is split
+// into row groups of at most a fixed number of rows; every row group holds
+// one chunk per column. Chunks are
+//
+//     INT32, FLOAT32      rows values
+//     STRING, PLAIN       u32 offsets[rows + 1], then the bytes
+//     STRING, DICTIONARY  u32 entries, u32 offsets[entries + 1], the bytes
+//                         padded to 4, then u32 codes[rows]
+//
+// so a column of a row group is one aligned array, and dictionaries are local
+// to their row group.
+namespace column_file {
+
+enum class Type : uint8_t { INT32, FLOAT32, STRING };
+enum class Encoding : uint8_t { PLAIN, DICTIONARY };
+
+struct ColumnSpec {
+    std::string name;
+    Type type;
+    // Only for STRING columns.
+    Encoding encoding = Encoding::PLAIN;
+};
+
+class Writer;
+
+// Rows of one table, buffered until a row group is full.
+class TableWriter {
+public:
+    // Values of the current row, one per column in column order.
+    void put(size_t column, int32_t value) { values[column].ints.push_back(value); }
+    void put(size_t column, float value) { values[column].floats.push_back(value); }
+    void put(size_t column, std::string_view value);
+    // Completes the current row. Throws std::logic_error unless every column
+    // received exactly one value.
+    void end_row();
+
+    const std::vector<ColumnSpec>& columns() const { return specs; }
+    uint64_t rows() const { return total_rows; }
+
+private:
+    friend class Writer;
+
+    struct Values {
+        std::vector<int32_t> ints;
+        std::vector<float> floats;
+        // PLAIN strings: offsets and bytes as they are written.
+        std::vector<uint32_t> offsets{ 0 };
+        std::string bytes;
+        // DICTIONARY strings: codes into the row group's dictionary.
+        std::vector<uint32_t> codes;
+        std::unordered_map<std::string, uint32_t> dictionary;
+        std::vector<uint32_t> dictionary_offsets{ 0 };
+        std::string dictionary_bytes;
+
+        size_t size(Type type, Encoding encoding) const;
+        void clear();
+    };
+    struct RowGroup {
+        uint32_t rows;
+        // Per column: offset and size of its chunk.
+        std::vector<std::pair<uint64_t, uint64_t>> chunks;
+    };
+
+    TableWriter(Writer& writer, std::string name, std::vector<ColumnSpec> specs);
+
+    Writer& writer;
+    std::string name;
+    std::vector<ColumnSpec> specs;
+    std::vector<Values> values;
+    std::vector<RowGroup> row_groups;
+    uint32_t group_rows = 0;
+    uint64_t total_rows = 0;
+
+    void flush();
+};
+
+class Writer {
+public:
+    static constexpr uint32_t DEFAULT_ROW_GROUP_ROWS = 65536;
+
+    explicit Writer(uint32_t row_group_rows = DEFAULT_ROW_GROUP_ROWS) : row_group_rows(row_group_rows) {}
+
+    // Throws std::runtime_error if path cannot be created.
+    void open(const std::string& path);
+    // Adds a table. Tables can be added at any point before close(); the
+    // returned writer stays valid until then. Throws std::invalid_argument if
+    // the name is taken.
+    TableWriter& add_table(std::string name, std::vector<ColumnSpec> columns);
+    TableWriter* find_table(std::string_view name);
+    // Writes the remaining row groups and the footer. Throws
+    // std::runtime_error if writing failed.
+    void close();
+
+private:
+    friend class TableWriter;
+
+    uint32_t row_group_rows;
+    OutputBuffer out;
+    uint64_t offset = 0;
+    std::vector<std::unique_ptr<TableWriter>> tables;
+
+    void write(const void* data, size_t size);
+    template <typename T>
+    void write_value(const T& value) { write(&value, sizeof(T)); }
+    void write_string(std::string_view text);
+    void align(size_t alignment);
+};
+
+// A column file mapped for reading. Spans and string views point into the
+// mapping and stay valid while the Reader lives.
+class Reader {
+public:
+    struct Column {
+        std::string name;
+        Type type;
+        Encoding encoding;
+    };
+    struct RowGroup {
+        uint32_t rows;
+        std::vector<std::span<const std::byte>> chunks;
+    };
+    struct Table {
+        std::string name;
+        std::vector<Column> columns;
+        std::vector<RowGroup> row_groups;
+        uint64_t rows = 0;
+
+        // Index of a column, or -1.
+        int find(std::string_view column) const;
+    };
+
+    // Throws std::runtime_error if path is not a readable column file.
+    explicit Reader(const std::string& path);
+
+    const std::vector<Table>& tables() const { return all_tables; }
+    const Table* find(std::string_view table) const;
+
+    // Values of a numeric column in one row group. Throw std::out_of_range on
+    // a type mismatch.
+    std::span<const int32_t> ints(const Table& table, size_t row_group, size_t column) const;
+    std::span<const float> floats(const Table& table, size_t row_group, size_t column) const;
+    // One value of a STRING column, either encoding.
+    std::string_view string(const Table& table, size_t row_group, size_t column, size_t row) const;
+
+private:
+    MappedFile file;
+    std::vector<Table> all_tables;
+};
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// A stand-in for C++23's std::expected, with just what the decoders need: a
+// value or the error that prevented it, returned instead of thrown. Build the
+// error case with unexpected(error).
+template <typename E>
+struct Unexpected {
+    E error;
+};
+
+template <typename E>
+Unexpected<std::decay_t<E>> unexpected(E&& error) {
+    return { std::forward<E>(error) };
+}
+
+template <typename T, typename E>
+class Expected {
+    std::variant<T, E> state;
+
+public:
+    Expected(T value) : state(std::in_place_index<0>, std::move(value)) {}
+    Expected(Unexpected<E> error) : state(std::in_place_index<1>, std::move(error.error)) {}
+
+    bool has_value() const { return state.index() == 0; }
+    explicit operator bool() const { return has_value(); }
+
+    T& value() { return *std::get_if<0>(&state); }
+    const T& value() const { return *std::get_if<0>(&state); }
+    T& operator*() { return value(); }
+    const T& operator*() const { return value(); }
+    T* operator->() { return &value(); }
+    const T* operator->() const { return &value(); }
+
+    // Only valid when !has_value().
+    const E& error() const { return *std::get_if<1>(&state); }
+};
+
+template <typename E>
+class Expected<void, E> {
+    bool ok = true;
+    E failure{};
+
+public:
+    Expected() = default;
+    Expected(Unexpected<E> error) : ok(false), failure(std::move(error.error)) {}
+
+    bool has_value() const { return ok; }
+    explicit operator bool() const { return ok; }
+
+    const E& error() const { return failure; }
+};
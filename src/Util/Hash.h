@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+// Fast non-cryptographic 64-bit hash of a byte range, good enough to tell
+// whether a file changed. Four independent lanes of 8-byte words keep the
+// multiplies pipelined, so hashing a mapped demo runs near memory speed.
+inline uint64_t hash64(std::span<const std::byte> bytes) {
+    constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+    auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+    auto round = [&](uint64_t lane, uint64_t word) { return rotl(lane + word * PRIME2, 31) * PRIME1; };
+    auto load = [](const std::byte* p) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    };
+
+    const std::byte* p = bytes.data();
+    size_t left = bytes.size();
+    uint64_t lanes[4] = { PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1 };
+    for (; left >= 32; p += 32, left -= 32) {
+        for (int i = 0; i < 4; i++) {
+            lanes[i] = round(lanes[i], load(p + i * 8));
+        }
+    }
+
+    uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    hash += bytes.size();
+    for (; left >= 8; p += 8, left -= 8) {
+        hash = rotl(hash ^ round(0, load(p)), 27) * PRIME1 + PRIME2;
+    }
+    for (; left > 0; p++, left--) {
+        hash = rotl(hash ^ (std::to_integer<uint64_t>(*p) * PRIME1), 11) * PRIME2;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME1;
+    hash ^= hash >> 32;
+    return hash;
+}
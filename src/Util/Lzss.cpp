@@ -0,0 +1,90 @@
+#include "Util/Lzss.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t LZSS_ID = 'L' | ('Z' << 8) | ('S' << 16) | ('S' << 24);
+constexpr size_t LZSS_HEADER_SIZE = 8;
+constexpr int LZSS_LOOKSHIFT = 4;
+
+uint32_t read_u32(const std::byte* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+}
+
+namespace lzss {
+
+bool is_compressed(std::span<const std::byte> input) {
+    return input.size() >= LZSS_HEADER_SIZE && read_u32(input.data()) == LZSS_ID;
+}
+
+std::vector<std::byte> decompress(std::span<const std::byte> input) {
+    if (!is_compressed(input)) {
+        throw std::runtime_error("Missing LZSS header");
+    }
+    size_t actual_size = read_u32(input.data() + 4);
+    // A reference takes two bytes and a command bit and yields at most 16
+    // bytes, so no payload expands by more than 8 times. A larger declared
+    // size is corrupt and must not size the allocation.
+    if (actual_size > (input.size() - LZSS_HEADER_SIZE) * 8) {
+        throw std::runtime_error("LZSS declared size exceeds what the payload can hold");
+    }
+
+    std::vector<std::byte> output;
+    output.reserve(actual_size);
+    size_t in = LZSS_HEADER_SIZE;
+    auto next = [&]() {
+        if (in >= input.size()) {
+            throw std::runtime_error("LZSS payload truncated");
+        }
+        return static_cast<unsigned>(input[in++]);
+    };
+
+    unsigned command = 0;
+    int command_bits = 0;
+    for (;;) {
+        if (command_bits == 0) {
+            command = next();
+            command_bits = 8;
+        }
+        command_bits--;
+        bool is_reference = command & 1;
+        command >>= 1;
+
+        if (!is_reference) {
+            if (output.size() >= actual_size) {
+                throw std::runtime_error("LZSS output exceeds declared size");
+            }
+            output.push_back(static_cast<std::byte>(next()));
+            continue;
+        }
+
+        unsigned high = next();
+        unsigned low = next();
+        size_t position = (high << LZSS_LOOKSHIFT) | (low >> LZSS_LOOKSHIFT);
+        size_t count = (low & 0x0F) + 1;
+        if (count == 1) {
+            break;
+        }
+        if (position + 1 > output.size() || output.size() + count > actual_size) {
+            throw std::runtime_error("LZSS reference out of range");
+        }
+        // The source may overlap the bytes being written, so copy one at a time.
+        size_t source = output.size() - position - 1;
+        for (size_t i = 0; i < count; i++) {
+            output.push_back(output[source + i]);
+        }
+    }
+
+    if (output.size() != actual_size) {
+        throw std::runtime_error("LZSS output does not match declared size");
+    }
+    return output;
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Source engine LZSS, as used for compressed string tables and packets. The
+// payload starts with the "LZSS" id and the decompressed size.
+namespace lzss {
+
+bool is_compressed(std::span<const std::byte> input);
+
+// Throws std::runtime_error if the header is missing or the payload does not
+// decompress to the size it declares.
+std::vector<std::byte> decompress(std::span<const std::byte> input);
+
+}
@@ -0,0 +1,155 @@
+#include "Util/MappedFile.h"
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr size_t READ_CHUNK = 1 << 20;
+}
+
+MappedFile::MappedFile(const std::string& path) {
+    if (path == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+        read_all(_fileno(stdin));
+#else
+        read_all(STDIN_FILENO);
+#endif
+        return;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+
+    LARGE_INTEGER file_size{};
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &file_size)) {
+        int fd = _open_osfhandle(reinterpret_cast<intptr_t>(file), _O_RDONLY | _O_BINARY);
+        read_all(fd);
+        _close(fd);
+        return;
+    }
+
+    length = static_cast<size_t>(file_size.QuadPart);
+    if (length > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            view = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+        }
+        if (!view) {
+            CloseHandle(file);
+            throw std::runtime_error("Error mapping file: " + path);
+        }
+        mapped = true;
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        try {
+            read_all(fd);
+        }
+        catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        return;
+    }
+
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Error mapping file: " + path);
+        }
+        madvise(address, length, MADV_SEQUENTIAL);
+        view = static_cast<const std::byte*>(address);
+        mapped = true;
+    }
+    ::close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        view = std::exchange(other.view, nullptr);
+        length = std::exchange(other.length, 0);
+        mapped = std::exchange(other.mapped, false);
+        buffer = std::move(other.buffer);
+    }
+    return *this;
+}
+
+void MappedFile::unmap() {
+    if (mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+#else
+        munmap(const_cast<std::byte*>(view), length);
+#endif
+    }
+    view = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
+
+void MappedFile::read_all(int fd) {
+    size_t used = 0;
+    for (;;) {
+        if (buffer.size() - used < READ_CHUNK) {
+            buffer.resize(used + READ_CHUNK);
+        }
+#ifdef _WIN32
+        auto count = _read(fd, buffer.data() + used, static_cast<unsigned>(READ_CHUNK));
+#else
+        auto count = ::read(fd, buffer.data() + used, READ_CHUNK);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (count < 0) {
+            throw std::runtime_error("Error reading input stream.");
+        }
+        if (count == 0) {
+            break;
+        }
+        used += static_cast<size_t>(count);
+    }
+    buffer.resize(used);
+    view = buffer.data();
+    length = used;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole input file. Regular files are memory mapped and
+// hinted for sequential access, so parsing reads straight out of the page
+// cache. Pipes, FIFOs and stdin ("-") cannot be mapped; they are read into an
+// owned buffer with large read() calls instead. Either way bytes() stays valid
+// until the MappedFile is destroyed or moved from.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<const std::byte> bytes() const { return { view, length }; }
+    size_t size() const { return length; }
+    bool is_mapped() const { return mapped; }
+
+private:
+    void unmap();
+    void read_all(int fd);
+
+    const std::byte* view = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<std::byte> buffer;
+};
@@ -0,0 +1,214 @@
+#include "Util/OutputBuffer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <cstdio>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Largest single write; some platforms reject writes of 2 GiB and more.
+constexpr size_t WRITE_CHUNK = size_t(1) << 30;
+
+}
+
+OutputBuffer::OutputBuffer(size_t capacity) : buffer(std::max<size_t>(capacity, 64)) {}
+
+OutputBuffer::~OutputBuffer() {
+    try {
+        close();
+    }
+    catch (const std::exception&) {
+        // Callers that care about write errors close() explicitly.
+    }
+}
+
+void OutputBuffer::open(const std::string& path, bool background_writer) {
+    close();
+    owns_fd = path != "-";
+    if (!owns_fd) {
+#ifdef _WIN32
+        fd = _fileno(stdout);
+        _setmode(fd, _O_BINARY);
+#else
+        fd = STDOUT_FILENO;
+#endif
+    }
+    else {
+#ifdef _WIN32
+        fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    }
+    if (fd < 0) {
+        throw std::runtime_error("Error opening output file: " + path + ": " + std::strerror(errno));
+    }
+    used = 0;
+    writes = 0;
+    error = nullptr;
+    deferred_error = nullptr;
+    if (background_writer) {
+        pending.resize(buffer.size());
+        stopping = false;
+        writer = std::thread([this] { run_writer(); });
+    }
+}
+
+void OutputBuffer::close() {
+    if (fd < 0) {
+        return;
+    }
+    // A deferred error happened first, so it is the one reported.
+    std::exception_ptr failure = std::exchange(deferred_error, nullptr);
+    try {
+        flush();
+    }
+    catch (const std::exception&) {
+        if (!failure) {
+            failure = std::current_exception();
+        }
+    }
+    if (writer.joinable()) {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        writer.join();
+        if (!failure) {
+            failure = error;
+        }
+    }
+    if (owns_fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+    fd = -1;
+    used = 0;
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void OutputBuffer::put_deferred(std::string_view text) noexcept {
+    try {
+        put(text);
+    }
+    catch (...) {
+        if (!deferred_error) {
+            deferred_error = std::current_exception();
+        }
+    }
+}
+
+OutputBuffer& OutputBuffer::put_padded(std::string_view text, size_t width) {
+    put(text);
+    for (size_t i = text.size(); i < width; i++) {
+        put(' ');
+    }
+    return *this;
+}
+
+void OutputBuffer::flush() {
+    if (used == 0 || fd < 0) {
+        used = 0;
+        return;
+    }
+    if (!writer.joinable()) {
+        write_all(buffer.data(), used);
+        used = 0;
+        return;
+    }
+
+    wait_for_writer();
+    {
+        std::lock_guard lock(mutex);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        buffer.swap(pending);
+        pending_size = used;
+    }
+    changed.notify_all();
+    used = 0;
+}
+
+void OutputBuffer::put_large(std::string_view text) {
+    flush();
+    if (text.size() <= buffer.size()) {
+        put(text);
+        return;
+    }
+    // Larger than the whole buffer: write it through.
+    wait_for_writer();
+    write_all(text.data(), text.size());
+}
+
+void OutputBuffer::write_all(const char* data, size_t size) {
+    while (size > 0) {
+        size_t chunk = std::min(size, WRITE_CHUNK);
+#ifdef _WIN32
+        auto written = _write(fd, data, static_cast<unsigned int>(chunk));
+#else
+        auto written = ::write(fd, data, chunk);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Error writing output file: ") + std::strerror(errno));
+        }
+        writes++;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void OutputBuffer::wait_for_writer() {
+    if (!writer.joinable()) {
+        return;
+    }
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [this] { return pending_size == 0; });
+}
+
+void OutputBuffer::run_writer() {
+    std::unique_lock lock(mutex);
+    while (true) {
+        changed.wait(lock, [this] { return pending_size > 0 || stopping; });
+        if (pending_size == 0) {
+            return;
+        }
+        bool failed = error != nullptr;
+        lock.unlock();
+        std::exception_ptr failure;
+        try {
+            if (!failed) {
+                write_all(pending.data(), pending_size);
+            }
+        }
+        catch (const std::exception&) {
+            failure = std::current_exception();
+        }
+        lock.lock();
+        if (failure) {
+            error = failure;
+        }
+        pending_size = 0;
+        changed.notify_all();
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Text output formatted straight into a large buffer and written to the file
+// in a few big writes. Numbers go through std::to_chars, so nothing touches
+// iostreams or locales. With a background writer the full buffer is handed to
+// a second thread and formatting continues in another one while it is
+// written.
+class OutputBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = size_t(4) << 20;
+
+    explicit OutputBuffer(size_t capacity = DEFAULT_CAPACITY);
+    ~OutputBuffer();
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    // Creates or truncates path; "-" writes to stdout, which close() leaves
+    // open. Throws std::runtime_error if path cannot be opened.
+    void open(const std::string& path, bool background_writer = false);
+    // Writes what is left and closes the file. Throws std::runtime_error if
+    // any write failed, including earlier ones of the background writer.
+    void close();
+    bool is_open() const { return fd >= 0; }
+
+    OutputBuffer& put(std::string_view text) {
+        if (text.size() > buffer.size() - used) {
+            put_large(text);
+            return *this;
+        }
+        text.copy(buffer.data() + used, text.size());
+        used += text.size();
+        return *this;
+    }
+
+    OutputBuffer& put(char c) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        buffer[used++] = c;
+        return *this;
+    }
+
+    OutputBuffer& put(const char* text) { return put(std::string_view(text)); }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    OutputBuffer& put(T value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return put(value ? '1' : '0');
+        }
+        else {
+            // Longest to_chars output of a double is 24 characters.
+            constexpr size_t MAX_NUMBER = 32;
+            if (buffer.size() - used < MAX_NUMBER) {
+                flush();
+            }
+            auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+            used = static_cast<size_t>(result.ptr - buffer.data());
+            return *this;
+        }
+    }
+
+    // Like put(), but for destructors: a write error is kept for close() to
+    // report instead of being thrown.
+    void put_deferred(std::string_view text) noexcept;
+
+    // text left aligned in a field of width characters.
+    OutputBuffer& put_padded(std::string_view text, size_t width);
+
+    // Hands the buffered text to the file, or to the writer thread.
+    void flush();
+
+    // write() calls issued so far.
+    size_t writes = 0;
+
+private:
+    std::vector<char> buffer;
+    size_t used = 0;
+    int fd = -1;
+    bool owns_fd = true;
+
+    // Background writer: pending holds the buffer being written while buffer
+    // fills up again.
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<char> pending;
+    size_t pending_size = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+    // First error of put_deferred(), reported by close().
+    std::exception_ptr deferred_error;
+
+    void put_large(std::string_view text);
+    void write_all(const char* data, size_t size);
+    void wait_for_writer();
+    void run_writer();
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include "Util/Arena.h"
+#include <cstring>
+#include <string_view>
+#include <unordered_set>
+
+// Interns strings: every distinct string is stored once and handed out as a
+// view that stays valid for the lifetime of the pool, so equal strings can be
+// compared by pointer and repeated names cost no extra memory.
+class StringPool {
+    Arena storage{ 64 * 1024 };
+    std::unordered_set<std::string_view> index;
+
+public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    std::string_view intern(std::string_view text) {
+        auto found = index.find(text);
+        if (found != index.end()) {
+            return *found;
+        }
+        auto* chars = static_cast<char*>(storage.memory()->allocate(text.size() + 1, 1));
+        std::memcpy(chars, text.data(), text.size());
+        chars[text.size()] = '\0';
+        return *index.emplace(chars, text.size()).first;
+    }
+
+    size_t size() const {
+        return index.size();
+    }
+};
@@ -0,0 +1,115 @@
+#include "Util/ThreadPool.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+// Pool and deque of the worker running on this thread, if any.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this, i] { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock lock(mutex);
+        all_done.wait(lock, [this] { return pending == 0; });
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t target = current_pool == this ? current_queue : next_queue++ % queues.size();
+    {
+        std::lock_guard lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock(mutex);
+        queued++;
+        pending++;
+    }
+    work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(mutex);
+    all_done.wait(lock, [this] { return pending == 0; });
+    if (error) {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+}
+
+bool ThreadPool::pop(size_t self, std::function<void()>& task) {
+    {
+        auto& own = *queues[self];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        auto& victim = *queues[(self + offset) % queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t self) {
+    current_pool = this;
+    current_queue = self;
+
+    std::function<void()> task;
+    for (;;) {
+        {
+            std::unique_lock lock(mutex);
+            work_available.wait(lock, [this] { return queued > 0 || stopping; });
+            if (queued == 0) {
+                return;
+            }
+            // Claim one task. Every task is in a deque before it is counted,
+            // so a claimed task is always there to be popped.
+            queued--;
+        }
+        while (!pop(self, task)) {
+            std::this_thread::yield();
+        }
+
+        try {
+            task();
+        }
+        catch (...) {
+            std::lock_guard lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        task = nullptr;
+
+        std::lock_guard lock(mutex);
+        if (--pending == 0) {
+            all_done.notify_all();
+        }
+    }
+}
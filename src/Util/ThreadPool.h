@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task deque each. A worker takes its
+// own newest task first and, once its deque is empty, steals the oldest task
+// of another worker, so uneven jobs (a 5 minute demo next to a 60 minute one)
+// keep every core busy without a single shared queue to contend on.
+class ThreadPool {
+public:
+    // threads == 0 means one worker per hardware thread.
+    explicit ThreadPool(size_t threads = 0);
+    // Finishes every submitted task, then joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // Queues a task. Tasks submitted from a worker go to that worker's deque.
+    void submit(std::function<void()> task);
+    // Blocks until every task submitted so far has finished, then rethrows the
+    // first exception a task let escape, if any. Must not be called from a
+    // worker.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool pop(size_t self, std::function<void()>& task);
+    void run(size_t self);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next_queue{ 0 };
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    size_t queued = 0;   // submitted but not yet picked up
+    size_t pending = 0;  // submitted but not yet finished
+    bool stopping = false;
+    std::exception_ptr error;
+};
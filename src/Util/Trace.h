@@ -0,0 +1,86 @@
+#pragma once
+#include <iostream>
+#include <ostream>
+
+// Human-readable trace of everything the parser decodes. Call sites write
+//
+//     if (auto* out = trace::stream()) { *out << ...; }
+//
+// so nothing is formatted unless a sink is installed. Building with
+// DEMO_TRACE=0 turns trace::stream() into a constant nullptr and the
+// compiler drops the tracing code entirely.
+//
+// Recoverable decode errors go to trace::log() instead, which is always on.
+#ifndef DEMO_TRACE
+#define DEMO_TRACE 1
+#endif
+
+class TraceSink {
+public:
+    virtual ~TraceSink() = default;
+    virtual std::ostream& stream() = 0;
+};
+
+class StreamTraceSink : public TraceSink {
+    std::ostream& out;
+
+public:
+    explicit StreamTraceSink(std::ostream& out) : out(out) {}
+    std::ostream& stream() override { return out; }
+};
+
+namespace trace {
+
+// Per thread as well, so each demo of a batch can log to its own file.
+inline thread_local std::ostream* active_log = nullptr;
+
+// Where decode errors are reported; std::cerr unless a Scope installed a log.
+inline std::ostream& log() {
+    return active_log ? *active_log : std::cerr;
+}
+
+#if DEMO_TRACE
+// Sinks are per thread so independent demos can be traced concurrently.
+inline thread_local TraceSink* active_sink = nullptr;
+
+inline std::ostream* stream() {
+    return active_sink ? &active_sink->stream() : nullptr;
+}
+#else
+constexpr std::ostream* stream() {
+    return nullptr;
+}
+#endif
+
+// Installs a sink, and optionally an error log, on the current thread for the
+// lifetime of the scope. A null log keeps the one already installed.
+class Scope {
+    std::ostream* previous_log;
+#if DEMO_TRACE
+    TraceSink* previous;
+
+public:
+    explicit Scope(TraceSink* sink, std::ostream* log = nullptr) : previous_log(active_log), previous(active_sink) {
+        active_sink = sink;
+        if (log) {
+            active_log = log;
+        }
+    }
+    ~Scope() {
+        active_sink = previous;
+        active_log = previous_log;
+    }
+#else
+public:
+    explicit Scope(TraceSink*, std::ostream* log = nullptr) : previous_log(active_log) {
+        if (log) {
+            active_log = log;
+        }
+    }
+    ~Scope() { active_log = previous_log; }
+#endif
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+}
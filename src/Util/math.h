@@ -1,9 +1,12 @@
 #pragma once
 
-int Q_log2(int val)
+// Negative values come from corrupt input; they are taken as unsigned so the
+// loop still ends.
+inline int Q_log2(int val)
 {
 	int answer = 0;
-	while (val >>= 1)
+	unsigned int bits = static_cast<unsigned int>(val);
+	while (bits >>= 1)
 		answer++;
 	return answer;
 }
\ No newline at end of file
@@ -1,66 +1,167 @@
+#include "Batch.h"
 #include "Demo/Demo.h"
-#include "Dumper.h"
-#include "Util/BitReader.h"
+#include "Demo/ParseStats.h"
+#include "Exporter.h"
+#include "NdjsonWriter.h"
+#include "Util/ThreadPool.h"
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <string>
-#include <fstream>
+#include <vector>
 
-class StreamRedirect {
-public:
-    StreamRedirect(const std::string& output_path) {
-        file_stream.open(output_path);
+void print_usage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [-v|--verbose] [-j|--jobs <threads>] [--memory-mb <MiB>] [--stats] <demo_file_path>...\n"
+        << "       " << program << " --columns <output_path> [--entity-class <name>]... [--stats] <demo_file_path>\n"
+        << "       " << program << " --ndjson <output_path|-> [--records <name,...>] [--fields <name,...>] [--stats] <demo_file_path>\n"
+        << "       " << program << " -h|--help\n"
+        << "Inputs may be demo files, directories, globs or @list files. More than one demo runs in batch mode.\n"
+        << "--stats prints the count, size and decode time of each frame and net message type to stderr.\n"
+        << "--columns exports frames, game events and the entities of the given classes to a column file.\n"
+        << "--ndjson writes one JSON object per frame and net message; --records and --fields limit them to the\n"
+        << "given frame types or net message names and fields." << std::endl;
+}
 
-        old_cout = std::cout.rdbuf(file_stream.rdbuf());
-        old_cerr = std::cerr.rdbuf(file_stream.rdbuf());
+std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        auto end = std::min(list.find(',', start), list.size());
+        if (end > start) {
+            items.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
     }
+    return items;
+}
 
-    ~StreamRedirect() {
-        std::cout.rdbuf(old_cout);
-        std::cerr.rdbuf(old_cerr);
+int export_columns(const std::string& demo_path, const std::string& output_path, ExportOptions options, ParseStats* stats) {
+    try {
+        Demo demo;
+        demo.stats = stats;
+        Exporter exporter(demo, std::move(options));
+        exporter.run(demo_path, output_path);
+        return 0;
     }
-
-private:
-    std::ofstream file_stream;
-    std::streambuf* old_cout, * old_cerr;
-};
-
-std::string demo_path_to_dump_path(std::string demo_path) {
-    size_t last_period_pos = demo_path.find_last_of('.');
-    if (last_period_pos != std::string::npos && last_period_pos != 0) {
-        demo_path = demo_path.substr(0, last_period_pos);
+    catch (const std::exception& e) {
+        std::cerr << "Failed to export " << demo_path << ": " << e.what() << std::endl;
+        return 1;
     }
-    demo_path += "_dump.txt";
-    return demo_path;
 }
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <demo_file_path>" << std::endl;
+int export_ndjson(const std::string& demo_path, const std::string& output_path, NdjsonOptions options, ParseStats* stats) {
+    try {
+        Demo demo;
+        demo.stats = stats;
+        NdjsonWriter writer(demo, std::move(options));
+        writer.run(demo_path, output_path);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to export " << demo_path << ": " << e.what() << std::endl;
         return 1;
     }
+}
 
-    std::string demo_file_path = argv[1];
-    auto dump_path = demo_path_to_dump_path(demo_file_path);
-    std::string log_path = "log_" + dump_path;
-
-    StreamRedirect redirect(log_path);
+int dump_demos(const std::vector<std::string>& inputs, const BatchOptions& options) {
+    std::error_code error;
+    bool single = inputs.size() == 1 && !inputs[0].empty() && inputs[0].front() != '@' &&
+        (inputs[0] == "-" || std::filesystem::is_regular_file(inputs[0], error));
+    if (single) {
+        // Output of a single demo goes to its log file, as in batch mode. Its
+        // packets are decoded on all cores.
+        ThreadPool pool(options.threads);
+        return dump_demo(inputs[0], options.verbose, &pool, options.stats).ok ? 0 : 1;
+    }
 
-    Demo demo;
+    std::vector<std::string> demo_paths;
     try {
-        demo.load(demo_file_path);
+        demo_paths = expand_demo_inputs(inputs);
     }
     catch (const std::exception& e) {
-        std::cerr << "Failed to parse demo file: " << e.what() << std::endl;
+        std::cerr << e.what() << std::endl;
         return 1;
     }
+    if (demo_paths.empty()) {
+        std::cerr << "No demo files found." << std::endl;
+        return 1;
+    }
+    return run_batch(demo_paths, options, std::cout) == 0 ? 0 : 1;
+}
 
-    
-    Dumper dumper(demo);
-    dumper.open(dump_path);
-    dumper.dump_header();
-    dumper.close();
-
-    std::cout << "Successfully dumped to: " << dump_path << std::endl;
-
-    return 0;
-}
\ No newline at end of file
+int main(int argc, char* argv[]) {
+    BatchOptions options;
+    std::vector<std::string> inputs;
+    std::string columns_path;
+    ExportOptions export_options;
+    std::string ndjson_path;
+    NdjsonOptions ndjson_options;
+    bool print_stats = false;
+    bool help = false;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "-h" || arg == "--help") {
+                help = true;
+            }
+            else if (arg == "-v" || arg == "--verbose") {
+                options.verbose = true;
+            }
+            else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+                options.threads = std::stoul(argv[++i]);
+            }
+            else if (arg == "--stats") {
+                print_stats = true;
+            }
+            else if (arg == "--memory-mb" && i + 1 < argc) {
+                options.memory_budget = std::stoull(argv[++i]) << 20;
+            }
+            else if (arg == "--columns" && i + 1 < argc) {
+                columns_path = argv[++i];
+            }
+            else if (arg == "--entity-class" && i + 1 < argc) {
+                export_options.entity_classes.push_back(argv[++i]);
+            }
+            else if (arg == "--ndjson" && i + 1 < argc) {
+                ndjson_path = argv[++i];
+            }
+            else if (arg == "--records" && i + 1 < argc) {
+                ndjson_options.records = split_list(argv[++i]);
+            }
+            else if (arg == "--fields" && i + 1 < argc) {
+                ndjson_options.fields = split_list(argv[++i]);
+            }
+            else {
+                inputs.push_back(arg);
+            }
+        }
+    }
+    catch (const std::exception&) {
+        inputs.clear();
+    }
+    if (help) {
+        print_usage(std::cout, argv[0]);
+        return 0;
+    }
+    bool exporting = !columns_path.empty() || !ndjson_path.empty();
+    if (inputs.empty() || (exporting && inputs.size() != 1) || (!columns_path.empty() && !ndjson_path.empty())) {
+        print_usage(std::cerr, argv[0]);
+        return 1;
+    }
+    ParseStats stats;
+    options.stats = print_stats ? &stats : nullptr;
+    int status;
+    if (!columns_path.empty()) {
+        status = export_columns(inputs[0], columns_path, std::move(export_options), options.stats);
+    }
+    else if (!ndjson_path.empty()) {
+        status = export_ndjson(inputs[0], ndjson_path, std::move(ndjson_options), options.stats);
+    }
+    else {
+        status = dump_demos(inputs, options);
+    }
+    if (print_stats) {
+        stats.print(std::cerr);
+    }
+    return status;
+}